@@ -0,0 +1,515 @@
+############################################################################
+# The MIT License
+#
+# Copyright (c) 2017 Kyle Ruan
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+############################################################################
+"""
+Python bindings for libslicyl.
+
+    import slicyl
+    mesh = slicyl.Mesh.from_file("part.stl")
+    mesh.center()
+    job = slicyl.Job()
+    job.set_uniform(0.0, 0.2, 40.0)
+    layers = job.slice(mesh)
+    for layer in layers:
+        print(layer.radius, len(layer))
+        segments = layer.segments      # (n, 2, 3) float32, needs NumPy
+
+The bindings go through the C interface in src/slicyl.h with ctypes, so
+nothing has to be compiled for them. ctypes lets go of the GIL for every
+call into the library, so loading and slicing in several Python threads
+run at the same time.
+
+Layers are never copied: the pieces of a layer come back as a read only
+(n, 7) NumPy array over the library's own buffer, which is kept alive for
+as long as any such view is. Without NumPy they come back as a plain
+sequence of rows over the same buffer instead: pieces[i] is a memoryview
+of the seven floats of one piece and pieces[i, j] one float of it, while
+pieces.floats is the flat memoryview, seven floats per piece. It has none
+of NumPy's column slicing, so segments and distances need NumPy.
+
+The library is looked for in $SLICYL_LIBRARY, then in ../src next to this
+file, then wherever the system keeps its libraries.
+"""
+
+import array
+import ctypes
+import ctypes.util
+import os
+
+try:
+    import numpy
+except ImportError:
+    numpy = None
+
+__all__ = ["SlicylError", "Mesh", "Job", "Layers", "Layer", "set_log", "version"]
+
+ABI_VERSION = 1
+
+# Floats in one slicepiece: x y z of both ends, then its distance along the layer
+PIECE_FLOATS = 7
+
+# What slicing returns for a job whose options do not go together
+_ERROR_COMBINATION = -2
+_COMBINATION_MESSAGE = "cones and spheres cannot be used with a region, a sector or adaptive radii"
+
+
+class SlicylError(Exception):
+    """A call into libslicyl failed."""
+
+
+class _Piece(ctypes.Structure):
+    _fields_ = [("a", ctypes.c_float * 3),
+                ("b", ctypes.c_float * 3),
+                ("distance", ctypes.c_float)]
+
+
+_float_p = ctypes.POINTER(ctypes.c_float)
+_size_p = ctypes.POINTER(ctypes.c_size_t)
+_piece_p = ctypes.POINTER(_Piece)
+_LayerCallback = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_size_t, ctypes.c_float, _piece_p, ctypes.c_size_t, ctypes.c_void_p)
+_LogCallback = ctypes.CFUNCTYPE(None, ctypes.c_char_p, ctypes.c_void_p)
+
+# Return type and argument types of every function of the library
+_PROTOTYPES = {
+    "slicyl_version": (ctypes.c_char_p, []),
+    "slicyl_abi_version": (ctypes.c_int, []),
+    "slicyl_set_log": (None, [_LogCallback, ctypes.c_void_p]),
+    "slicyl_mesh_new": (ctypes.c_void_p, []),
+    "slicyl_mesh_free": (None, [ctypes.c_void_p]),
+    "slicyl_mesh_load_file": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_char_p]),
+    "slicyl_mesh_load_memory": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]),
+    "slicyl_mesh_add_triangles": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_size_t]),
+    "slicyl_mesh_size": (ctypes.c_size_t, [ctypes.c_void_p]),
+    "slicyl_mesh_bbox": (None, [ctypes.c_void_p, _float_p, _float_p]),
+    "slicyl_mesh_center": (None, [ctypes.c_void_p]),
+    "slicyl_job_new": (ctypes.c_void_p, []),
+    "slicyl_job_free": (None, [ctypes.c_void_p]),
+    "slicyl_job_set_uniform": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_float, ctypes.c_float, ctypes.c_float]),
+    "slicyl_job_set_adaptive": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_float, ctypes.c_float, ctypes.c_float, ctypes.c_float]),
+    "slicyl_job_set_radii": (ctypes.c_int, [ctypes.c_void_p, _float_p, ctypes.c_size_t]),
+    "slicyl_job_set_seam": (None, [ctypes.c_void_p, ctypes.c_float]),
+    "slicyl_job_set_precision": (None, [ctypes.c_void_p, ctypes.c_int]),
+    "slicyl_job_set_robust": (None, [ctypes.c_void_p, ctypes.c_int]),
+    "slicyl_job_set_cone": (ctypes.c_int, [ctypes.c_void_p, ctypes.c_float]),
+    "slicyl_job_set_sphere": (None, [ctypes.c_void_p, _float_p]),
+    "slicyl_job_set_region": (None, [ctypes.c_void_p, ctypes.c_float, ctypes.c_float]),
+    "slicyl_job_set_sector": (None, [ctypes.c_void_p, ctypes.c_float, ctypes.c_float]),
+    "slicyl_job_get_radii": (ctypes.c_size_t, [ctypes.c_void_p, ctypes.c_void_p, _float_p, ctypes.c_size_t]),
+    "slicyl_job_run": (ctypes.c_long, [ctypes.c_void_p, ctypes.c_void_p, _LayerCallback, ctypes.c_void_p]),
+    "slicyl_job_slice": (ctypes.c_long, [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p]),
+    "slicyl_layers_new": (ctypes.c_void_p, []),
+    "slicyl_layers_free": (None, [ctypes.c_void_p]),
+    "slicyl_layers_count": (ctypes.c_size_t, [ctypes.c_void_p]),
+    "slicyl_layers_get": (_piece_p, [ctypes.c_void_p, ctypes.c_size_t, _size_p, _float_p]),
+}
+
+
+def _load_library():
+    """Finds libslicyl, checks its interface version and sets up its functions."""
+    here = os.path.dirname(os.path.abspath(__file__))
+    names = [os.environ.get("SLICYL_LIBRARY"),
+             os.path.join(here, "..", "src", "libslicyl.so"),
+             ctypes.util.find_library("slicyl")]
+    errors = []
+    for name in names:
+        if not name:
+            continue
+        try:
+            lib = ctypes.CDLL(name)
+            break
+        except OSError as error:
+            errors.append(str(error))
+    else:
+        raise ImportError("libslicyl not found, build it with make in src or set SLICYL_LIBRARY (%s)" % "; ".join(errors))
+
+    for function, (restype, argtypes) in _PROTOTYPES.items():
+        f = getattr(lib, function)
+        f.restype = restype
+        f.argtypes = argtypes
+    if lib.slicyl_abi_version() != ABI_VERSION:
+        raise ImportError("libslicyl interface version %d, these bindings need %d" % (lib.slicyl_abi_version(), ABI_VERSION))
+    return lib
+
+
+_lib = _load_library()
+
+# The log callback has to outlive every call that may use it
+_log_callback = None
+
+
+def version():
+    """Version of the library as text."""
+    return _lib.slicyl_version().decode()
+
+
+def set_log(handler):
+    """
+    Sends the progress and error messages of the library to handler(text),
+    which may be called from the library's worker threads. None drops them.
+    """
+    global _log_callback
+    if handler is None:
+        callback = _LogCallback()
+    else:
+        callback = _LogCallback(lambda message, user: handler(message.decode(errors="replace")))
+    _lib.slicyl_set_log(callback, None)
+    _log_callback = callback
+
+
+def _float_buffer(data):
+    """
+    Gets the address and float count of contiguous float32 data without
+    copying it. Data that is not float32, or read only without NumPy, is
+    converted first; the returned keep-alive object must be held while the
+    address is used.
+    """
+    if numpy is not None:
+        values = numpy.ascontiguousarray(data, dtype=numpy.float32)
+        return values.ctypes.data, values.size, values
+    try:
+        view = memoryview(data)
+    except TypeError:
+        view = memoryview(array.array("f", data))
+    if view.format not in ("f", "<f", "=f") or not view.c_contiguous:
+        raise TypeError("need contiguous float32 data, or a sequence of numbers, without NumPy")
+    count = view.nbytes // 4
+    if view.readonly:
+        keep = (ctypes.c_float * count).from_buffer_copy(view)
+    else:
+        keep = (ctypes.c_float * count).from_buffer(view.cast("B"))
+    return ctypes.addressof(keep), count, keep
+
+
+class _PieceRows(object):
+    """
+    Read only rows of slicepieces over a flat float32 memoryview, for when
+    NumPy is not installed. pieces[i] is one piece as a memoryview of its
+    seven floats and pieces[i, j] one float of it; floats is the flat view.
+    """
+
+    def __init__(self, floats):
+        self.floats = floats
+
+    @property
+    def shape(self):
+        return (len(self), PIECE_FLOATS)
+
+    def __len__(self):
+        return len(self.floats) // PIECE_FLOATS
+
+    def __getitem__(self, key):
+        if isinstance(key, tuple):
+            row, column = key
+            return self[row][column]
+        count = len(self)
+        if isinstance(key, slice):
+            start, stop, step = key.indices(count)
+            if step == 1:
+                return _PieceRows(self.floats[start * PIECE_FLOATS:max(start, stop) * PIECE_FLOATS])
+            return [self[i] for i in range(start, stop, step)]
+        if key < 0:
+            key += count
+        if not 0 <= key < count:
+            raise IndexError("piece index out of range")
+        return self.floats[key * PIECE_FLOATS:(key + 1) * PIECE_FLOATS]
+
+    def __iter__(self):
+        for i in range(len(self)):
+            yield self[i]
+
+
+def _piece_view(address, count, owner):
+    """
+    Wraps count slicepieces at address as an (count, 7) float32 array, or
+    rows over a flat memoryview without NumPy, that keeps owner alive.
+    """
+    if count == 0:
+        if numpy is not None:
+            return numpy.zeros((0, PIECE_FLOATS), dtype=numpy.float32)
+        return _PieceRows(memoryview(b"").cast("f"))
+    buffer = (ctypes.c_float * (count * PIECE_FLOATS)).from_address(address)
+    buffer._owner = owner
+    if numpy is not None:
+        array = numpy.frombuffer(buffer, dtype=numpy.float32).reshape(count, PIECE_FLOATS)
+        array.flags.writeable = False
+        return array
+    return _PieceRows(memoryview(buffer).cast("B").cast("f").toreadonly())
+
+
+class Mesh(object):
+    """A triangle mesh to slice."""
+
+    def __init__(self):
+        self._handle = _lib.slicyl_mesh_new()
+        if not self._handle:
+            raise MemoryError("slicyl_mesh_new")
+
+    @classmethod
+    def from_file(cls, stl_file):
+        """Loads a binary or ASCII STL file."""
+        mesh = cls()
+        mesh.load(stl_file)
+        return mesh
+
+    @classmethod
+    def from_bytes(cls, data):
+        """Loads a binary or ASCII STL file held in memory."""
+        mesh = cls()
+        mesh.load_bytes(data)
+        return mesh
+
+    @classmethod
+    def from_vertices(cls, vertices):
+        """Makes a mesh of triangles given as (n, 3, 3) or (n, 9) corners."""
+        mesh = cls()
+        mesh.add_triangles(vertices)
+        return mesh
+
+    def close(self):
+        """Frees the mesh now instead of when it is garbage collected."""
+        if self._handle:
+            _lib.slicyl_mesh_free(self._handle)
+            self._handle = None
+
+    def __del__(self):
+        self.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def load(self, stl_file):
+        """Adds the facets of a binary or ASCII STL file."""
+        if _lib.slicyl_mesh_load_file(self._handle, os.fsencode(stl_file)) != 0:
+            raise SlicylError("could not load %s" % stl_file)
+
+    def load_bytes(self, data):
+        """Adds the facets of a binary or ASCII STL file held in memory."""
+        view = memoryview(data).cast("B")
+        if isinstance(data, bytes):
+            buffer = ctypes.c_char_p(data)
+        elif view.readonly:
+            buffer = ctypes.c_char_p(view.tobytes())
+        else:
+            buffer = (ctypes.c_char * view.nbytes).from_buffer(view)
+        if _lib.slicyl_mesh_load_memory(self._handle, ctypes.cast(buffer, ctypes.c_void_p), view.nbytes) != 0:
+            raise SlicylError("could not load the STL data")
+
+    def add_triangles(self, vertices):
+        """
+        Adds triangles given as nine floats each, x y z of every corner.
+        The library copies them once into the mesh's own triangles, so the
+        buffer is free to change afterwards. Data that is not contiguous
+        float32, or read only without NumPy, is converted to float32 first,
+        which is one more copy.
+        """
+        address, count, keep = _float_buffer(vertices)
+        if count % 9 != 0:
+            raise ValueError("vertices must hold nine floats per triangle, got %d floats" % count)
+        if _lib.slicyl_mesh_add_triangles(self._handle, address, count // 9) != 0:
+            raise SlicylError("could not add the triangles")
+        del keep
+
+    def __len__(self):
+        return _lib.slicyl_mesh_size(self._handle)
+
+    def bbox(self):
+        """Corners of the bounding box as ((x, y, z), (x, y, z))."""
+        lower = (ctypes.c_float * 3)()
+        upper = (ctypes.c_float * 3)()
+        _lib.slicyl_mesh_bbox(self._handle, lower, upper)
+        return tuple(lower), tuple(upper)
+
+    def center(self):
+        """Moves the mesh so its bounding box is centred on the origin, like slicyl does."""
+        _lib.slicyl_mesh_center(self._handle)
+
+
+class Layer(object):
+    """One sliced layer: its radius and a view of its slicepieces."""
+
+    def __init__(self, index, radius, pieces):
+        self.index = index
+        self.radius = radius
+        self.pieces = pieces
+
+    def __len__(self):
+        return len(self.pieces)
+
+    @property
+    def segments(self):
+        """Both ends of every piece as an (n, 2, 3) view. Needs NumPy."""
+        if numpy is None:
+            raise RuntimeError("segments needs NumPy, use pieces instead")
+        return self.pieces[:, :6].reshape(len(self.pieces), 2, 3)
+
+    @property
+    def distances(self):
+        """Distance of every piece along the layer as an (n,) view. Needs NumPy."""
+        if numpy is None:
+            raise RuntimeError("distances needs NumPy, use pieces instead")
+        return self.pieces[:, 6]
+
+
+class Layers(object):
+    """Every layer of one slicing, held by the library."""
+
+    def __init__(self):
+        self._handle = _lib.slicyl_layers_new()
+        if not self._handle:
+            raise MemoryError("slicyl_layers_new")
+
+    def __del__(self):
+        if self._handle:
+            _lib.slicyl_layers_free(self._handle)
+            self._handle = None
+
+    def __len__(self):
+        return _lib.slicyl_layers_count(self._handle)
+
+    def __getitem__(self, index):
+        count = len(self)
+        if index < 0:
+            index += count
+        if not 0 <= index < count:
+            raise IndexError("layer %d of %d" % (index, count))
+        size = ctypes.c_size_t()
+        radius = ctypes.c_float()
+        pieces = _lib.slicyl_layers_get(self._handle, index, ctypes.byref(size), ctypes.byref(radius))
+        address = ctypes.cast(pieces, ctypes.c_void_p).value or 0
+        return Layer(index, radius.value, _piece_view(address, size.value, self))
+
+    def __iter__(self):
+        for i in range(len(self)):
+            yield self[i]
+
+
+class Job(object):
+    """How to slice: the radii plus seam, region and sector. Angles are in radians."""
+
+    def __init__(self):
+        self._handle = _lib.slicyl_job_new()
+        if not self._handle:
+            raise MemoryError("slicyl_job_new")
+
+    def __del__(self):
+        if self._handle:
+            _lib.slicyl_job_free(self._handle)
+            self._handle = None
+
+    def set_uniform(self, start_radius, thickness, end_radius):
+        """Evenly spaced layers."""
+        if _lib.slicyl_job_set_uniform(self._handle, start_radius, thickness, end_radius) != 0:
+            raise ValueError("thickness must be positive")
+
+    def set_adaptive(self, start_radius, min_thickness, max_thickness, end_radius):
+        """Layers spaced to follow the mesh."""
+        if _lib.slicyl_job_set_adaptive(self._handle, start_radius, min_thickness, max_thickness, end_radius) != 0:
+            raise ValueError("need 0 < min_thickness <= max_thickness")
+
+    def set_radii(self, radii):
+        """Exactly these radii, smallest first."""
+        address, count, keep = _float_buffer(radii)
+        if _lib.slicyl_job_set_radii(self._handle, ctypes.cast(address, _float_p), count) != 0:
+            raise SlicylError("could not set the radii")
+        del keep
+
+    def set_seam(self, angle):
+        """Where the layers are cut open, around the x axis from +z towards +y."""
+        _lib.slicyl_job_set_seam(self._handle, angle)
+
+    def set_precision(self, precision):
+        """Work the Slicyls out in "float" (the default) or "double"."""
+        if precision not in ("float", "double"):
+            raise ValueError("precision must be float or double")
+        _lib.slicyl_job_set_precision(self._handle, 1 if precision == "double" else 0)
+
+    def set_robust(self, robust=True):
+        """Decide exactly which side of each layer vertices on or near it are on."""
+        _lib.slicyl_job_set_robust(self._handle, 1 if robust else 0)
+
+    def set_cone(self, half_angle):
+        """Cut cones about the x axis instead of Slicyls; radii are where each cone crosses x = 0."""
+        if _lib.slicyl_job_set_cone(self._handle, half_angle) != 0:
+            raise ValueError("half_angle must be inside (-pi/2, pi/2)")
+
+    def set_sphere(self, centre):
+        """Cut spheres about centre (x, y, z) instead of Slicyls."""
+        _lib.slicyl_job_set_sphere(self._handle, (ctypes.c_float * 3)(*centre))
+
+    def set_region(self, x_min, x_max):
+        """Only slice between two x values."""
+        _lib.slicyl_job_set_region(self._handle, x_min, x_max)
+
+    def set_sector(self, start, span):
+        """Only slice part of the way around the axis, the layers then start at the sector."""
+        _lib.slicyl_job_set_sector(self._handle, start, span)
+
+    def radii(self, mesh):
+        """The radii this job slices mesh at, as a list, empty for a job that cannot be sliced."""
+        count = _lib.slicyl_job_get_radii(self._handle, mesh._handle, None, 0)
+        radii = (ctypes.c_float * count)()
+        _lib.slicyl_job_get_radii(self._handle, mesh._handle, radii, count)
+        return list(radii)
+
+    def slice(self, mesh):
+        """
+        Slices mesh in parallel, without holding the GIL, and returns the
+        Layers. Raises ValueError for a cone or sphere with a region, a
+        sector or adaptive radii, which cannot be sliced together.
+        """
+        layers = Layers()
+        result = _lib.slicyl_job_slice(self._handle, mesh._handle, layers._handle)
+        if result == _ERROR_COMBINATION:
+            raise ValueError(_COMBINATION_MESSAGE)
+        if result < 0:
+            raise SlicylError("slicing failed")
+        return layers
+
+    def stream(self, mesh, callback):
+        """
+        Slices mesh, calling callback(index, radius, pieces) with every layer
+        in order instead of keeping them. pieces is only valid during the
+        call. Returning False stops the slicing. Returns how many layers
+        were handed over. Raises ValueError like slice for options that
+        cannot be sliced together.
+        """
+        failed = []
+
+        def forward(index, radius, pieces, count, user):
+            try:
+                address = ctypes.cast(pieces, ctypes.c_void_p).value or 0
+                return 1 if callback(index, radius, _piece_view(address, count, None)) is False else 0
+            except BaseException as error:
+                failed.append(error)
+                return 1
+        handed = _lib.slicyl_job_run(self._handle, mesh._handle, _LayerCallback(forward), None)
+        if failed:
+            raise failed[0]
+        if handed == _ERROR_COMBINATION:
+            raise ValueError(_COMBINATION_MESSAGE)
+        if handed < 0:
+            raise SlicylError("slicing failed")
+        return handed
@@ -0,0 +1,87 @@
+############################################################################
+# The MIT License
+#
+# Copyright (c) 2017 Kyle Ruan
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+############################################################################
+"""
+Checks the bindings against the library they load: make test in src runs
+it with PYTHONPATH=../python, with or without NumPy.
+"""
+
+import ctypes
+import os
+import unittest
+
+import slicyl
+
+BLOCK = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "stl", "block100.stl")
+
+
+class BindingTest(unittest.TestCase):
+
+    def setUp(self):
+        self.mesh = slicyl.Mesh.from_file(BLOCK)
+        self.mesh.center()
+
+    def test_interface(self):
+        self.assertTrue(slicyl.version())
+        self.assertEqual(ctypes.sizeof(slicyl._Piece), slicyl.PIECE_FLOATS * 4)
+        self.assertEqual(len(self.mesh), 12)
+        lower, upper = self.mesh.bbox()
+        self.assertEqual(list(lower), [-50, -50, -50])
+        self.assertEqual(list(upper), [50, 50, 50])
+
+    def test_slice(self):
+        job = slicyl.Job()
+        job.set_uniform(10, 10, 60)
+        layers = job.slice(self.mesh)
+        self.assertEqual(len(layers), 6)
+        for layer in layers:
+            self.assertEqual(layer.pieces.shape, (len(layer), slicyl.PIECE_FLOATS))
+            self.assertGreater(len(layer), 0)
+            # Both ends of every piece lie on the layer
+            for i in range(len(layer)):
+                piece = layer.pieces[i]
+                self.assertEqual(len(piece), slicyl.PIECE_FLOATS)
+                self.assertEqual(piece[2], layer.radius)
+                self.assertEqual(piece[5], layer.radius)
+                self.assertEqual(layer.pieces[i, 6], piece[6])
+
+    def test_stream_matches_slice(self):
+        job = slicyl.Job()
+        job.set_uniform(10, 10, 60)
+        kept = [list(map(list, layer.pieces)) for layer in job.slice(self.mesh)]
+        streamed = []
+        handed = job.stream(self.mesh, lambda index, radius, pieces: streamed.append(list(map(list, pieces))))
+        self.assertEqual(handed, len(kept))
+        self.assertEqual(streamed, kept)
+
+    def test_combination(self):
+        job = slicyl.Job()
+        job.set_uniform(10, 10, 60)
+        job.set_sphere((0, 0, 0))
+        job.set_region(-10, 10)
+        self.assertRaises(ValueError, job.slice, self.mesh)
+        self.assertRaises(ValueError, job.stream, self.mesh, lambda index, radius, pieces: None)
+
+
+if __name__ == "__main__":
+    unittest.main()
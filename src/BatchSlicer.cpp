@@ -0,0 +1,345 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "BatchSlicer.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include "Slicer.h"
+#include "SlicedLayers.h"
+#include "TriangleMesh.h"
+#include "Triangle.h"
+#include "LayerCodec.h"
+#include "NumaPlacement.h"
+#include "RadiusSchedule.h"
+#include "Log.h"
+#include "Trace.h"
+
+// Slicepieces a layer of an F facet mesh cuts is on the order of sqrt(F)
+static const float PIECES_PER_ROOT_FACET = 4.0f;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Counts the facets of an STL without parsing them, taking the count
+--|     from the header of a binary STL and counting endfacets otherwise
+--| Args:
+--|     stl_file - Name of the STL file
+--|     facets - Gets the number of facets
+--| Return:
+--|     bool - false if the file could not be opened
+--|-------------------------------------------------------------------------
+*/
+static bool CountFacets(const char* stl_file, size_t &facets)
+{
+    FILE* f = fopen(stl_file, "rb");
+    if (!f)
+    {
+        return false;
+    }
+    unsigned char header[84];
+    size_t got = fread(header, 1, sizeof(header), f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    uint32_t count = 0;
+    if (got == sizeof(header))
+    {
+        memcpy(&count, header + 80, sizeof(count));
+    }
+    if (got == sizeof(header) && size == 84 + 50 * (long)count)
+    {
+        facets = count;
+        fclose(f);
+        return true;
+    }
+    
+    char line[1024];
+    facets = 0;
+    rewind(f);
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strstr(line, "endfacet"))
+        {
+            facets++;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     memory_budget - Bytes the running jobs may take up together,
+--|                     0 for no limit
+--|     threads - Number of worker threads in the pool
+--| Return:
+--|     A BatchSlicer Object
+--|-------------------------------------------------------------------------
+*/
+BatchSlicer::BatchSlicer(size_t memory_budget, size_t threads) : memory_budget(memory_budget), threads(threads), pool(NULL), status(NULL), bytes_in_use(0), running(0), finished(0), failed(0)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reads the jobs of a manifest file
+--| Args:
+--|     manifest_file - Name of the manifest
+--| Return:
+--|     bool - false if the file could not be read or a line is malformed
+--|-------------------------------------------------------------------------
+*/
+bool BatchSlicer::LoadManifest(const char* manifest_file)
+{
+    FILE* f = fopen(manifest_file, "r");
+    if (!f)
+    {
+        LogPrintf("ERROR opening %s for reading!\n", manifest_file);
+        return false;
+    }
+    
+    char line[4096];
+    char stl_file[1024], slc_file[1024];
+    int line_number = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), f))
+    {
+        line_number++;
+        const char* p = line + strspn(line, " \t\r\n");
+        if (*p == '\0' || *p == '#')
+        {
+            continue;
+        }
+        
+        BatchJob job;
+        if (sscanf(p, "%1023s %f %f %f %1023s", stl_file, &job.start_radius, &job.thickness, &job.end_radius, slc_file) != 5 || job.thickness <= 0.0f)
+        {
+            LogPrintf("ERROR line %d of %s should be: file.stl start_radius thickness end_radius out.slc\n", line_number, manifest_file);
+            ok = false;
+            break;
+        }
+        job.stl_file = stl_file;
+        job.slc_file = slc_file;
+        job.facets = 0;
+        job.bytes = 0;
+        job.started = false;
+        job.ok = false;
+        job.seconds = 0.0;
+        jobs.push_back(job);
+    }
+    fclose(f);
+    return ok;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Runs every job of the manifest
+--| Args:
+--|     status - File the status lines are also written to, or NULL
+--| Return:
+--|     bool - true if every job succeeded
+--|-------------------------------------------------------------------------
+*/
+bool BatchSlicer::Run(FILE* status)
+{
+    this->status = status;
+    bytes_in_use = 0;
+    running = 0;
+    finished = 0;
+    failed = 0;
+    
+    LogPrintf("Slicing %lu jobs on %lu threads", (unsigned long)jobs.size(), (unsigned long)threads);
+    if (memory_budget > 0)
+    {
+        LogPrintf(" within %lu MB", (unsigned long)(memory_budget >> 20));
+    }
+    LogPrintf("...\n");
+    
+    // Size up every job first, a missing file fails right away
+    for (size_t j = 0; j < jobs.size(); j++)
+    {
+        BatchJob &job = jobs[j];
+        RadiusSchedule::Uniform(job.start_radius, job.thickness, job.end_radius, job.radii);
+        if (!CountFacets(job.stl_file.c_str(), job.facets))
+        {
+            LogPrintf("ERROR opening %s for reading!\n", job.stl_file.c_str());
+            job.started = true;
+            FinishJob(j);
+            continue;
+        }
+        job.bytes = EstimateJobBytes(job.facets, job.radii.size());
+    }
+    
+    WorkPool work_pool(threads);
+    pool = &work_pool;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        AdmitJobs();
+    }
+    work_pool.Wait();
+    pool = NULL;
+    
+    LogPrintf("%lu of %lu jobs done, %lu failed\n", (unsigned long)(finished - failed), (unsigned long)jobs.size(), (unsigned long)failed);
+    return failed == 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Guesses the peak memory of slicing one mesh: the Triangles with
+--|     room for the vector to grow, a copy per node under --numa, and
+--|     every layer's slicepieces plus their encoded bytes
+--| Args:
+--|     facets - Number of Triangles in the mesh
+--|     layers - Number of layers sliced
+--| Return:
+--|     size_t - Estimated bytes
+--|-------------------------------------------------------------------------
+*/
+size_t BatchSlicer::EstimateJobBytes(size_t facets, size_t layers)
+{
+    const size_t mesh_bytes = (2 + NumaPlacement::GetNodeCount()) * facets * sizeof(Triangle);
+    const size_t pieces_per_layer = (size_t)(PIECES_PER_ROOT_FACET * sqrtf((float)facets)) + 1;
+    const size_t layer_bytes = pieces_per_layer * (sizeof(slicepiece) + 8);
+    return mesh_bytes + layers * layer_bytes;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Loads, slices and writes out one job
+--| Args:
+--|     job - The job to run
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool BatchSlicer::RunJob(const BatchJob &job) const
+{
+    TriangleMesh mesh;
+    if (!mesh.LoadSTL(job.stl_file.c_str()))
+    {
+        return false;
+    }
+    if (mesh.GetMeshSize() == 0)
+    {
+        LogPrintf("ERROR no Triangles in %s!\n", job.stl_file.c_str());
+        return false;
+    }
+    mesh.BBoxMoveCOG(point(0,0,0));
+    
+    NumaPlacement placement(&mesh);
+    Slicer slice;
+    slice.SetPlacement(&placement);
+    SlicedLayers layers;
+    slice.SliceMesh(&mesh, &layers, job.radii);
+    LayerCodec codec;
+    return codec.ExportBinary(&layers, job.slc_file.c_str());
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Starts waiting jobs, in manifest order, while they fit the memory
+--|     budget. Called with the lock held.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void BatchSlicer::AdmitJobs()
+{
+    for (size_t j = 0; j < jobs.size(); j++)
+    {
+        BatchJob &job = jobs[j];
+        if (job.started)
+        {
+            continue;
+        }
+        
+        // A job too big for the budget gets the machine to itself
+        bool fits = memory_budget == 0 || bytes_in_use + job.bytes <= memory_budget || running == 0;
+        if (!fits)
+        {
+            // Later, smaller jobs may still squeeze in
+            continue;
+        }
+        job.started = true;
+        bytes_in_use += job.bytes;
+        running++;
+        pool->Submit([this, j]()
+        {
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            {
+                TRACE_SCOPE_ARG("batch job", "job", j);
+                jobs[j].ok = RunJob(jobs[j]);
+            }
+            jobs[j].seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            
+            std::lock_guard<std::mutex> guard(lock);
+            bytes_in_use -= jobs[j].bytes;
+            running--;
+            FinishJob(j);
+            AdmitJobs();
+        });
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes the status line of a finished job. Called with the lock held.
+--| Args:
+--|     j - Index of the job
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void BatchSlicer::FinishJob(size_t j)
+{
+    const BatchJob &job = jobs[j];
+    finished++;
+    if (!job.ok)
+    {
+        failed++;
+    }
+    
+    char line[4096];
+    snprintf(line, sizeof(line), "[%lu/%lu] %s %s -> %s, %lu Triangles, %lu layers, est %.1f MB, %.3f s\n", (unsigned long)finished, (unsigned long)jobs.size(), job.ok ? "OK" : "FAILED", job.stl_file.c_str(), job.slc_file.c_str(), (unsigned long)job.facets, (unsigned long)job.radii.size(), job.bytes / 1048576.0, job.seconds);
+    LogPrintf("%s", line);
+    if (status)
+    {
+        fputs(line, status);
+        fflush(status);
+    }
+}
@@ -0,0 +1,138 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _BATCH_SLICER_H_
+#define _BATCH_SLICER_H_
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "WorkPool.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that slices a whole list of STL files in one process.
+--|
+--| Each line of the manifest is one job:
+--|     file.stl start_radius thickness end_radius out.slc
+--| Blank lines and lines starting with # are skipped.
+--|
+--| The jobs share one WorkPool. Before a job starts its memory use is
+--| estimated from its facet count and layer count, and jobs are only let
+--| in, in manifest order, while the estimates of the running jobs fit the
+--| memory budget. A job too big for the budget on its own still runs, but
+--| alone. A status line is written as each job finishes.
+--|-------------------------------------------------------------------------
+*/
+class BatchSlicer
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     memory_budget - Bytes the running jobs may take up together,
+    --|                     0 for no limit
+    --|     threads - Number of worker threads in the pool
+    --| Return:
+    --|     A BatchSlicer Object
+    --|-------------------------------------------------------------------------
+    */
+    BatchSlicer(size_t memory_budget, size_t threads);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Reads the jobs of a manifest file
+    --| Args:
+    --|     manifest_file - Name of the manifest
+    --| Return:
+    --|     bool - false if the file could not be read or a line is malformed
+    --|-------------------------------------------------------------------------
+    */
+    bool LoadManifest(const char* manifest_file);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Runs every job of the manifest
+    --| Args:
+    --|     status - File the status lines are also written to, or NULL
+    --| Return:
+    --|     bool - true if every job succeeded
+    --|-------------------------------------------------------------------------
+    */
+    bool Run(FILE* status);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Guesses the peak memory of slicing one mesh
+    --| Args:
+    --|     facets - Number of Triangles in the mesh
+    --|     layers - Number of layers sliced
+    --| Return:
+    --|     size_t - Estimated bytes
+    --|-------------------------------------------------------------------------
+    */
+    static size_t EstimateJobBytes(size_t facets, size_t layers);
+
+private:
+    // One line of the manifest
+    struct BatchJob
+    {
+        std::string stl_file;
+        std::string slc_file;
+        float start_radius;
+        float thickness;
+        float end_radius;
+        std::vector<float> radii;
+        size_t facets;
+        size_t bytes;
+        bool started;
+        bool ok;
+        double seconds;
+    };
+    
+    bool RunJob(const BatchJob &job) const;
+    void AdmitJobs();
+    void FinishJob(size_t j);
+    
+    size_t memory_budget;
+    size_t threads;
+    std::vector<BatchJob> jobs;
+    
+    // Scheduler state while running, guarded by lock
+    WorkPool* pool;
+    std::mutex lock;
+    FILE* status;
+    size_t bytes_in_use;
+    size_t running;
+    size_t finished;
+    size_t failed;
+};
+
+#endif //_BATCH_SLICER_H_
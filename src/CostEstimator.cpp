@@ -0,0 +1,423 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CostEstimator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "Triangle.h"
+#include "Rollout.h"
+#include "LayerCodec.h"
+#include "Log.h"
+
+static const float TWO_PI = 6.28318530717958647692f;
+
+// Bytes malloc keeps next to every block it hands out
+static const size_t MALLOC_OVERHEAD = 16;
+
+// Heap the C++ runtime, stdio and the STL reader hold before any Triangle
+static const size_t RUNTIME_BYTES = 88 * 1024;
+
+// Packed bytes of a layer besides its slicepieces, the range coder's flush
+static const double LAYER_PAYLOAD_BYTES = 5.0;
+
+// Bits a slicepiece packs into on top of its two coordinate deltas
+static const double PIECE_BITS = 26.0;
+
+// Characters of an exportGIV line besides its four numbers
+static const double GIV_LINE_CHARS = 22.5;
+
+// Cost of a Triangle-radius test, rolling out a slicepiece and packing and
+// printing one, in multiples of working out a Triangle's radial extent
+static const double TEST_PER_EXTENT = 0.85;
+static const double ROLLOUT_PER_EXTENT = 0.7;
+static const double WRITE_PER_EXTENT = 22.0;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets how many elements a vector filled by push_back has room for
+--| Args:
+--|     size - Number of elements pushed
+--| Return:
+--|     double - The capacity, the next power of two
+--|-------------------------------------------------------------------------
+*/
+static double GrownCapacity(double size)
+{
+    double capacity = 1.0;
+    while (capacity < size)
+    {
+        capacity *= 2.0;
+    }
+    return size > 0.0 ? capacity : 0.0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets how many Triangles have started, or ended, below a radius
+--| Args:
+--|     total - Running sums of the histogram, one more than there are bins
+--|     histogram - Triangles per bin
+--|     pos - Radius in bins
+--| Return:
+--|     double - Count, spreading each bin evenly across its width
+--|-------------------------------------------------------------------------
+*/
+static double CountBelow(const std::vector<double> &total, const std::vector<double> &histogram, double pos)
+{
+    if (pos <= 0.0)
+    {
+        return 0.0;
+    }
+    size_t b = (size_t)pos;
+    if (b >= histogram.size())
+    {
+        return total.back();
+    }
+    return total[b] + (pos - (double)b) * histogram[b];
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the distance of a point from the x axis, which the Slicyls
+--|     are wrapped around
+--| Args:
+--|     p - The point
+--| Return:
+--|     double - Its radius
+--|-------------------------------------------------------------------------
+*/
+static double RadiusOf(const point &p)
+{
+    return sqrt((double)p.y * p.y + (double)p.z * p.z);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets how many characters printf's %f gives for a value
+--| Args:
+--|     value - The value
+--| Return:
+--|     double - Number of characters
+--|-------------------------------------------------------------------------
+*/
+static double FixedWidth(double value)
+{
+    char text[64];
+    return snprintf(text, sizeof(text), "%f", value);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Amounts spread evenly over radial intervals, read back at any radius
+--|-------------------------------------------------------------------------
+*/
+struct RadialHistogram
+{
+    std::vector<double> starts, ends;
+    std::vector<double> started, ended;
+    double scale;
+    
+    RadialHistogram(size_t bins, double scale) : starts(bins, 0.0), ends(bins, 0.0), scale(scale)
+    {
+    }
+    
+    // Adds an amount over [lo, hi]
+    void Add(double lo, double hi, double amount)
+    {
+        const size_t last = starts.size() - 1;
+        starts[std::min(last, (size_t)(lo * scale))] += amount;
+        ends[std::min(last, (size_t)(hi * scale))] += amount;
+    }
+    
+    // Takes the running sums, call once everything is added
+    void Sum()
+    {
+        started.assign(starts.size() + 1, 0.0);
+        ended.assign(ends.size() + 1, 0.0);
+        for (size_t b = 0; b < starts.size(); b++)
+        {
+            started[b + 1] = started[b] + starts[b];
+            ended[b + 1] = ended[b] + ends[b];
+        }
+    }
+    
+    // Everything whose interval holds the radius
+    double At(double radius) const
+    {
+        const double pos = radius * scale;
+        return std::max(0.0, CountBelow(started, starts, pos) - CountBelow(ended, ends, pos));
+    }
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     bins - Number of histogram bins across the radial extent of the mesh
+--|     samples - Number of layers cut to calibrate with, 0 for none
+--|     grid - Quantization step of the binary layers
+--| Return:
+--|     A CostEstimator Object
+--|-------------------------------------------------------------------------
+*/
+CostEstimator::CostEstimator(size_t bins, size_t samples, float grid) : bins(bins > 0 ? bins : 1), samples(samples), grid(grid)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Predicts the cost of slicing a mesh at the given radii
+--| Args:
+--|     mesh - The mesh, already moved where it will be sliced
+--|     radii - Slicyl radii, smallest first
+--|     estimate - Gets the prediction
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void CostEstimator::Estimate(const TriangleMesh* mesh, const std::vector<float> &radii, SliceEstimate &estimate) const
+{
+    typedef std::chrono::steady_clock Clock;
+    const size_t nTriangles = mesh->GetMeshSize();
+    const size_t nLayers = radii.size();
+    estimate = SliceEstimate();
+    estimate.triangles = nTriangles;
+    estimate.layers = nLayers;
+    estimate.tests = (double)nTriangles * (double)nLayers;
+    
+    // Where each Triangle starts and stops being cut, timed as the yardstick
+    // for this machine
+    std::vector<float> r_min(nTriangles), r_max(nTriangles);
+    float top = 0.0f;
+    Clock::time_point t0 = Clock::now();
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        mesh->GetTriangle(i).GetRadialExtent(r_min[i], r_max[i]);
+    }
+    const double extent_seconds = nTriangles > 0 ? std::chrono::duration<double>(Clock::now() - t0).count() / nTriangles : 0.0;
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        top = std::max(top, r_max[i]);
+    }
+    
+    // A Slicyl crosses an edge where the edge's distance from the axis
+    // passes its radius. That distance dips to a minimum along the edge, so
+    // between the minimum and the nearer end it is crossed twice, and once
+    // between the two ends. Each slicepiece takes two crossings.
+    // By the coarea formula a Triangle adds area * |gradient of the radius
+    // along it| / (r_max - r_min) of contour to the layers it reaches, on
+    // average, which gives the length of a layer's contour.
+    const double scale = top > 0.0f ? (double)bins / top : 1.0;
+    RadialHistogram crossings(bins, scale), contour(bins, scale);
+    for (size_t i = 0; i < nTriangles; i++)
+    {
+        const Triangle &tri = mesh->GetTriangle(i);
+        for (int e = 0; e < 3; e++)
+        {
+            const point &p = tri.GetVertex(e);
+            const point &q = tri.GetVertex((e + 1) % 3);
+            const double rp = RadiusOf(p), rq = RadiusOf(q);
+            const double dy = (double)q.y - p.y, dz = (double)q.z - p.z;
+            const double dd = dy * dy + dz * dz;
+            const double t = dd > 0.0 ? std::min(1.0, std::max(0.0, -((double)p.y * dy + (double)p.z * dz) / dd)) : 0.0;
+            const double dip = sqrt(std::max(0.0, (p.y + t * dy) * (p.y + t * dy) + (p.z + t * dz) * (p.z + t * dz)));
+            const double near = std::min(rp, rq);
+            crossings.Add(near, std::max(rp, rq), 1.0);
+            if (dip < near)
+            {
+                crossings.Add(dip, near, 2.0);
+            }
+        }
+        
+        const point &a = tri.GetVertex(0), &b = tri.GetVertex(1), &c = tri.GetVertex(2);
+        const double ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+        const double vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+        const double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+        const double twice_area = sqrt(nx * nx + ny * ny + nz * nz);
+        const double span = (double)r_max[i] - r_min[i];
+        if (twice_area <= 0.0 || span <= 0.0)
+        {
+            continue;
+        }
+        const double cy = (a.y + b.y + c.y) / 3.0, cz = (a.z + b.z + c.z) / 3.0;
+        const double rc = sqrt(cy * cy + cz * cz);
+        const double along = rc > 0.0 ? (ny * cy + nz * cz) / (twice_area * rc) : 0.0;
+        contour.Add(r_min[i], r_max[i], 0.5 * twice_area * sqrt(std::max(0.0, 1.0 - along * along)) / span);
+    }
+    crossings.Sum();
+    contour.Sum();
+    
+    // Grid the preview lays the layers out on, like SlicedLayers::GetGridLayout
+    const point size = mesh->GetBBoxSize();
+    size_t per_row = std::max((size_t)1, (size_t)sqrt((float)nLayers));
+    float row_height = size.y;
+    if (nLayers > 0)
+    {
+        row_height = std::max(row_height, TWO_PI * radii.back());
+    }
+    const float cell_width = size.x * 1.5f;
+    const float cell_height = row_height * 1.5f;
+    
+    // Slicepieces, and what they pack into and print as, layer by layer
+    std::vector<double> layer_pieces(nLayers), layer_payload(nLayers);
+    for (size_t i = 0; i < nLayers; i++)
+    {
+        const double rad = radii[i];
+        const double pieces = 0.5 * crossings.At(rad);
+        layer_pieces[i] = pieces;
+        estimate.pieces += pieces;
+        estimate.max_layer_pieces = std::max(estimate.max_layer_pieces, pieces);
+        
+        // Each coordinate delta of a slicepiece costs about its bits on the grid
+        const double length = pieces > 0.0 ? contour.At(rad) / pieces : 0.0;
+        const double bits = 2.0 * log2(std::max(1.0, length / grid)) + PIECE_BITS;
+        layer_payload[i] = LAYER_PAYLOAD_BYTES + pieces * bits / 8.0;
+        
+        // Same lines exportGIV writes, with the numbers spread over the layer's cell
+        const double dx = (double)(i % per_row) * cell_width;
+        const double dy = (double)(i / per_row) * cell_height;
+        double digits = 0.0;
+        for (int k = 0; k < 4; k++)
+        {
+            digits += FixedWidth(dx + size.x * (2 * k - 3) / 8.0) + FixedWidth(dy + TWO_PI * rad * (2 * k + 1) / 8.0);
+        }
+        estimate.giv_bytes += pieces * (GIV_LINE_CHARS + 2.0 * digits / 4.0);
+    }
+    
+    // Cut a few layers to calibrate the packed size and timings, only on request
+    double payload_scale = 1.0;
+    double seconds_per_test = extent_seconds * TEST_PER_EXTENT;
+    double seconds_per_piece = extent_seconds * ROLLOUT_PER_EXTENT;
+    double write_per_piece = extent_seconds * WRITE_PER_EXTENT;
+    std::vector<size_t> busy;
+    for (size_t i = 0; i < nLayers; i++)
+    {
+        if (layer_pieces[i] > 0.0)
+        {
+            busy.push_back(i);
+        }
+    }
+    const size_t nSamples = std::min(samples, busy.size());
+    if (nSamples > 0)
+    {
+        Rollout rollout;
+        LayerCodec codec(grid);
+        double sample_pieces = 0.0, sample_bytes = 0.0, sample_model = 0.0;
+        double test_time = 0.0, rollout_time = 0.0, write_time = 0.0;
+        for (size_t k = 0; k < nSamples; k++)
+        {
+            const size_t i = busy[(2 * k + 1) * busy.size() / (2 * nSamples)];
+            const float rad = radii[i];
+            std::vector<LineSeg> segments;
+            std::vector<slicepiece> pieces;
+            std::vector<unsigned char> payload;
+            
+            Clock::time_point t1 = Clock::now();
+            for (size_t j = 0; j < nTriangles; j++)
+            {
+                LineSeg found[3];
+                int n = mesh->GetTriangle(j).FindSegments(rad, found);
+                segments.insert(segments.end(), found, found + n);
+            }
+            Clock::time_point t2 = Clock::now();
+            rollout.RolloutLayer(segments, rad, pieces);
+            Clock::time_point t3 = Clock::now();
+            codec.EncodeLayer(pieces, payload);
+            char line[256];
+            for (size_t j = 0; j < pieces.size(); j++)
+            {
+                snprintf(line, sizeof(line), "\n\n$line\n$color %s\n%f %f\n%f %f", (j % 2) ? "blue" : "red", pieces[j].a.x, pieces[j].a.y, pieces[j].b.x, pieces[j].b.y);
+            }
+            Clock::time_point t4 = Clock::now();
+            
+            sample_pieces += pieces.size();
+            sample_bytes += payload.size();
+            sample_model += layer_payload[i];
+            test_time += std::chrono::duration<double>(t2 - t1).count();
+            rollout_time += std::chrono::duration<double>(t3 - t2).count();
+            write_time += std::chrono::duration<double>(t4 - t3).count();
+        }
+        payload_scale = sample_model > 0.0 ? sample_bytes / sample_model : 1.0;
+        seconds_per_test = nTriangles > 0 ? test_time / ((double)nSamples * nTriangles) : 0.0;
+        if (sample_pieces > 0.0)
+        {
+            seconds_per_piece = rollout_time / sample_pieces;
+            write_per_piece = write_time / sample_pieces;
+        }
+    }
+    
+    double payload_bytes = 0.0;
+    for (size_t i = 0; i < nLayers; i++)
+    {
+        payload_bytes += layer_payload[i] * payload_scale;
+    }
+    estimate.binary_bytes = 4 + sizeof(uint32_t) + sizeof(float) + (double)nLayers * 4 * sizeof(uint32_t) + payload_bytes;
+    
+    // Loading peaks when the Triangles outgrow their vector and are copied
+    // over. After that the mesh and every finished layer stay put, and on
+    // top of them comes either the busiest layer being cut and rolled out,
+    // or the encoded file.
+    const double mesh_bytes = GrownCapacity(nTriangles) * sizeof(Triangle);
+    const double loading_bytes = mesh_bytes * 1.5;
+    const double layer_bytes = estimate.pieces * sizeof(slicepiece) + (double)nLayers * MALLOC_OVERHEAD + GrownCapacity(nLayers) * (sizeof(std::vector<slicepiece>) + sizeof(float) + sizeof(char));
+    const double cutting_bytes = GrownCapacity(estimate.max_layer_pieces) * sizeof(LineSeg) + estimate.max_layer_pieces * (sizeof(slicepiece) + 6 * sizeof(float));
+    const double encoding_bytes = payload_bytes + (double)nLayers * (sizeof(std::vector<unsigned char>) + MALLOC_OVERHEAD);
+    estimate.peak_bytes = RUNTIME_BYTES + std::max(loading_bytes, mesh_bytes + layer_bytes + std::max(cutting_bytes, encoding_bytes));
+    
+    estimate.slice_seconds = estimate.tests * seconds_per_test + estimate.pieces * seconds_per_piece;
+    estimate.write_seconds = estimate.pieces * write_per_piece;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Prints a prediction, one "name: value" per line
+--| Args:
+--|     estimate - The prediction
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void CostEstimator::PrintEstimate(const SliceEstimate &estimate)
+{
+    LogPrintf("Estimate for %lu Triangles in %lu layers:\n", (unsigned long)estimate.triangles, (unsigned long)estimate.layers);
+    LogPrintf("Triangle-radius tests: %.0f\n", estimate.tests);
+    LogPrintf("Slicepieces: %.0f\n", estimate.pieces);
+    LogPrintf("Slicepieces per layer: %.1f\n", estimate.layers > 0 ? estimate.pieces / estimate.layers : 0.0);
+    LogPrintf("Slicepieces in busiest layer: %.0f\n", estimate.max_layer_pieces);
+    LogPrintf("Binary bytes: %.0f\n", estimate.binary_bytes);
+    LogPrintf("GIV bytes: %.0f\n", estimate.giv_bytes);
+    LogPrintf("Peak memory bytes: %.0f\n", estimate.peak_bytes);
+    LogPrintf("Slicing seconds: %.3f\n", estimate.slice_seconds);
+    LogPrintf("Writing seconds: %.3f\n", estimate.write_seconds);
+}
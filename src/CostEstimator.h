@@ -0,0 +1,122 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _COST_ESTIMATOR_H_
+#define _COST_ESTIMATOR_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+
+// What slicing a mesh is expected to take, filled in by CostEstimator
+struct SliceEstimate
+{
+    size_t triangles;
+    size_t layers;
+    // Triangle against Slicyl tests, one per Triangle per layer
+    double tests;
+    // Slicepieces over all layers, and in the busiest layer
+    double pieces;
+    double max_layer_pieces;
+    // Size of the --binary file and of slicyl_out.marks
+    double binary_bytes;
+    double giv_bytes;
+    // Heap held at the worst moment, which is while the binary file is encoded
+    double peak_bytes;
+    // Time to slice, and to write both output files, on one core of this machine
+    double slice_seconds;
+    double write_seconds;
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that predicts the cost of slicing a mesh without slicing it.
+--|
+--| Everything comes from radial histograms of the mesh, no layer is cut.
+--| Every edge adds the radii where a Slicyl crosses it once or twice, two
+--| crossings make a slicepiece, and every Triangle adds the length of
+--| contour it gives the layers it reaches. The running sums of the
+--| histograms give both for every layer, interpolating inside a bin. From
+--| the number and length of the slicepieces come the packed and printed
+--| output sizes, and the timings are measured against how long working
+--| out the radial extents took on this machine.
+--|
+--| Only if asked for, a few layers are then cut for real to calibrate the
+--| packed size and the timings, which helps on very regular meshes that
+--| pack far smaller than their slicepiece lengths suggest.
+--|-------------------------------------------------------------------------
+*/
+class CostEstimator
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     bins - Number of histogram bins across the radial extent of the mesh
+    --|     samples - Number of layers cut to calibrate with, 0 for none
+    --|     grid - Quantization step of the binary layers
+    --| Return:
+    --|     A CostEstimator Object
+    --|-------------------------------------------------------------------------
+    */
+    CostEstimator(size_t bins = 4096, size_t samples = 0, float grid = 0.001f);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Predicts the cost of slicing a mesh at the given radii
+    --| Args:
+    --|     mesh - The mesh, already moved where it will be sliced
+    --|     radii - Slicyl radii, smallest first
+    --|     estimate - Gets the prediction
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Estimate(const TriangleMesh* mesh, const std::vector<float> &radii, SliceEstimate &estimate) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Prints a prediction, one "name: value" per line
+    --| Args:
+    --|     estimate - The prediction
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    static void PrintEstimate(const SliceEstimate &estimate);
+
+private:
+    // Number of histogram bins across the radial extent of the mesh
+    size_t bins;
+    // Number of layers cut to calibrate with, 0 for none
+    size_t samples;
+    // Quantization step of the binary layers
+    float grid;
+};
+
+#endif //_COST_ESTIMATOR_H_
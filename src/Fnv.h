@@ -0,0 +1,58 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef _FNV_H_
+#define _FNV_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Starting value of an FNV-1a hash
+static const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Folds bytes into a 64 bit FNV-1a hash. Hashes can be chained by
+--|     handing the last result back in.
+--| Args:
+--|     data - The bytes
+--|     size - Number of bytes
+--|     hash - Hash so far
+--| Return:
+--|     uint64_t - The hash with the bytes folded in
+--|-------------------------------------------------------------------------
+*/
+inline uint64_t Fnv1a(const void* data, size_t size, uint64_t hash = FNV_OFFSET)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+#endif //_FNV_H_
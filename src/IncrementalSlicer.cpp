@@ -0,0 +1,289 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "IncrementalSlicer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "Triangle.h"
+#include "Fnv.h"
+#include "Log.h"
+
+// Spans are widened this much, relative to the radius, so a layer a cut in double just reaches is not missed
+static const float SPAN_SLACK = 1e-5f;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the bit patterns of a vertex
+--| Args:
+--|     p - The vertex
+--|     bits - Gets x, y and z
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+static void VertexBits(const point &p, uint32_t bits[3])
+{
+    memcpy(&bits[0], &p.x, sizeof(uint32_t));
+    memcpy(&bits[1], &p.y, sizeof(uint32_t));
+    memcpy(&bits[2], &p.z, sizeof(uint32_t));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Hashes a Triangle by its vertices with FNV-1a, starting from the
+--|     smallest vertex and keeping the winding
+--| Args:
+--|     tri - The Triangle
+--| Return:
+--|     uint64_t - The hash
+--|-------------------------------------------------------------------------
+*/
+static uint64_t HashTriangle(const Triangle &tri)
+{
+    uint32_t bits[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        VertexBits(tri.GetVertex(i), bits[i]);
+    }
+    int first = 0;
+    for (int i = 1; i < 3; i++)
+    {
+        if (std::lexicographical_compare(bits[i], bits[i] + 3, bits[first], bits[first] + 3))
+        {
+            first = i;
+        }
+    }
+    
+    uint32_t words[9];
+    for (int i = 0; i < 3; i++)
+    {
+        memcpy(&words[3 * i], bits[(first + i) % 3], sizeof(bits[0]));
+    }
+    return Fnv1a(words, sizeof(words));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     slicer - Slicer set up with the seam, region and precision to use
+--|     radii - Slicyl radii, smallest first, the same for every edit
+--| Return:
+--|     An IncrementalSlicer Object
+--|-------------------------------------------------------------------------
+*/
+IncrementalSlicer::IncrementalSlicer(Slicer &slicer, const std::vector<float> &radii) : slicer(slicer), radii(radii), mesh(NULL), offset(0, 0, 0)
+{
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+IncrementalSlicer::~IncrementalSlicer()
+{
+    delete mesh;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Loads an STL file and brings output up to date with it. The first
+--|     call centres the mesh and slices every layer, later calls keep
+--|     that placement and only slice the layers the edit reached. When
+--|     the file cannot be read nothing is changed.
+--| Args:
+--|     stl_file - Name of the STL file, ASCII or binary
+--|     output - The layers of the last call, gets one layer per radius
+--|     changed - Gets the indices of the layers that were sliced, in order
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool IncrementalSlicer::SliceFile(const char* stl_file, SlicedLayers* output, std::vector<size_t> &changed)
+{
+    changed.clear();
+    TriangleMesh* loaded = new TriangleMesh;
+    if (!loaded->LoadSTL(stl_file))
+    {
+        delete loaded;
+        return false;
+    }
+    
+    if (!mesh)
+    {
+        offset = loaded->BBoxMoveCOG(point(0,0,0));
+        mesh = loaded;
+        HashMesh(mesh, hashes);
+        slicer.SliceMesh(mesh, output, radii);
+        for (size_t i = 0; i < radii.size(); i++)
+        {
+            changed.push_back(i);
+        }
+        return true;
+    }
+    
+    // Same place as the first mesh, whatever the edit did to the Bounding Box
+    loaded->MoveMesh(offset);
+    std::vector<TriangleHash> loaded_hashes;
+    HashMesh(loaded, loaded_hashes);
+    
+    // Walk both sorted lists, a hash on one side only is a Triangle that came or went
+    std::vector<std::pair<float, float> > spans;
+    size_t added = 0, removed = 0;
+    size_t i = 0, j = 0;
+    while (i < hashes.size() || j < loaded_hashes.size())
+    {
+        std::pair<float, float> span;
+        if (j == loaded_hashes.size() || (i < hashes.size() && hashes[i].first < loaded_hashes[j].first))
+        {
+            mesh->GetTriangle((int)hashes[i++].second).GetRadialExtent(span.first, span.second);
+            removed++;
+        }
+        else if (i == hashes.size() || loaded_hashes[j].first < hashes[i].first)
+        {
+            loaded->GetTriangle((int)loaded_hashes[j++].second).GetRadialExtent(span.first, span.second);
+            added++;
+        }
+        else
+        {
+            i++;
+            j++;
+            continue;
+        }
+        spans.push_back(span);
+    }
+    
+    delete mesh;
+    mesh = loaded;
+    hashes.swap(loaded_hashes);
+    FindLayers(spans, changed);
+    LogPrintf("%lu Triangles added and %lu removed, slicing %lu of the %lu layers again\n", (unsigned long)added, (unsigned long)removed, (unsigned long)changed.size(), (unsigned long)radii.size());
+    if (changed.empty())
+    {
+        return true;
+    }
+    
+    // Slice the reached radii on their own and put each layer back at its index
+    std::vector<float> changed_radii(changed.size());
+    for (size_t k = 0; k < changed.size(); k++)
+    {
+        changed_radii[k] = radii[changed[k]];
+    }
+    SlicedLayers changed_layers;
+    slicer.SliceMesh(mesh, &changed_layers, changed_radii);
+    for (size_t k = 0; k < changed.size(); k++)
+    {
+        output->SetLayer((int)changed[k], changed_layers.GetLayer(k), changed_layers.GetLayerRadius(k));
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the mesh sliced last
+--| Args:
+--|     none
+--| Return:
+--|     const TriangleMesh* - The mesh, NULL before the first SliceFile
+--|-------------------------------------------------------------------------
+*/
+const TriangleMesh* IncrementalSlicer::GetMesh() const
+{
+    return mesh;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Hashes every Triangle of a mesh
+--| Args:
+--|     mesh - The mesh, already moved where it is sliced
+--|     hashes - Gets one hash per Triangle, sorted
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void IncrementalSlicer::HashMesh(const TriangleMesh* mesh, std::vector<TriangleHash> &hashes)
+{
+    hashes.resize(mesh->GetMeshSize());
+    for (size_t i = 0; i < hashes.size(); i++)
+    {
+        hashes[i] = TriangleHash(HashTriangle(mesh->GetTriangle((int)i)), i);
+    }
+    std::sort(hashes.begin(), hashes.end());
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Finds the layers whose radius falls inside any of the spans
+--| Args:
+--|     spans - [r_min, r_max] of every Triangle that came or went
+--|     changed - Gets the indices of those layers, in order
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void IncrementalSlicer::FindLayers(std::vector<std::pair<float, float> > &spans, std::vector<size_t> &changed) const
+{
+    // Widen and merge the spans so each radius is looked up in one sorted list
+    std::sort(spans.begin(), spans.end());
+    std::vector<std::pair<float, float> > merged;
+    for (size_t i = 0; i < spans.size(); i++)
+    {
+        float r_min = spans[i].first - SPAN_SLACK * (spans[i].first + 1.0f);
+        float r_max = spans[i].second + SPAN_SLACK * (spans[i].second + 1.0f);
+        if (!merged.empty() && r_min <= merged.back().second)
+        {
+            merged.back().second = std::max(merged.back().second, r_max);
+        }
+        else
+        {
+            merged.push_back(std::pair<float, float>(r_min, r_max));
+        }
+    }
+    
+    for (size_t i = 0; i < radii.size(); i++)
+    {
+        // The last span starting at or before the radius is the only one that can hold it
+        std::vector<std::pair<float, float> >::const_iterator it = std::upper_bound(merged.begin(), merged.end(), std::pair<float, float>(radii[i], std::numeric_limits<float>::max()));
+        if (it != merged.begin() && radii[i] <= (it - 1)->second)
+        {
+            changed.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,150 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef _INCREMENTAL_SLICER_H_
+#define _INCREMENTAL_SLICER_H_
+
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+#include "SlicedLayers.h"
+#include "Slicer.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that slices an STL file again after it was edited, redoing only
+--| the layers the edit reached.
+--|
+--| The mesh sliced last is kept together with a hash of every Triangle.
+--| A Triangle's hash is taken over its vertices after centring, starting
+--| from its smallest vertex so it does not matter which one the file put
+--| first. An edited file is put exactly where the first one was centred,
+--| so Triangles that did not change hash the same, and the two sorted
+--| hash lists are merged to find the Triangles that came or went. Only
+--| the radii falling inside the [r_min, r_max] of those Triangles are
+--| sliced again, the other layers are left as they were.
+--|-------------------------------------------------------------------------
+*/
+class IncrementalSlicer
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     slicer - Slicer set up with the seam, region and precision to use
+    --|     radii - Slicyl radii, smallest first, the same for every edit
+    --| Return:
+    --|     An IncrementalSlicer Object
+    --|-------------------------------------------------------------------------
+    */
+    IncrementalSlicer(Slicer &slicer, const std::vector<float> &radii);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    ~IncrementalSlicer();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Loads an STL file and brings output up to date with it. The first
+    --|     call centres the mesh and slices every layer, later calls keep
+    --|     that placement and only slice the layers the edit reached. When
+    --|     the file cannot be read nothing is changed.
+    --| Args:
+    --|     stl_file - Name of the STL file, ASCII or binary
+    --|     output - The layers of the last call, gets one layer per radius
+    --|     changed - Gets the indices of the layers that were sliced, in order
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool SliceFile(const char* stl_file, SlicedLayers* output, std::vector<size_t> &changed);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the mesh sliced last
+    --| Args:
+    --|     none
+    --| Return:
+    --|     const TriangleMesh* - The mesh, NULL before the first SliceFile
+    --|-------------------------------------------------------------------------
+    */
+    const TriangleMesh* GetMesh() const;
+
+private:
+    // A Triangle's hash and where it is in the mesh
+    typedef std::pair<uint64_t, size_t> TriangleHash;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Hashes every Triangle of a mesh
+    --| Args:
+    --|     mesh - The mesh, already moved where it is sliced
+    --|     hashes - Gets one hash per Triangle, sorted
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    static void HashMesh(const TriangleMesh* mesh, std::vector<TriangleHash> &hashes);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Finds the layers whose radius falls inside any of the spans
+    --| Args:
+    --|     spans - [r_min, r_max] of every Triangle that came or went
+    --|     changed - Gets the indices of those layers, in order
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void FindLayers(std::vector<std::pair<float, float> > &spans, std::vector<size_t> &changed) const;
+    
+    // Slicer set up with the seam, region and precision to use
+    Slicer &slicer;
+    // Slicyl radii, smallest first
+    std::vector<float> radii;
+    // The mesh sliced last, moved where it is sliced
+    TriangleMesh* mesh;
+    // How far the first mesh was moved to centre it
+    point offset;
+    // Hashes of the Triangles of mesh, sorted
+    std::vector<TriangleHash> hashes;
+};
+
+#endif //_INCREMENTAL_SLICER_H_
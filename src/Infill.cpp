@@ -0,0 +1,193 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "Infill.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Parallel.h"
+#include "Rollout.h"
+#include "Log.h"
+#include "Trace.h"
+
+// One non horizontal edge in the rotated frame where raster lines run along u
+struct ScanEdge
+{
+    float v_min;
+    float v_max;
+    float u_at_min;
+    float du_dv;
+};
+
+static bool ScanEdgeBefore(const ScanEdge &a, const ScanEdge &b)
+{
+    return a.v_min < b.v_min;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     spacing - Distance between raster lines
+--|     angle - Direction of the raster lines in radians, 0 runs along x
+--| Return:
+--|     An Infill Object
+--|-------------------------------------------------------------------------
+*/
+Infill::Infill(float spacing, float angle) : spacing(spacing)
+{
+    cos_angle = cos(angle);
+    sin_angle = sin(angle);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Fills every layer, spreading the layers over the worker threads
+--| Args:
+--|     layers - The sliced perimeters
+--|     toolpaths - Gets one set of infill moves per layer
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Infill::GenerateInfill(const SlicedLayers* layers, LayerToolpaths* toolpaths) const
+{
+    LogPrintf("Generating infill every %0.3f now...\n", spacing);
+    toolpaths->Resize(layers->GetSize());
+    ParallelFor(layers->GetSize(), [&](size_t i)
+    {
+        TRACE_SCOPE_ARG("infill layer", "layer", i);
+        FillLayer(layers->GetLayer(i), layers->GetLayerRadius(i), toolpaths->GetInfill(i));
+    });
+    LogPrintf("...Done!\n\n");
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Fills one rolled out layer. Raster lines lie on a grid anchored at
+--|     the origin so they line up from layer to layer.
+--| Args:
+--|     perimeter - The slicepieces bounding the layer
+--|     radius - Radius of the layer
+--|     out - Vector the raster moves get appended to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Infill::FillLayer(const std::vector<slicepiece> &perimeter, float radius, std::vector<slicepiece> &out) const
+{
+    if (perimeter.empty() || spacing <= 0.0f)
+    {
+        return;
+    }
+    
+    std::vector<LineSeg> outline;
+    Rollout::CloseOutline(perimeter, outline);
+    
+    // Edge table in the rotated frame, sorted by where each edge starts
+    std::vector<ScanEdge> edges;
+    edges.reserve(outline.size());
+    for (size_t i = 0; i < outline.size(); i++)
+    {
+        float u0 = outline[i].pt0.x*cos_angle + outline[i].pt0.y*sin_angle;
+        float v0 = outline[i].pt0.y*cos_angle - outline[i].pt0.x*sin_angle;
+        float u1 = outline[i].pt1.x*cos_angle + outline[i].pt1.y*sin_angle;
+        float v1 = outline[i].pt1.y*cos_angle - outline[i].pt1.x*sin_angle;
+        
+        // Parallel to the raster lines, never crossed
+        if (v0 == v1)
+        {
+            continue;
+        }
+        if (v1 < v0)
+        {
+            std::swap(u0, u1);
+            std::swap(v0, v1);
+        }
+        ScanEdge e = {v0, v1, u0, (u1 - u0)/(v1 - v0)};
+        edges.push_back(e);
+    }
+    if (edges.empty())
+    {
+        return;
+    }
+    std::sort(edges.begin(), edges.end(), ScanEdgeBefore);
+    
+    float v_max = edges[0].v_max;
+    for (size_t i = 1; i < edges.size(); i++)
+    {
+        v_max = std::max(v_max, edges[i].v_max);
+    }
+    
+    // Sweep the raster lines, edges are live on [v_min, v_max)
+    std::vector<size_t> active;
+    std::vector<float> crossings;
+    std::vector<slicepiece> spans;
+    size_t next_edge = 0;
+    bool forward = true;
+    for (long line = (long)ceil(edges[0].v_min / spacing); line * spacing < v_max; line++)
+    {
+        const float v = line * spacing;
+        
+        while (next_edge < edges.size() && edges[next_edge].v_min <= v)
+        {
+            active.push_back(next_edge++);
+        }
+        
+        crossings.clear();
+        size_t kept = 0;
+        for (size_t k = 0; k < active.size(); k++)
+        {
+            const ScanEdge &e = edges[active[k]];
+            if (e.v_max <= v)
+            {
+                continue;
+            }
+            active[kept++] = active[k];
+            crossings.push_back(e.u_at_min + (v - e.v_min)*e.du_dv);
+        }
+        active.resize(kept);
+        std::sort(crossings.begin(), crossings.end());
+        
+        // Even-odd spans, snaking back and forth
+        spans.clear();
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2)
+        {
+            float u0 = forward ? crossings[k] : crossings[k+1];
+            float u1 = forward ? crossings[k+1] : crossings[k];
+            point a(u0*cos_angle - v*sin_angle, u0*sin_angle + v*cos_angle, radius);
+            point b(u1*cos_angle - v*sin_angle, u1*sin_angle + v*cos_angle, radius);
+            spans.push_back(slicepiece(a, b, fabs(u1 - u0)));
+        }
+        if (!forward)
+        {
+            std::reverse(spans.begin(), spans.end());
+        }
+        out.insert(out.end(), spans.begin(), spans.end());
+        forward = !forward;
+    }
+}
@@ -0,0 +1,769 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "LayerCodec.h"
+
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+#include "Parallel.h"
+#include "Log.h"
+#include "Trace.h"
+
+// File header magic and version
+static const char SLC_MAGIC[4] = {'S', 'L', 'C', 'Y'};
+static const uint32_t SLC_VERSION = 1;
+static const uint32_t SLC_SHARD_VERSION = 2;
+
+// Most layers a file may hold, a 1 um step over more than 4 m of radius
+static const uint32_t SLC_MAX_LAYERS = 1 << 22;
+
+// Varint fields of a piece: a.x (with the chained flag), a.y, b.x, b.y
+static const int NUM_FIELDS = 4;
+
+// Byte positions inside a varint that get their own statistics: 0, 1 and 2+
+static const int NUM_BYTE_SLOTS = 3;
+
+// Probabilities are 11 bit fixed point, adapted with a shift of 5
+static const uint32_t PROB_BITS = 11;
+static const uint32_t PROB_INIT = 1 << (PROB_BITS - 1);
+static const uint32_t MOVE_BITS = 5;
+static const uint32_t RANGE_TOP = 1 << 24;
+
+// Fewest bits a piece can take: 16 decisions at the most skewed probability,
+// 2017/2048, cost just over 0.352 bits
+static const double MIN_PIECE_BITS = 0.35;
+
+/*
+--|-------------------------------------------------------------------------
+--| Adaptive order-0 statistics for the varint bytes. One 8 level bit tree
+--| per (field, byte slot) pair.
+--|-------------------------------------------------------------------------
+*/
+struct ByteModel
+{
+    uint16_t probs[NUM_FIELDS][NUM_BYTE_SLOTS][256];
+    
+    ByteModel()
+    {
+        for (int f = 0; f < NUM_FIELDS; f++)
+        {
+            for (int s = 0; s < NUM_BYTE_SLOTS; s++)
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    probs[f][s][i] = PROB_INIT;
+                }
+            }
+        }
+    }
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| Binary range encoder (carry-less, LZMA style)
+--|-------------------------------------------------------------------------
+*/
+class RangeEncoder
+{
+public:
+    RangeEncoder(std::vector<unsigned char> &output) : out(output), low(0), range(0xFFFFFFFF), cache(0), cache_size(1)
+    {
+    }
+    
+    void EncodeBit(uint16_t &prob, uint32_t bit)
+    {
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        if (bit == 0)
+        {
+            range = bound;
+            prob += ((1 << PROB_BITS) - prob) >> MOVE_BITS;
+        }
+        else
+        {
+            low += bound;
+            range -= bound;
+            prob -= prob >> MOVE_BITS;
+        }
+        while (range < RANGE_TOP)
+        {
+            range <<= 8;
+            ShiftLow();
+        }
+    }
+    
+    void EncodeByte(uint16_t* tree, uint32_t byte)
+    {
+        uint32_t m = 1;
+        for (int i = 7; i >= 0; i--)
+        {
+            uint32_t bit = (byte >> i) & 1;
+            EncodeBit(tree[m], bit);
+            m = (m << 1) | bit;
+        }
+    }
+    
+    void Flush()
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            ShiftLow();
+        }
+    }
+
+private:
+    void ShiftLow()
+    {
+        // Hold back 0xFF bytes until we know whether a carry ripples through them
+        if ((uint32_t)low < 0xFF000000u || (low >> 32) != 0)
+        {
+            unsigned char carry = (unsigned char)(low >> 32);
+            unsigned char temp = cache;
+            do
+            {
+                out.push_back((unsigned char)(temp + carry));
+                temp = 0xFF;
+            } while (--cache_size != 0);
+            cache = (unsigned char)(low >> 24);
+        }
+        cache_size++;
+        low = (low & 0x00FFFFFF) << 8;
+    }
+
+    std::vector<unsigned char> &out;
+    uint64_t low;
+    uint32_t range;
+    unsigned char cache;
+    uint64_t cache_size;
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| Binary range decoder matching RangeEncoder
+--|-------------------------------------------------------------------------
+*/
+class RangeDecoder
+{
+public:
+    RangeDecoder(const unsigned char* data, size_t size) : in(data), end(data + size), range(0xFFFFFFFF), code(0)
+    {
+        for (int i = 0; i < 5; i++)
+        {
+            code = (code << 8) | NextByte();
+        }
+    }
+    
+    uint32_t DecodeBit(uint16_t &prob)
+    {
+        uint32_t bound = (range >> PROB_BITS) * prob;
+        uint32_t bit;
+        if (code < bound)
+        {
+            range = bound;
+            prob += ((1 << PROB_BITS) - prob) >> MOVE_BITS;
+            bit = 0;
+        }
+        else
+        {
+            code -= bound;
+            range -= bound;
+            prob -= prob >> MOVE_BITS;
+            bit = 1;
+        }
+        if (range < RANGE_TOP)
+        {
+            range <<= 8;
+            code = (code << 8) | NextByte();
+        }
+        return bit;
+    }
+    
+    uint32_t DecodeByte(uint16_t* tree)
+    {
+        uint32_t m = 1;
+        for (int i = 0; i < 8; i++)
+        {
+            m = (m << 1) | DecodeBit(tree[m]);
+        }
+        return m & 0xFF;
+    }
+    
+    // True once the decoder has wanted more bytes than the stream holds
+    bool Overrun() const
+    {
+        return in > end;
+    }
+
+private:
+    uint32_t NextByte()
+    {
+        // Past the end just feed zeros and remember it
+        if (in < end)
+        {
+            return *in++;
+        }
+        in++;
+        return 0;
+    }
+
+    const unsigned char* in;
+    const unsigned char* end;
+    uint32_t range;
+    uint32_t code;
+};
+
+// Maps a signed delta onto an unsigned value with small magnitudes first
+static inline uint64_t ZigZag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t UnZigZag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Writes one varint through the entropy coder
+static void PutVarint(RangeEncoder &rc, ByteModel &model, int field, uint64_t v)
+{
+    int slot = 0;
+    while (v >= 0x80)
+    {
+        rc.EncodeByte(model.probs[field][slot], (uint32_t)(v & 0x7F) | 0x80);
+        v >>= 7;
+        if (slot < NUM_BYTE_SLOTS - 1)
+        {
+            slot++;
+        }
+    }
+    rc.EncodeByte(model.probs[field][slot], (uint32_t)v);
+}
+
+// Most pieces a payload of the given size can hold
+static inline size_t MaxPieces(size_t bytes)
+{
+    return (size_t)(bytes * 8 / MIN_PIECE_BITS);
+}
+
+// Reads one varint back out of the entropy coder
+static uint64_t GetVarint(RangeDecoder &rc, ByteModel &model, int field)
+{
+    uint64_t v = 0;
+    int slot = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        uint32_t byte = rc.DecodeByte(model.probs[field][slot]);
+        v |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            break;
+        }
+        if (slot < NUM_BYTE_SLOTS - 1)
+        {
+            slot++;
+        }
+    }
+    return v;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     grid - Size of one quantization step in model units
+--| Return:
+--|     A LayerCodec Object
+--|-------------------------------------------------------------------------
+*/
+LayerCodec::LayerCodec(float grid) : grid(grid), shard(0), shards(0), job_layers(0)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the size of one quantization step
+--| Args:
+--|     none
+--| Return:
+--|     float - The grid step in model units
+--|-------------------------------------------------------------------------
+*/
+float LayerCodec::GetGrid() const
+{
+    return grid;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Marks the files written from now on as one shard of a job, so a
+--|     merge can tell which layers each file has to hold
+--| Args:
+--|     shard - Which shard, from 1 to shards
+--|     shards - How many shards the job is split into, 0 for a whole job
+--|     layers - Layers in the whole job
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void LayerCodec::SetShard(unsigned int shard, unsigned int shards, size_t layers)
+{
+    this->shard = shard;
+    this->shards = shards;
+    job_layers = layers;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets which shard of a job the last file read was
+--| Args:
+--|     shard - Gets which shard, from 1 to shards
+--|     shards - Gets how many shards the job is split into
+--|     layers - Gets the layers in the whole job
+--| Return:
+--|     bool - false if the file did not say, as for whole jobs and
+--|            files from before shards said so
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::GetShard(unsigned int &shard, unsigned int &shards, size_t &layers) const
+{
+    shard = this->shard;
+    shards = this->shards;
+    layers = job_layers;
+    return shards > 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Compresses the slicepieces of one layer
+--| Args:
+--|     layer - The slicepieces to encode, in output order
+--|     out - Buffer the compressed bytes get appended to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void LayerCodec::EncodeLayer(const std::vector<slicepiece> &layer, std::vector<unsigned char> &out) const
+{
+    ByteModel* model = new ByteModel;
+    RangeEncoder rc(out);
+    const double inv_grid = 1.0 / grid;
+    
+    // Previous endpoint on the grid
+    int64_t px = 0;
+    int64_t py = 0;
+    
+    for (size_t i = 0; i < layer.size(); i++)
+    {
+        int64_t ax = llround(layer[i].a.x * inv_grid);
+        int64_t ay = llround(layer[i].a.y * inv_grid);
+        int64_t bx = llround(layer[i].b.x * inv_grid);
+        int64_t by = llround(layer[i].b.y * inv_grid);
+        
+        // Continuing the contour, only the new endpoint is needed
+        if (ax == px && ay == py)
+        {
+            PutVarint(rc, *model, 0, (ZigZag(bx - ax) << 1) | 1);
+            PutVarint(rc, *model, 1, ZigZag(by - ay));
+        }
+        // Starting somewhere else
+        else
+        {
+            PutVarint(rc, *model, 0, ZigZag(ax - px) << 1);
+            PutVarint(rc, *model, 1, ZigZag(ay - py));
+            PutVarint(rc, *model, 2, ZigZag(bx - ax));
+            PutVarint(rc, *model, 3, ZigZag(by - ay));
+        }
+        px = bx;
+        py = by;
+    }
+    rc.Flush();
+    delete model;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Expands the compressed slicepieces of one layer
+--| Args:
+--|     data - Compressed bytes made by EncodeLayer
+--|     size - Number of compressed bytes
+--|     pieces - How many slicepieces were encoded
+--|     radius - Radius of the layer, used for the z coordinate
+--|     out - Vector the decoded slicepieces get appended to
+--| Return:
+--|     bool - false if there are more pieces than size bytes can hold, or
+--|            the data ran out before all pieces were decoded
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::DecodeLayer(const unsigned char* data, size_t size, size_t pieces, float radius, std::vector<slicepiece> &out) const
+{
+    if (pieces > MaxPieces(size))
+    {
+        return false;
+    }
+    ByteModel* model = new ByteModel;
+    RangeDecoder rc(data, size);
+    
+    int64_t px = 0;
+    int64_t py = 0;
+    
+    out.reserve(out.size() + pieces);
+    for (size_t i = 0; i < pieces; i++)
+    {
+        int64_t ax, ay;
+        uint64_t first = GetVarint(rc, *model, 0);
+        int64_t dx = UnZigZag(first >> 1);
+        int64_t dy = UnZigZag(GetVarint(rc, *model, 1));
+        
+        // Chained piece, the delta belongs to the second endpoint
+        if (first & 1)
+        {
+            ax = px;
+            ay = py;
+        }
+        else
+        {
+            ax = px + dx;
+            ay = py + dy;
+            dx = UnZigZag(GetVarint(rc, *model, 2));
+            dy = UnZigZag(GetVarint(rc, *model, 3));
+        }
+        px = ax + dx;
+        py = ay + dy;
+        
+        point a((float)(ax * (double)grid), (float)(ay * (double)grid), radius);
+        point b((float)(px * (double)grid), (float)(py * (double)grid), radius);
+        float distance = sqrt((b.x - a.x)*(b.x - a.x) + (b.y - a.y)*(b.y - a.y));
+        out.push_back(slicepiece(a, b, distance));
+    }
+    delete model;
+    
+    return !rc.Overrun();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes every sliced layer into a .slc file, encoding them in parallel
+--| Args:
+--|     layers - The sliced layers to write
+--|     file_name - Name of the output file
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::ExportBinary(const SlicedLayers* layers, const char* file_name) const
+{
+    std::vector<std::vector<unsigned char> > payloads;
+    return ExportBinary(layers, file_name, payloads, NULL);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes every sliced layer into a .slc file, keeping the encoded
+--|     layers so the next write only encodes the layers that changed
+--| Args:
+--|     layers - The sliced layers to write
+--|     file_name - Name of the output file
+--|     payloads - Encoded layers of the last write, updated. Everything
+--|                is encoded when it does not have one per layer
+--|     changed - Indices of the layers to encode again, NULL for all
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::ExportBinary(const SlicedLayers* layers, const char* file_name, std::vector<std::vector<unsigned char> > &payloads, const std::vector<size_t>* changed) const
+{
+    if (layers->GetSize() > SLC_MAX_LAYERS)
+    {
+        LogPrintf("ERROR %lu layers are more than the %u a .slc file may hold!\n", (unsigned long)layers->GetSize(), SLC_MAX_LAYERS);
+        return false;
+    }
+    OutputSink* f = OutputSink::Open(file_name);
+    if (!f)
+    {
+        LogPrintf("ERROR opening %s for writing!\n", file_name);
+        return false;
+    }
+    LogPrintf("Generating Output binary file %s now...\n", file_name);
+    
+    const size_t nLayers = layers->GetSize();
+    if (payloads.size() != nLayers)
+    {
+        payloads.assign(nLayers, std::vector<unsigned char>());
+        changed = NULL;
+    }
+    const size_t nEncode = changed ? changed->size() : nLayers;
+    ParallelFor(nEncode, [&](size_t k)
+    {
+        const size_t i = changed ? (*changed)[k] : k;
+        TRACE_SCOPE_ARG("encode layer", "layer", i);
+        payloads[i].clear();
+        if (layers->HasLayer(i))
+        {
+            EncodeLayer(layers->GetLayer(i), payloads[i]);
+        }
+    });
+    
+    bool ok = WriteHeader(f);
+    
+    // One record per layer, layers that were never sliced are left out
+    size_t raw_bytes = 0;
+    size_t packed_bytes = 0;
+    for (size_t i = 0; i < nLayers && ok; i++)
+    {
+        if (!layers->HasLayer(i))
+        {
+            continue;
+        }
+        const size_t pieces = layers->GetLayer(i).size();
+        ok = WriteRecord(f, (unsigned int)i, layers->GetLayerRadius(i), pieces, payloads[i]);
+        raw_bytes += pieces * sizeof(slicepiece);
+        packed_bytes += payloads[i].size() + 4 * sizeof(uint32_t);
+    }
+    ok = f->Close() && ok;
+    delete f;
+    
+    if (!ok)
+    {
+        LogPrintf("ERROR writing %s!\n", file_name);
+        return false;
+    }
+    LogPrintf("...Done! %lu bytes of slicepieces packed into %lu bytes\n\n", (unsigned long)raw_bytes, (unsigned long)packed_bytes);
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Starts a .slc file, for writers that stream records one at a time
+--| Args:
+--|     f - Sink of the new file
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::WriteHeader(OutputSink* f) const
+{
+    bool ok = f->Write(SLC_MAGIC, 4);
+    if (shards == 0)
+    {
+        ok = ok && f->Write(&SLC_VERSION, sizeof(uint32_t));
+        return ok && f->Write(&grid, sizeof(float));
+    }
+    const uint32_t share[3] = {shard, shards, (uint32_t)job_layers};
+    ok = ok && f->Write(&SLC_SHARD_VERSION, sizeof(uint32_t));
+    ok = ok && f->Write(&grid, sizeof(float));
+    return ok && f->Write(share, sizeof(share));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Appends one layer record to a .slc file
+--| Args:
+--|     f - Sink the header was written to
+--|     index - Number of the layer
+--|     radius - Radius of the layer
+--|     pieces - How many slicepieces were encoded
+--|     payload - Bytes made by EncodeLayer
+--| Return:
+--|     bool - true on success, false also for an index past what a
+--|            file may hold
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::WriteRecord(OutputSink* f, unsigned int index, float radius, size_t pieces, const std::vector<unsigned char> &payload) const
+{
+    if (index >= SLC_MAX_LAYERS)
+    {
+        LogPrintf("ERROR layer %u is past the %u layers a .slc file may hold!\n", index, SLC_MAX_LAYERS);
+        return false;
+    }
+    const uint32_t index32 = index;
+    const uint32_t pieces32 = (uint32_t)pieces;
+    const uint32_t bytes = (uint32_t)payload.size();
+    bool ok = f->Write(&index32, sizeof(uint32_t));
+    ok = ok && f->Write(&radius, sizeof(float));
+    ok = ok && f->Write(&pieces32, sizeof(uint32_t));
+    ok = ok && f->Write(&bytes, sizeof(uint32_t));
+    return ok && (bytes == 0 || f->Write(&payload[0], bytes));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reads a .slc file, decoding the layers in parallel. The grid and
+--|     shard of this codec are replaced by those in the file. Every record
+--|     is checked before anything is decoded: a layer past what a file
+--|     may hold, a layer stored twice, or more pieces than the payload
+--|     can hold fail the whole file.
+--| Args:
+--|     file_name - Name of the input file
+--|     layers - SlicedLayers the decoded layers are put into, at their
+--|              stored index
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool LayerCodec::ImportBinary(const char* file_name, SlicedLayers* layers)
+{
+    FILE* f = fopen(file_name, "rb");
+    if (!f)
+    {
+        LogPrintf("ERROR opening %s for reading!\n", file_name);
+        return false;
+    }
+    
+    // Slurp the whole file, the records are decoded straight out of memory
+    std::vector<unsigned char> buffer;
+    unsigned char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    
+    size_t header_size = 4 + sizeof(uint32_t) + sizeof(float);
+    const size_t record_size = 4 * sizeof(uint32_t);
+    uint32_t version = 0;
+    if (buffer.size() < header_size || memcmp(&buffer[0], SLC_MAGIC, 4) != 0)
+    {
+        LogPrintf("ERROR %s is not a slicyl binary file!\n", file_name);
+        return false;
+    }
+    memcpy(&version, &buffer[4], sizeof(uint32_t));
+    memcpy(&grid, &buffer[8], sizeof(float));
+    if (version != SLC_VERSION && version != SLC_SHARD_VERSION)
+    {
+        LogPrintf("ERROR %s has unsupported version %u!\n", file_name, version);
+        return false;
+    }
+    if (!(grid > 0.0f) || std::isinf(grid))
+    {
+        LogPrintf("ERROR %s has a bad grid of %g!\n", file_name, grid);
+        return false;
+    }
+    
+    // A shard says which one it is
+    uint32_t share[3] = {0, 0, 0};
+    if (version == SLC_SHARD_VERSION)
+    {
+        if (buffer.size() < header_size + sizeof(share))
+        {
+            LogPrintf("ERROR %s is truncated!\n", file_name);
+            return false;
+        }
+        memcpy(share, &buffer[header_size], sizeof(share));
+        header_size += sizeof(share);
+        if (share[1] == 0 || share[0] < 1 || share[0] > share[1] || share[2] > SLC_MAX_LAYERS)
+        {
+            LogPrintf("ERROR %s says it is shard %u/%u of %u layers!\n", file_name, share[0], share[1], share[2]);
+            return false;
+        }
+    }
+    SetShard(share[0], share[1], share[2]);
+    const uint32_t max_layers = share[1] > 0 ? share[2] : SLC_MAX_LAYERS;
+    
+    // Find where every record lives
+    struct Record
+    {
+        uint32_t index;
+        float radius;
+        uint32_t pieces;
+        uint32_t bytes;
+        size_t offset;
+    };
+    std::vector<Record> records;
+    std::vector<char> seen;
+    size_t pos = header_size;
+    while (pos + record_size <= buffer.size())
+    {
+        Record r;
+        memcpy(&r.index, &buffer[pos], sizeof(uint32_t));
+        memcpy(&r.radius, &buffer[pos + 4], sizeof(float));
+        memcpy(&r.pieces, &buffer[pos + 8], sizeof(uint32_t));
+        memcpy(&r.bytes, &buffer[pos + 12], sizeof(uint32_t));
+        r.offset = pos + record_size;
+        if (r.offset + r.bytes > buffer.size())
+        {
+            break;
+        }
+        
+        // Nothing is made room for until the record is known to make sense
+        if (r.index >= max_layers)
+        {
+            LogPrintf("ERROR record %lu of %s is for layer %u, past the %u it may hold!\n", (unsigned long)records.size(), file_name, r.index, max_layers);
+            return false;
+        }
+        if (r.pieces > MaxPieces(r.bytes))
+        {
+            LogPrintf("ERROR record %lu of %s claims %u pieces in %u bytes!\n", (unsigned long)records.size(), file_name, r.pieces, r.bytes);
+            return false;
+        }
+        if (r.index < seen.size() && seen[r.index])
+        {
+            LogPrintf("ERROR %s holds layer %u more than once!\n", file_name, r.index);
+            return false;
+        }
+        if (r.index >= seen.size())
+        {
+            seen.resize(r.index + 1, 0);
+        }
+        seen[r.index] = 1;
+        records.push_back(r);
+        pos = r.offset + r.bytes;
+    }
+    if (pos != buffer.size())
+    {
+        LogPrintf("ERROR %s is truncated!\n", file_name);
+        return false;
+    }
+    
+    std::vector<std::vector<slicepiece> > decoded(records.size());
+    std::vector<char> good(records.size(), 0);
+    ParallelFor(records.size(), [&](size_t i)
+    {
+        const Record &r = records[i];
+        good[i] = DecodeLayer(r.bytes ? &buffer[r.offset] : NULL, r.bytes, r.pieces, r.radius, decoded[i]);
+    });
+    
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        if (!good[i])
+        {
+            LogPrintf("ERROR layer %lu of %s is corrupt!\n", (unsigned long)i, file_name);
+            return false;
+        }
+        layers->SetLayer(records[i].index, decoded[i], records[i].radius);
+    }
+    return true;
+}
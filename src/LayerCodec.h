@@ -0,0 +1,228 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _LAYER_CODEC_H_
+#define _LAYER_CODEC_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "SlicedLayers.h"
+#include "OutputSink.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Compact binary codec for rolled out layers.
+--|
+--| Every slicepiece endpoint is quantized onto a fixed (x, arc) grid. The
+--| z coordinate is dropped since it is always the layer radius, and the
+--| distance is recomputed on decode. Each endpoint is stored as the
+--| zigzag varint delta from the previous endpoint, and a piece that starts
+--| where the previous one ended only costs its second endpoint. The varint
+--| bytes are then squeezed with an adaptive binary range coder.
+--|
+--| A .slc file is a small header followed by one self contained record
+--| per layer:
+--|     "SLCY" | uint32 version | float grid
+--|     { uint32 index | float radius | uint32 pieces | uint32 bytes | payload }*
+--| A shard of a bigger job is version 2 and also says which one it is:
+--|     "SLCY" | uint32 2 | float grid | uint32 shard | uint32 shards | uint32 layers
+--|-------------------------------------------------------------------------
+*/
+class LayerCodec
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     grid - Size of one quantization step in model units
+    --| Return:
+    --|     A LayerCodec Object
+    --|-------------------------------------------------------------------------
+    */
+    LayerCodec(float grid = 0.001f);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the size of one quantization step
+    --| Args:
+    --|     none
+    --| Return:
+    --|     float - The grid step in model units
+    --|-------------------------------------------------------------------------
+    */
+    float GetGrid() const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Marks the files written from now on as one shard of a job, so a
+    --|     merge can tell which layers each file has to hold
+    --| Args:
+    --|     shard - Which shard, from 1 to shards
+    --|     shards - How many shards the job is split into, 0 for a whole job
+    --|     layers - Layers in the whole job
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetShard(unsigned int shard, unsigned int shards, size_t layers);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets which shard of a job the last file read was
+    --| Args:
+    --|     shard - Gets which shard, from 1 to shards
+    --|     shards - Gets how many shards the job is split into
+    --|     layers - Gets the layers in the whole job
+    --| Return:
+    --|     bool - false if the file did not say, as for whole jobs and
+    --|            files from before shards said so
+    --|-------------------------------------------------------------------------
+    */
+    bool GetShard(unsigned int &shard, unsigned int &shards, size_t &layers) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Compresses the slicepieces of one layer
+    --| Args:
+    --|     layer - The slicepieces to encode, in output order
+    --|     out - Buffer the compressed bytes get appended to
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void EncodeLayer(const std::vector<slicepiece> &layer, std::vector<unsigned char> &out) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Expands the compressed slicepieces of one layer
+    --| Args:
+    --|     data - Compressed bytes made by EncodeLayer
+    --|     size - Number of compressed bytes
+    --|     pieces - How many slicepieces were encoded
+    --|     radius - Radius of the layer, used for the z coordinate
+    --|     out - Vector the decoded slicepieces get appended to
+    --| Return:
+    --|     bool - false if there are more pieces than size bytes can hold, or
+    --|            the data ran out before all pieces were decoded
+    --|-------------------------------------------------------------------------
+    */
+    bool DecodeLayer(const unsigned char* data, size_t size, size_t pieces, float radius, std::vector<slicepiece> &out) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Writes every sliced layer into a .slc file, encoding them in parallel
+    --| Args:
+    --|     layers - The sliced layers to write
+    --|     file_name - Name of the output file
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool ExportBinary(const SlicedLayers* layers, const char* file_name) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Writes every sliced layer into a .slc file, keeping the encoded
+    --|     layers so the next write only encodes the layers that changed
+    --| Args:
+    --|     layers - The sliced layers to write
+    --|     file_name - Name of the output file
+    --|     payloads - Encoded layers of the last write, updated. Everything
+    --|                is encoded when it does not have one per layer
+    --|     changed - Indices of the layers to encode again, NULL for all
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool ExportBinary(const SlicedLayers* layers, const char* file_name, std::vector<std::vector<unsigned char> > &payloads, const std::vector<size_t>* changed) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Starts a .slc file, for writers that stream records one at a time
+    --| Args:
+    --|     f - Sink of the new file
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool WriteHeader(OutputSink* f) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Appends one layer record to a .slc file
+    --| Args:
+    --|     f - Sink the header was written to
+    --|     index - Number of the layer
+    --|     radius - Radius of the layer
+    --|     pieces - How many slicepieces were encoded
+    --|     payload - Bytes made by EncodeLayer
+    --| Return:
+    --|     bool - true on success, false also for an index past what a
+    --|            file may hold
+    --|-------------------------------------------------------------------------
+    */
+    bool WriteRecord(OutputSink* f, unsigned int index, float radius, size_t pieces, const std::vector<unsigned char> &payload) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Reads a .slc file, decoding the layers in parallel. The grid and
+    --|     shard of this codec are replaced by those in the file. Every record
+    --|     is checked before anything is decoded: a layer past what a file
+    --|     may hold, a layer stored twice, or more pieces than the payload
+    --|     can hold fail the whole file.
+    --| Args:
+    --|     file_name - Name of the input file
+    --|     layers - SlicedLayers the decoded layers are put into, at their
+    --|              stored index
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool ImportBinary(const char* file_name, SlicedLayers* layers);
+
+private:
+    // Size of one quantization step in model units
+    float grid;
+    
+    // Which shard of how many the file is, shards is 0 for a whole job
+    unsigned int shard;
+    unsigned int shards;
+    
+    // Layers in the whole job the shard is part of
+    size_t job_layers;
+};
+
+#endif //_LAYER_CODEC_H_
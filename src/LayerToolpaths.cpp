@@ -0,0 +1,102 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "LayerToolpaths.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     none
+--| Return:
+--|     A LayerToolpaths Object
+--|-------------------------------------------------------------------------
+*/
+LayerToolpaths::LayerToolpaths(void)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Throws away all layers and makes room for a new set
+--| Args:
+--|     count - How many layers there will be
+--| Return:
+--|     None
+--|-------------------------------------------------------------------------
+*/
+void LayerToolpaths::Resize(size_t count)
+{
+    infill.clear();
+    infill.resize(count);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Get how many layers there are
+--| Args:
+--|     none
+--| Return:
+--|     size_t - How many layers there are
+--|-------------------------------------------------------------------------
+*/
+size_t LayerToolpaths::GetSize() const
+{
+    return infill.size();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the infill moves of a specific layer
+--| Args:
+--|     i - Which layer is being requested
+--| Return:
+--|     The infill slicepieces of the layer, in cutting order
+--|-------------------------------------------------------------------------
+*/
+const std::vector<slicepiece>& LayerToolpaths::GetInfill(int i) const
+{
+    return infill[i];
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the infill moves of a specific layer for filling in. Different
+--|     layers may be filled from different threads at the same time.
+--| Args:
+--|     i - Which layer is being requested
+--| Return:
+--|     The infill slicepieces of the layer
+--|-------------------------------------------------------------------------
+*/
+std::vector<slicepiece>& LayerToolpaths::GetInfill(int i)
+{
+    return infill[i];
+}
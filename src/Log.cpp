@@ -0,0 +1,92 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "Log.h"
+
+#include <atomic>
+#include <vector>
+#include <stdarg.h>
+#include <stdio.h>
+
+static std::atomic<LogHandler> log_handler(NULL);
+static std::atomic<void*> log_user(NULL);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets where messages go
+--| Args:
+--|     handler - Called with every message, NULL to drop them
+--|     user - Handed to the handler
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void SetLogHandler(LogHandler handler, void* user)
+{
+    log_user = user;
+    log_handler = handler;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Formats a message like printf and hands it to the handler, if any
+--| Args:
+--|     format - printf format string
+--|     ... - Values for the format
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void LogPrintf(const char* format, ...)
+{
+    LogHandler handler = log_handler;
+    if (!handler)
+    {
+        return;
+    }
+    
+    char line[1024];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0)
+    {
+        return;
+    }
+    if ((size_t)n < sizeof(line))
+    {
+        handler(line, log_user);
+        return;
+    }
+    
+    // Too long for the stack
+    std::vector<char> longer(n + 1);
+    va_start(args, format);
+    vsnprintf(&longer[0], longer.size(), format, args);
+    va_end(args);
+    handler(&longer[0], log_user);
+}
@@ -0,0 +1,71 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _LOG_H_
+#define _LOG_H_
+
+/*
+--|-------------------------------------------------------------------------
+--| Where the library's progress and error messages go.
+--|
+--| Nothing is printed until a handler is set, so code embedding the
+--| library keeps its stdout to itself. The slicyl program sets a handler
+--| that writes to stdout. Set the handler before slicing starts, messages
+--| may come from any thread.
+--|-------------------------------------------------------------------------
+*/
+
+/*
+--|-------------------------------------------------------------------------
+--| Receives one formatted message, which may be part of a line or several
+--|-------------------------------------------------------------------------
+*/
+typedef void (*LogHandler)(const char* message, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets where messages go
+--| Args:
+--|     handler - Called with every message, NULL to drop them
+--|     user - Handed to the handler
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void SetLogHandler(LogHandler handler, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Formats a message like printf and hands it to the handler, if any
+--| Args:
+--|     format - printf format string
+--|     ... - Values for the format
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void LogPrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#endif //_LOG_H_
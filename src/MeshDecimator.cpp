@@ -0,0 +1,301 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "MeshDecimator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdint.h>
+#include "Parallel.h"
+#include "Log.h"
+
+// Triangles handed to a worker at a time
+static const size_t DECIMATE_BLOCK = 4096;
+
+// Sums are kept in fixed point, this many steps per cell
+static const double CELL_FIXED = 1048576.0;
+
+// Marks a free slot of the cluster table
+static const uint64_t EMPTY_KEY = ~(uint64_t)0;
+
+// How many times the grid is coarsened before giving up on the budget
+static const int MAX_TRIES = 8;
+
+// Packs the cell of a vertex into one key, 21 bits per axis
+static inline uint64_t CellKey(const point &p, const point &lower, float inv_cell)
+{
+    uint64_t x = (uint64_t)std::min(2097151.0f, std::max(0.0f, (p.x - lower.x) * inv_cell));
+    uint64_t y = (uint64_t)std::min(2097151.0f, std::max(0.0f, (p.y - lower.y) * inv_cell));
+    uint64_t z = (uint64_t)std::min(2097151.0f, std::max(0.0f, (p.z - lower.z) * inv_cell));
+    return (x << 42) | (y << 21) | z;
+}
+
+// Spreads the bits of a key over the table
+static inline uint64_t HashKey(uint64_t key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     target_facets - Most Triangles the coarse copy may have
+--| Return:
+--|     A MeshDecimator Object
+--|-------------------------------------------------------------------------
+*/
+MeshDecimator::MeshDecimator(size_t target_facets) : target_facets(std::max((size_t)1, target_facets))
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Clusters the vertices on one grid
+--| Args:
+--|     mesh - The full resolution mesh
+--|     cell - Edge length of the grid cells
+--|     out - Gets the surviving Triangles
+--| Return:
+--|     bool - false if far more cells were hit than the budget allows
+--|-------------------------------------------------------------------------
+*/
+bool MeshDecimator::Cluster(const TriangleMesh* mesh, float cell, std::vector<Triangle> &out) const
+{
+    const size_t nTriangles = mesh->GetMeshSize();
+    const size_t nBlocks = (nTriangles + DECIMATE_BLOCK - 1) / DECIMATE_BLOCK;
+    point lower, upper;
+    mesh->GetBBox(lower, upper);
+    const float inv_cell = 1.0f / cell;
+    
+    // Open addressing table, a few times bigger than the clusters we want
+    size_t capacity = 1024;
+    while (capacity < target_facets * 4)
+    {
+        capacity <<= 1;
+    }
+    const size_t mask = capacity - 1;
+    std::vector<std::atomic<uint64_t> > keys(capacity);
+    std::vector<std::atomic<int64_t> > sums(capacity * 3);
+    std::vector<std::atomic<uint32_t> > counts(capacity);
+    for (size_t i = 0; i < capacity; i++)
+    {
+        keys[i].store(EMPTY_KEY, std::memory_order_relaxed);
+        sums[i*3].store(0, std::memory_order_relaxed);
+        sums[i*3+1].store(0, std::memory_order_relaxed);
+        sums[i*3+2].store(0, std::memory_order_relaxed);
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+    std::vector<uint32_t> corner_slot(nTriangles * 3);
+    std::atomic<size_t> used(0);
+    std::atomic<bool> overflow(false);
+    
+    // Find or claim the slot of every corner and add the corner to its sums
+    ParallelFor(nBlocks, [&](size_t b)
+    {
+        const size_t end = std::min(nTriangles, (b + 1) * DECIMATE_BLOCK);
+        for (size_t j = b * DECIMATE_BLOCK; j < end && !overflow; j++)
+        {
+            const Triangle &tri = mesh->GetTriangle(j);
+            for (int k = 0; k < 3; k++)
+            {
+                const point &p = tri.GetVertex(k);
+                const uint64_t key = CellKey(p, lower, inv_cell);
+                size_t slot = HashKey(key) & mask;
+                for (;;)
+                {
+                    uint64_t seen = keys[slot].load(std::memory_order_acquire);
+                    if (seen == EMPTY_KEY)
+                    {
+                        if (keys[slot].compare_exchange_strong(seen, key))
+                        {
+                            if (++used > capacity / 2)
+                            {
+                                overflow = true;
+                            }
+                            break;
+                        }
+                    }
+                    if (seen == key)
+                    {
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+                if (overflow)
+                {
+                    return;
+                }
+                corner_slot[j*3 + k] = (uint32_t)slot;
+                
+                // Offset from the cell corner in fixed point, exact to add up
+                const float cx = floorf((p.x - lower.x) * inv_cell);
+                const float cy = floorf((p.y - lower.y) * inv_cell);
+                const float cz = floorf((p.z - lower.z) * inv_cell);
+                sums[slot*3].fetch_add((int64_t)(((p.x - lower.x) * inv_cell - cx) * CELL_FIXED), std::memory_order_relaxed);
+                sums[slot*3+1].fetch_add((int64_t)(((p.y - lower.y) * inv_cell - cy) * CELL_FIXED), std::memory_order_relaxed);
+                sums[slot*3+2].fetch_add((int64_t)(((p.z - lower.z) * inv_cell - cz) * CELL_FIXED), std::memory_order_relaxed);
+                counts[slot].fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+    if (overflow)
+    {
+        return false;
+    }
+    
+    // Every cluster becomes the mean of its vertices
+    std::vector<point> centre(capacity);
+    ParallelFor((capacity + DECIMATE_BLOCK - 1) / DECIMATE_BLOCK, [&](size_t b)
+    {
+        const size_t end = std::min(capacity, (b + 1) * DECIMATE_BLOCK);
+        for (size_t i = b * DECIMATE_BLOCK; i < end; i++)
+        {
+            const uint32_t n = counts[i].load(std::memory_order_relaxed);
+            if (n == 0)
+            {
+                continue;
+            }
+            const uint64_t key = keys[i].load(std::memory_order_relaxed);
+            const double scale = 1.0 / (CELL_FIXED * n);
+            centre[i] = point(lower.x + (float)(((key >> 42) & 0x1FFFFF) + sums[i*3].load() * scale) * cell,
+                              lower.y + (float)(((key >> 21) & 0x1FFFFF) + sums[i*3+1].load() * scale) * cell,
+                              lower.z + (float)((key & 0x1FFFFF) + sums[i*3+2].load() * scale) * cell);
+        }
+    });
+    
+    // Keep the Triangles that still span three clusters, block by block in order
+    std::vector<std::vector<Triangle> > kept(nBlocks);
+    ParallelFor(nBlocks, [&](size_t b)
+    {
+        const size_t end = std::min(nTriangles, (b + 1) * DECIMATE_BLOCK);
+        for (size_t j = b * DECIMATE_BLOCK; j < end; j++)
+        {
+            const uint32_t a = corner_slot[j*3];
+            const uint32_t c1 = corner_slot[j*3 + 1];
+            const uint32_t c2 = corner_slot[j*3 + 2];
+            if (a == c1 || c1 == c2 || c2 == a)
+            {
+                continue;
+            }
+            const point &p0 = centre[a];
+            const point &p1 = centre[c1];
+            const point &p2 = centre[c2];
+            float ux = p1.x - p0.x, uy = p1.y - p0.y, uz = p1.z - p0.z;
+            float vx = p2.x - p0.x, vy = p2.y - p0.y, vz = p2.z - p0.z;
+            point n(uy*vz - uz*vy, uz*vx - ux*vz, ux*vy - uy*vx);
+            float len = sqrtf(n.x*n.x + n.y*n.y + n.z*n.z);
+            if (len == 0.0f)
+            {
+                continue;
+            }
+            kept[b].push_back(Triangle(point(n.x/len, n.y/len, n.z/len), p0, p1, p2));
+        }
+    });
+    
+    out.clear();
+    for (size_t b = 0; b < nBlocks; b++)
+    {
+        out.insert(out.end(), kept[b].begin(), kept[b].end());
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Builds the coarse copy, clustering in parallel
+--| Args:
+--|     mesh - The full resolution mesh
+--|     preview - Empty mesh that gets the coarse copy
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void MeshDecimator::Decimate(const TriangleMesh* mesh, TriangleMesh* preview) const
+{
+    const size_t nTriangles = mesh->GetMeshSize();
+    LogPrintf("Decimating %lu Triangles down to at most %lu...\n", (unsigned long)nTriangles, (unsigned long)target_facets);
+    
+    point lower, upper;
+    mesh->GetBBox(lower, upper);
+    std::vector<Triangle> coarse;
+    if (nTriangles <= target_facets)
+    {
+        coarse = mesh->GetMesh();
+    }
+    else
+    {
+        // A surface of area A covers about A / cell^2 cells, each worth about two Triangles
+        double area = 0.0;
+        for (size_t j = 0; j < nTriangles; j++)
+        {
+            const Triangle &tri = mesh->GetTriangle(j);
+            const point &a = tri.GetVertex(0);
+            const point &b = tri.GetVertex(1);
+            const point &c = tri.GetVertex(2);
+            double ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+            double vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+            double nx = uy*vz - uz*vy, ny = uz*vx - ux*vz, nz = ux*vy - uy*vx;
+            area += 0.5 * sqrt(nx*nx + ny*ny + nz*nz);
+        }
+        const point size = mesh->GetBBoxSize();
+        const float extent = std::max(size.x, std::max(size.y, size.z));
+        float cell = (float)sqrt(2.0 * area / target_facets);
+        cell = std::max(cell, extent / 2097151.0f);
+        
+        // Coarsen until it fits
+        int tries = 0;
+        for (;;)
+        {
+            bool fits = Cluster(mesh, cell, coarse);
+            if (fits && coarse.size() <= target_facets)
+            {
+                break;
+            }
+            if (++tries >= MAX_TRIES && fits)
+            {
+                LogPrintf("WARNING preview is still %lu Triangles\n", (unsigned long)coarse.size());
+                break;
+            }
+            cell *= fits ? 1.05f * sqrtf((float)coarse.size() / (float)target_facets) : 1.5f;
+        }
+    }
+    
+    for (size_t j = 0; j < coarse.size(); j++)
+    {
+        preview->AddTriangle(coarse[j]);
+    }
+    
+    // Same box as the full mesh so the layouts line up
+    preview->SetBBox(lower, upper);
+    LogPrintf("...Done! Preview has %lu Triangles\n\n", (unsigned long)preview->GetMeshSize());
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _MESH_DECIMATOR_H_
+#define _MESH_DECIMATOR_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that makes a coarse copy of a TriangleMesh for quick previews.
+--|
+--| Vertices are clustered on a uniform grid and every cluster is replaced
+--| by the mean of its vertices. Triangles whose corners end up in fewer
+--| than three clusters disappear. The grid is sized from the surface area
+--| so the copy lands near the facet budget, and is coarsened until it fits.
+--| The copy keeps the Bounding Box of the original, so previews line up
+--| with the full resolution slices.
+--|-------------------------------------------------------------------------
+*/
+class MeshDecimator
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     target_facets - Most Triangles the coarse copy may have
+    --| Return:
+    --|     A MeshDecimator Object
+    --|-------------------------------------------------------------------------
+    */
+    MeshDecimator(size_t target_facets);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Builds the coarse copy, clustering in parallel
+    --| Args:
+    --|     mesh - The full resolution mesh
+    --|     preview - Empty mesh that gets the coarse copy
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Decimate(const TriangleMesh* mesh, TriangleMesh* preview) const;
+
+private:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Clusters the vertices on one grid
+    --| Args:
+    --|     mesh - The full resolution mesh
+    --|     cell - Edge length of the grid cells
+    --|     out - Gets the surviving Triangles
+    --| Return:
+    --|     bool - false if far more cells were hit than the budget allows
+    --|-------------------------------------------------------------------------
+    */
+    bool Cluster(const TriangleMesh* mesh, float cell, std::vector<Triangle> &out) const;
+    
+    // Most Triangles the coarse copy may have
+    size_t target_facets;
+};
+
+#endif //_MESH_DECIMATOR_H_
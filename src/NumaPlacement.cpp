@@ -0,0 +1,311 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "NumaPlacement.h"
+#include "Log.h"
+
+#include <string>
+#include <thread>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Cores of every node that has any this process may use, set up by Enable
+static std::vector<std::vector<int> > node_cpus;
+
+// Node the calling thread is pinned to, -1 if none
+static thread_local int current_node = -1;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reads a kernel list like 0-3,8-11 from a file
+--| Args:
+--|     file_name - Name of the file
+--|     values - Gets every number in the list
+--| Return:
+--|     bool - false if the file could not be read
+--|-------------------------------------------------------------------------
+*/
+static bool ReadList(const std::string &file_name, std::vector<int> &values)
+{
+    FILE* f = fopen(file_name.c_str(), "r");
+    if (!f)
+    {
+        return false;
+    }
+    char line[4096];
+    const bool ok = fgets(line, sizeof(line), f) != NULL;
+    fclose(f);
+    if (!ok)
+    {
+        return false;
+    }
+    
+    char* p = line;
+    while (*p >= '0' && *p <= '9')
+    {
+        long first = strtol(p, &p, 10);
+        long last = first;
+        if (*p == '-')
+        {
+            last = strtol(p + 1, &p, 10);
+        }
+        for (long v = first; v <= last; v++)
+        {
+            values.push_back((int)v);
+        }
+        if (*p == ',')
+        {
+            p++;
+        }
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Pins the calling thread to some cores of a node
+--| Args:
+--|     node - The node
+--|     cpu - One of its cores, or -1 for all of them
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+static void PinToNode(size_t node, int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpu >= 0)
+    {
+        CPU_SET(cpu, &set);
+    }
+    else
+    {
+        for (size_t k = 0; k < node_cpus[node].size(); k++)
+        {
+            CPU_SET(node_cpus[node][k], &set);
+        }
+    }
+    // The calling thread only, left to roam if the kernel says no
+    if (sched_setaffinity(0, sizeof(set), &set) == 0)
+    {
+        current_node = (int)node;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Finds the NUMA nodes and the cores of each this process may run
+--|     on, and turns on pinning if there is more than one. Call before
+--|     any worker threads are started.
+--| Args:
+--|     node_dir - Where the kernel lists the nodes, NULL for
+--|                /sys/devices/system/node
+--| Return:
+--|     bool - true if there is more than one node to place things on
+--|-------------------------------------------------------------------------
+*/
+bool NumaPlacement::Enable(const char* node_dir)
+{
+    const std::string dir = node_dir ? node_dir : "/sys/devices/system/node";
+    node_cpus.clear();
+    
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        LogPrintf("NUMA placement is off, the allowed cores could not be read\n");
+        return false;
+    }
+    
+    // Nodes without memory or without a core we may use are left out
+    std::vector<int> nodes;
+    if (!ReadList(dir + "/has_memory", nodes) && !ReadList(dir + "/online", nodes))
+    {
+        LogPrintf("NUMA placement is off, %s lists no nodes\n", dir.c_str());
+        return false;
+    }
+    std::vector<std::vector<int> > found;
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        std::vector<int> cpus, usable;
+        ReadList(dir + "/node" + std::to_string(nodes[i]) + "/cpulist", cpus);
+        for (size_t k = 0; k < cpus.size(); k++)
+        {
+            if (cpus[k] < CPU_SETSIZE && CPU_ISSET(cpus[k], &allowed))
+            {
+                usable.push_back(cpus[k]);
+            }
+        }
+        if (!usable.empty())
+        {
+            found.push_back(usable);
+        }
+    }
+    if (found.size() < 2)
+    {
+        LogPrintf("NUMA placement is off, there is only one node to run on\n");
+        return false;
+    }
+    
+    node_cpus = found;
+    LogPrintf("NUMA placement over %lu nodes:", (unsigned long)node_cpus.size());
+    for (size_t n = 0; n < node_cpus.size(); n++)
+    {
+        LogPrintf(" %lu", (unsigned long)node_cpus[n].size());
+    }
+    LogPrintf(" cores\n");
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets how many nodes things are placed on
+--| Args:
+--|     none
+--| Return:
+--|     size_t - Number of nodes, 0 while not enabled
+--|-------------------------------------------------------------------------
+*/
+size_t NumaPlacement::GetNodeCount()
+{
+    return node_cpus.size();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Pins the calling worker thread to one core. Workers go round the
+--|     nodes in turn, then round the cores of each node. Does nothing
+--|     while not enabled.
+--| Args:
+--|     worker - Number of the worker in its pool or ParallelFor
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void NumaPlacement::PinWorker(size_t worker)
+{
+    const size_t nNodes = node_cpus.size();
+    if (nNodes == 0)
+    {
+        return;
+    }
+    const size_t node = worker % nNodes;
+    const std::vector<int> &cpus = node_cpus[node];
+    PinToNode(node, cpus[(worker / nNodes) % cpus.size()]);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor. Copies the mesh onto every node while enabled.
+--|     The mesh must not change while the copies are in use.
+--| Args:
+--|     mesh - The mesh to be sliced
+--| Return:
+--|     A NumaPlacement Object
+--|-------------------------------------------------------------------------
+*/
+NumaPlacement::NumaPlacement(const TriangleMesh* mesh) : mesh(mesh)
+{
+    const size_t nNodes = node_cpus.size();
+    if (nNodes == 0)
+    {
+        return;
+    }
+    
+    // Each copy is made from its own node, so its pages are first touched there
+    copies.assign(nNodes, (TriangleMesh*)NULL);
+    std::vector<std::thread> copiers;
+    for (size_t n = 0; n < nNodes; n++)
+    {
+        copiers.push_back(std::thread([this, n]()
+        {
+            PinToNode(n, -1);
+            copies[n] = new TriangleMesh(*this->mesh);
+        }));
+    }
+    for (size_t n = 0; n < copiers.size(); n++)
+    {
+        copiers[n].join();
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor, frees the copies
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+NumaPlacement::~NumaPlacement(void)
+{
+    for (size_t n = 0; n < copies.size(); n++)
+    {
+        delete copies[n];
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the mesh the calling thread should read
+--| Args:
+--|     none
+--| Return:
+--|     const TriangleMesh* - The copy on the thread's node, or the mesh
+--|                           itself for threads that were not pinned
+--|-------------------------------------------------------------------------
+*/
+const TriangleMesh* NumaPlacement::GetLocalMesh() const
+{
+    if (current_node < 0 || (size_t)current_node >= copies.size())
+    {
+        return mesh;
+    }
+    return copies[current_node];
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the mesh the copies were made of
+--| Args:
+--|     none
+--| Return:
+--|     const TriangleMesh* - The mesh as it was handed in
+--|-------------------------------------------------------------------------
+*/
+const TriangleMesh* NumaPlacement::GetMesh() const
+{
+    return mesh;
+}
@@ -0,0 +1,153 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _NUMA_PLACEMENT_H_
+#define _NUMA_PLACEMENT_H_
+
+#include <vector>
+
+#include "TriangleMesh.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that keeps worker threads next to the memory they read on
+--| machines with several NUMA nodes.
+--|
+--| Enable reads the nodes and their cores from sysfs. From then on every
+--| worker thread pins itself to a core, going round the nodes in turn, and
+--| a Slicer given a NumaPlacement reads the copy of the mesh on its own
+--| node: constructing a NumaPlacement copies the mesh once per node from a
+--| thread pinned there, so the kernel places each copy's pages on that node
+--| as they are first touched. Every layer reads every Triangle, so copying
+--| rather than splitting the Triangles is what keeps those reads local.
+--| A run makes one, once its mesh is final; meshes that are only sliced a
+--| part at a time, like out-of-core bands or --watch edits, are read where
+--| they are.
+--|
+--| With one node, or no sysfs, Enable does nothing and the mesh is used
+--| where it is.
+--|-------------------------------------------------------------------------
+*/
+class NumaPlacement
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Finds the NUMA nodes and the cores of each this process may run
+    --|     on, and turns on pinning if there is more than one. Call before
+    --|     any worker threads are started.
+    --| Args:
+    --|     node_dir - Where the kernel lists the nodes, NULL for
+    --|                /sys/devices/system/node
+    --| Return:
+    --|     bool - true if there is more than one node to place things on
+    --|-------------------------------------------------------------------------
+    */
+    static bool Enable(const char* node_dir = NULL);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets how many nodes things are placed on
+    --| Args:
+    --|     none
+    --| Return:
+    --|     size_t - Number of nodes, 0 while not enabled
+    --|-------------------------------------------------------------------------
+    */
+    static size_t GetNodeCount();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Pins the calling worker thread to one core. Workers go round the
+    --|     nodes in turn, then round the cores of each node. Does nothing
+    --|     while not enabled.
+    --| Args:
+    --|     worker - Number of the worker in its pool or ParallelFor
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    static void PinWorker(size_t worker);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor. Copies the mesh onto every node while enabled.
+    --|     The mesh must not change while the copies are in use.
+    --| Args:
+    --|     mesh - The mesh to be sliced
+    --| Return:
+    --|     A NumaPlacement Object
+    --|-------------------------------------------------------------------------
+    */
+    NumaPlacement(const TriangleMesh* mesh);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor, frees the copies
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    ~NumaPlacement(void);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the mesh the calling thread should read
+    --| Args:
+    --|     none
+    --| Return:
+    --|     const TriangleMesh* - The copy on the thread's node, or the mesh
+    --|                           itself for threads that were not pinned
+    --|-------------------------------------------------------------------------
+    */
+    const TriangleMesh* GetLocalMesh() const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the mesh the copies were made of
+    --| Args:
+    --|     none
+    --| Return:
+    --|     const TriangleMesh* - The mesh as it was handed in
+    --|-------------------------------------------------------------------------
+    */
+    const TriangleMesh* GetMesh() const;
+
+private:
+    // The mesh as it was handed in
+    const TriangleMesh* mesh;
+    
+    // One copy per node, first touched there
+    std::vector<TriangleMesh*> copies;
+};
+
+#endif //_NUMA_PLACEMENT_H_
@@ -0,0 +1,407 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "OutOfCoreSlicer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <stdint.h>
+#include "Parallel.h"
+#include "Log.h"
+#include "Trace.h"
+
+// A Triangle as it sits in the spool and band files: normal then three vertices
+struct SpoolTriangle
+{
+    float v[12];
+};
+
+// Roughly what a loaded Triangle costs while its band is sliced
+static const size_t BYTES_PER_TRIANGLE = 2 * sizeof(Triangle) + 3 * sizeof(LineSeg);
+
+// Most band files written at once, more bands take more passes over the spool
+static const size_t MAX_OPEN_BANDS = 64;
+
+// Triangles read or written at a time
+static const size_t SPOOL_CHUNK = 4096;
+
+// Reads an ASCII or binary STL, writing every Triangle to the spool and growing the box
+static bool SpoolSTL(const char* stl_file, FILE* spool, point &lower, point &upper, size_t &count)
+{
+    FILE* f = fopen(stl_file, "rb");
+    if (!f)
+    {
+        LogPrintf("ERROR opening %s!\n", stl_file);
+        return false;
+    }
+    
+    // A binary STL is exactly 84 bytes plus 50 per Triangle
+    unsigned char header[84];
+    bool binary = false;
+    uint32_t nFaces = 0;
+    if (fread(header, 1, 84, f) == 84)
+    {
+        memcpy(&nFaces, header + 80, 4);
+        fseek(f, 0, SEEK_END);
+        binary = (unsigned long)ftell(f) == 84UL + 50UL * nFaces;
+    }
+    
+    std::vector<SpoolTriangle> chunk;
+    chunk.reserve(SPOOL_CHUNK);
+    count = 0;
+    bool ok = true;
+    
+    // Hands a Triangle to the spool
+    auto add = [&](const float* v)
+    {
+        SpoolTriangle t;
+        memcpy(t.v, v, sizeof(t.v));
+        for (int k = 1; k < 4; k++)
+        {
+            lower.x = std::min(lower.x, v[k*3]);
+            lower.y = std::min(lower.y, v[k*3+1]);
+            lower.z = std::min(lower.z, v[k*3+2]);
+            upper.x = std::max(upper.x, v[k*3]);
+            upper.y = std::max(upper.y, v[k*3+1]);
+            upper.z = std::max(upper.z, v[k*3+2]);
+        }
+        chunk.push_back(t);
+        count++;
+        if (chunk.size() == SPOOL_CHUNK)
+        {
+            ok = ok && fwrite(&chunk[0], sizeof(SpoolTriangle), chunk.size(), spool) == chunk.size();
+            chunk.clear();
+        }
+    };
+    
+    if (binary)
+    {
+        fseek(f, 84, SEEK_SET);
+        unsigned char record[50];
+        float v[12];
+        for (uint32_t i = 0; i < nFaces && ok; i++)
+        {
+            if (fread(record, 1, 50, f) != 50)
+            {
+                ok = false;
+                break;
+            }
+            memcpy(v, record, sizeof(v));
+            add(v);
+        }
+        fclose(f);
+    }
+    else
+    {
+        fclose(f);
+        std::ifstream in(stl_file);
+        std::string s0, s1;
+        float v[12];
+        while (in >> s0 && ok)
+        {
+            // Same layout LoadSTLToMeshASCII reads
+            if (s0 == "facet")
+            {
+                in >> s0 >> v[0] >> v[1] >> v[2];
+                in >> s0 >> s1;
+                for (int k = 1; k < 4; k++)
+                {
+                    in >> s0 >> v[k*3] >> v[k*3+1] >> v[k*3+2];
+                }
+                in >> s0 >> s1;
+                add(v);
+            }
+            else if (s0 == "endsolid")
+            {
+                break;
+            }
+        }
+    }
+    if (!chunk.empty())
+    {
+        ok = ok && fwrite(&chunk[0], sizeof(SpoolTriangle), chunk.size(), spool) == chunk.size();
+    }
+    return ok;
+}
+
+// Radial extent of a spooled Triangle, and the first and last radius it can be cut at
+static bool LayerSpan(const SpoolTriangle &t, const std::vector<float> &radii, size_t &first, size_t &last)
+{
+    Triangle tri(point(t.v[0], t.v[1], t.v[2]), point(t.v[3], t.v[4], t.v[5]), point(t.v[6], t.v[7], t.v[8]), point(t.v[9], t.v[10], t.v[11]));
+    float r_min, r_max;
+    tri.GetRadialExtent(r_min, r_max);
+    first = std::lower_bound(radii.begin(), radii.end(), r_min) - radii.begin();
+    last = std::upper_bound(radii.begin(), radii.end(), r_max) - radii.begin();
+    if (last == 0 || first >= last)
+    {
+        return false;
+    }
+    last--;
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     memory_budget - Bytes one band of Triangles may take up
+--| Return:
+--|     An OutOfCoreSlicer Object
+--|-------------------------------------------------------------------------
+*/
+OutOfCoreSlicer::OutOfCoreSlicer(size_t memory_budget) : memory_budget(memory_budget)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices an STL file, ASCII or binary, into a .slc file. The
+--|     temporary files go next to the output and are removed after.
+--| Args:
+--|     stl_file - Name of the STL file
+--|     radii - Slicyl radii, smallest first
+--|     slicer - Slicer set up with the seam and region to use
+--|     codec - Codec the layers are written with
+--|     slc_file - Name of the output file
+--|     first_index - Layer number written for the first radius, for
+--|                   shards of a bigger job
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool OutOfCoreSlicer::SliceFile(const char* stl_file, const std::vector<float> &radii, Slicer &slicer, const LayerCodec &codec, const char* slc_file, size_t first_index) const
+{
+    char spool_name[1024];
+    snprintf(spool_name, sizeof(spool_name), "%s.spool", slc_file);
+    FILE* spool = fopen(spool_name, "w+b");
+    if (!spool)
+    {
+        LogPrintf("ERROR opening %s!\n", spool_name);
+        return false;
+    }
+    
+    // Pass one: parse the STL and find the box
+    LogPrintf("Spooling %s...\n", stl_file);
+    point lower(999999, 999999, 999999);
+    point upper(-999999, -999999, -999999);
+    size_t nTriangles = 0;
+    if (!SpoolSTL(stl_file, spool, lower, upper, nTriangles))
+    {
+        LogPrintf("ERROR spooling %s!\n", stl_file);
+        fclose(spool);
+        remove(spool_name);
+        return false;
+    }
+    const point centre = ((upper - lower)/2.0f) + lower;
+    LogPrintf("%lu Triangles, centred on %f, %f, %f\n", (unsigned long)nTriangles, centre.x, centre.y, centre.z);
+    
+    // Pass two: how many Triangles start and stop at each radius
+    const size_t nLayers = radii.size();
+    std::vector<size_t> starts(nLayers + 1, 0), ends(nLayers + 1, 0);
+    std::vector<SpoolTriangle> chunk(SPOOL_CHUNK);
+    rewind(spool);
+    for (size_t done = 0; done < nTriangles; )
+    {
+        size_t n = fread(&chunk[0], sizeof(SpoolTriangle), std::min(SPOOL_CHUNK, nTriangles - done), spool);
+        if (n == 0)
+        {
+            break;
+        }
+        TRACE_SCOPE_ARG("spool chunk", "triangles", n);
+        for (size_t i = 0; i < n; i++)
+        {
+            for (int k = 1; k < 4; k++)
+            {
+                chunk[i].v[k*3] -= centre.x;
+                chunk[i].v[k*3+1] -= centre.y;
+                chunk[i].v[k*3+2] -= centre.z;
+            }
+            size_t first, last;
+            if (LayerSpan(chunk[i], radii, first, last))
+            {
+                starts[first]++;
+                ends[last]++;
+            }
+        }
+        done += n;
+    }
+    
+    // Grow each band until its Triangles would not fit the budget
+    const size_t budget = std::max((size_t)1, memory_budget / BYTES_PER_TRIANGLE);
+    std::vector<size_t> band_first;
+    size_t started = 0;
+    size_t ended_before = 0;
+    for (size_t i = 0; i < nLayers; )
+    {
+        band_first.push_back(i);
+        size_t j = i;
+        started += starts[j];
+        while (j + 1 < nLayers && started + starts[j+1] - ended_before <= budget)
+        {
+            j++;
+            started += starts[j];
+        }
+        if (started - ended_before > budget)
+        {
+            LogPrintf("WARNING the layer at radius %f alone needs %lu Triangles\n", radii[i], (unsigned long)(started - ended_before));
+        }
+        for (size_t k = i; k <= j; k++)
+        {
+            ended_before += ends[k];
+        }
+        i = j + 1;
+    }
+    const size_t nBands = band_first.size();
+    band_first.push_back(nLayers);
+    LogPrintf("Slicing %lu layers in %lu bands of at most %lu Triangles\n", (unsigned long)nLayers, (unsigned long)nBands, (unsigned long)budget);
+    
+    // Pass three: sort the Triangles into band files, a group of bands at a time
+    std::vector<std::string> band_names(nBands);
+    for (size_t b = 0; b < nBands; b++)
+    {
+        char name[1024];
+        snprintf(name, sizeof(name), "%s.band%05lu", slc_file, (unsigned long)b);
+        band_names[b] = name;
+    }
+    bool ok = true;
+    for (size_t group = 0; group < nBands && ok; group += MAX_OPEN_BANDS)
+    {
+        const size_t group_end = std::min(nBands, group + MAX_OPEN_BANDS);
+        std::vector<FILE*> band_files(group_end - group, (FILE*)NULL);
+        for (size_t b = group; b < group_end; b++)
+        {
+            band_files[b - group] = fopen(band_names[b].c_str(), "wb");
+            ok = ok && band_files[b - group] != NULL;
+        }
+        rewind(spool);
+        for (size_t done = 0; done < nTriangles && ok; )
+        {
+            size_t n = fread(&chunk[0], sizeof(SpoolTriangle), std::min(SPOOL_CHUNK, nTriangles - done), spool);
+            if (n == 0)
+            {
+                ok = false;
+                break;
+            }
+            TRACE_SCOPE_ARG("sort chunk into bands", "triangles", n);
+            for (size_t i = 0; i < n; i++)
+            {
+                for (int k = 1; k < 4; k++)
+                {
+                    chunk[i].v[k*3] -= centre.x;
+                    chunk[i].v[k*3+1] -= centre.y;
+                    chunk[i].v[k*3+2] -= centre.z;
+                }
+                size_t first, last;
+                if (!LayerSpan(chunk[i], radii, first, last))
+                {
+                    continue;
+                }
+                size_t b = std::upper_bound(band_first.begin(), band_first.end(), first) - band_first.begin() - 1;
+                for (; b < group_end && band_first[b] <= last; b++)
+                {
+                    if (b >= group)
+                    {
+                        ok = ok && fwrite(&chunk[i], sizeof(SpoolTriangle), 1, band_files[b - group]) == 1;
+                    }
+                }
+            }
+            done += n;
+        }
+        for (size_t b = 0; b < band_files.size(); b++)
+        {
+            if (band_files[b])
+            {
+                ok = (fclose(band_files[b]) == 0) && ok;
+            }
+        }
+    }
+    fclose(spool);
+    remove(spool_name);
+    
+    // Last: slice band by band, streaming the layers out
+    OutputSink* out = OutputSink::Open(slc_file);
+    ok = ok && out != NULL && codec.WriteHeader(out);
+    for (size_t b = 0; b < nBands && ok; b++)
+    {
+        TriangleMesh band_mesh;
+        {
+            TRACE_SCOPE_ARG("load band", "band", b);
+            FILE* f = fopen(band_names[b].c_str(), "rb");
+            ok = f != NULL;
+            size_t n;
+            while (ok && (n = fread(&chunk[0], sizeof(SpoolTriangle), SPOOL_CHUNK, f)) > 0)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    const float* v = chunk[i].v;
+                    band_mesh.AddTriangle(Triangle(point(v[0], v[1], v[2]), point(v[3], v[4], v[5]), point(v[6], v[7], v[8]), point(v[9], v[10], v[11])));
+                }
+            }
+            if (f)
+            {
+                fclose(f);
+            }
+            remove(band_names[b].c_str());
+        }
+        
+        LogPrintf("Band %lu of %lu: %lu Triangles\n", (unsigned long)(b + 1), (unsigned long)nBands, (unsigned long)band_mesh.GetMeshSize());
+        std::vector<float> band_radii(radii.begin() + band_first[b], radii.begin() + band_first[b+1]);
+        SlicedLayers band_layers;
+        slicer.SliceMesh(&band_mesh, &band_layers, band_radii);
+        
+        std::vector<std::vector<unsigned char> > payloads(band_layers.GetSize());
+        ParallelFor(payloads.size(), [&](size_t i)
+        {
+            TRACE_SCOPE_ARG("encode layer", "layer", first_index + band_first[b] + i);
+            codec.EncodeLayer(band_layers.GetLayer(i), payloads[i]);
+        });
+        for (size_t i = 0; i < payloads.size() && ok; i++)
+        {
+            ok = codec.WriteRecord(out, (unsigned int)(first_index + band_first[b] + i), band_layers.GetLayerRadius(i), band_layers.GetLayer(i).size(), payloads[i]);
+        }
+    }
+    for (size_t b = 0; b < nBands; b++)
+    {
+        remove(band_names[b].c_str());
+    }
+    if (out)
+    {
+        ok = out->Close() && ok;
+        delete out;
+    }
+    
+    if (!ok)
+    {
+        LogPrintf("ERROR slicing %s out of core!\n", stl_file);
+        return false;
+    }
+    LogPrintf("...Done! %lu layers written to %s\n\n", (unsigned long)nLayers, slc_file);
+    return true;
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _OUT_OF_CORE_SLICER_H_
+#define _OUT_OF_CORE_SLICER_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "Slicer.h"
+#include "LayerCodec.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that slices STL files too big to hold in memory.
+--|
+--| The STL is parsed once into a spool file while its Bounding Box is
+--| found. The Triangles are then centred like BBoxMoveCOG would and sorted
+--| into band files, one per run of consecutive radii, a Triangle going
+--| into every band whose radii fall inside its [r_min, r_max]. Bands are
+--| sized so one band's Triangles fit the memory budget. Each band is then
+--| loaded, sliced and its layers streamed straight into the .slc file, so
+--| neither the whole mesh nor all the layers are ever held at once.
+--|-------------------------------------------------------------------------
+*/
+class OutOfCoreSlicer
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     memory_budget - Bytes one band of Triangles may take up
+    --| Return:
+    --|     An OutOfCoreSlicer Object
+    --|-------------------------------------------------------------------------
+    */
+    OutOfCoreSlicer(size_t memory_budget);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Slices an STL file, ASCII or binary, into a .slc file. The
+    --|     temporary files go next to the output and are removed after.
+    --| Args:
+    --|     stl_file - Name of the STL file
+    --|     radii - Slicyl radii, smallest first
+    --|     slicer - Slicer set up with the seam and region to use
+    --|     codec - Codec the layers are written with
+    --|     slc_file - Name of the output file
+    --|     first_index - Layer number written for the first radius, for
+    --|                   shards of a bigger job
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool SliceFile(const char* stl_file, const std::vector<float> &radii, Slicer &slicer, const LayerCodec &codec, const char* slc_file, size_t first_index = 0) const;
+
+private:
+    // Bytes one band of Triangles may take up
+    size_t memory_budget;
+};
+
+#endif //_OUT_OF_CORE_SLICER_H_
@@ -0,0 +1,282 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "OutputSink.h"
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "PwriteSink.h"
+#include "UringSink.h"
+#include "Log.h"
+#include "Trace.h"
+
+// How files opened from now on are written
+static OutputSink::Backend default_backend = OutputSink::SINK_AUTO;
+static bool default_direct = false;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses how every file opened from now on is written
+--| Args:
+--|     backend - SINK_AUTO (the default) takes io_uring where the system
+--|               has it and pwrite otherwise, SINK_PWRITE always pwrite
+--|     direct - Open files with O_DIRECT where the file system allows it
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void OutputSink::SetDefaults(Backend backend, bool direct)
+{
+    default_backend = backend;
+    default_direct = direct;
+    if (backend == SINK_URING && !UringSink::Available())
+    {
+        LogPrintf("io_uring is not available here, writing with pwrite\n");
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Creates or truncates a file and gets a sink writing it
+--| Args:
+--|     file_name - Name of the file
+--| Return:
+--|     OutputSink* - The sink, to be closed and deleted, NULL if the
+--|                   file cannot be opened
+--|-------------------------------------------------------------------------
+*/
+OutputSink* OutputSink::Open(const char* file_name)
+{
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+    bool direct = false;
+#ifdef O_DIRECT
+    // Not every file system takes O_DIRECT, those get the page cache
+    if (default_direct)
+    {
+        fd = open(file_name, flags | O_DIRECT, 0644);
+        direct = fd >= 0;
+    }
+#endif
+    if (fd < 0)
+    {
+        fd = open(file_name, flags, 0644);
+    }
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    if (default_backend != SINK_PWRITE && UringSink::Available())
+    {
+        return new UringSink(fd, file_name, direct);
+    }
+    return new PwriteSink(fd, file_name, direct);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     fd - The open file
+--|     file_name - Name of the file, for messages
+--|     direct - Whether fd was opened with O_DIRECT
+--| Return:
+--|     An OutputSink Object
+--|-------------------------------------------------------------------------
+*/
+OutputSink::OutputSink(int fd, const char* file_name, bool direct) : fd(fd), file_name(file_name), direct(direct), buffer(NULL), used(0), offset(0), failed(false)
+{
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor. Backends close the file if Close was not called.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+OutputSink::~OutputSink()
+{
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Appends bytes to the file
+--| Args:
+--|     data - The bytes
+--|     size - Number of bytes
+--| Return:
+--|     bool - false once anything failed to be written
+--|-------------------------------------------------------------------------
+*/
+bool OutputSink::Write(const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    while (size > 0 && !failed)
+    {
+        if (!buffer && !(buffer = GetBuffer()))
+        {
+            failed = true;
+            break;
+        }
+        size_t n = std::min(size, SINK_BUFFER_SIZE - used);
+        memcpy(buffer + used, bytes, n);
+        used += n;
+        bytes += n;
+        size -= n;
+        if (used == SINK_BUFFER_SIZE)
+        {
+            Flush();
+        }
+    }
+    return !failed;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Appends printf formatted text to the file, formatting it straight
+--|     into the buffer
+--| Args:
+--|     format - printf format
+--| Return:
+--|     bool - false once anything failed to be written
+--|-------------------------------------------------------------------------
+*/
+bool OutputSink::Printf(const char* format, ...)
+{
+    if (!buffer && !failed && !(buffer = GetBuffer()))
+    {
+        failed = true;
+    }
+    if (failed)
+    {
+        return false;
+    }
+    const size_t space = SINK_BUFFER_SIZE - used;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf((char*)buffer + used, space, format, args);
+    va_end(args);
+    if (n < 0)
+    {
+        failed = true;
+        return false;
+    }
+    if ((size_t)n < space)
+    {
+        used += (size_t)n;
+        return true;
+    }
+    
+    // Ran off the end of the buffer, format it again on the side
+    std::vector<char> text((size_t)n + 1);
+    va_start(args, format);
+    vsnprintf(&text[0], text.size(), format, args);
+    va_end(args);
+    return Write(&text[0], (size_t)n);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes what is left, waits for every write and closes the file
+--| Args:
+--|     none
+--| Return:
+--|     bool - true if the whole file was written
+--|-------------------------------------------------------------------------
+*/
+bool OutputSink::Close()
+{
+    if (fd < 0)
+    {
+        return !failed;
+    }
+    TRACE_SCOPE("close file");
+    const uint64_t length = offset + used;
+    if (buffer && used > 0)
+    {
+        Flush();
+    }
+    failed = !Finish() || failed;
+    
+    // O_DIRECT wrote the last buffer padded out
+    if (direct && ftruncate(fd, (off_t)length) != 0)
+    {
+        failed = true;
+    }
+    if (close(fd) != 0)
+    {
+        failed = true;
+    }
+    fd = -1;
+    if (failed)
+    {
+        LogPrintf("ERROR writing %s!\n", file_name.c_str());
+    }
+    return !failed;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Submits the buffer being filled
+--| Args:
+--|     none
+--| Return:
+--|     bool - false if it could not be submitted
+--|-------------------------------------------------------------------------
+*/
+bool OutputSink::Flush()
+{
+    TRACE_SCOPE_ARG("write buffer", "bytes", used);
+    size_t size = used;
+    if (direct && size % SINK_ALIGN != 0)
+    {
+        const size_t padded = (size + SINK_ALIGN - 1) / SINK_ALIGN * SINK_ALIGN;
+        memset(buffer + size, 0, padded - size);
+        size = padded;
+    }
+    if (!Submit(buffer, size, offset))
+    {
+        failed = true;
+    }
+    offset += used;
+    used = 0;
+    buffer = NULL;
+    return !failed;
+}
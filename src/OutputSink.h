@@ -0,0 +1,224 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef _OUTPUT_SINK_H_
+#define _OUTPUT_SINK_H_
+
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+
+// Bytes in one buffer handed to the disk, a multiple of SINK_ALIGN
+static const size_t SINK_BUFFER_SIZE = 1 << 20;
+
+// Alignment of the buffers and of every write with O_DIRECT
+static const size_t SINK_ALIGN = 4096;
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that every exporter writes its files through.
+--|
+--| Writes and formatted text are gathered into large aligned buffers and
+--| each full buffer is handed to a backend to put on disk at its offset,
+--| so the caller only ever copies into memory. A backend gives out the
+--| buffers and decides how they are written: UringSink queues them on an
+--| io_uring and carries on filling the next one, PwriteSink writes them
+--| with pwrite before returning and works anywhere. Open picks one for
+--| every file, and with O_DIRECT the last buffer is padded to SINK_ALIGN
+--| and the file cut back to its length on Close.
+--|-------------------------------------------------------------------------
+*/
+class OutputSink
+{
+public:
+    enum Backend
+    {
+        SINK_AUTO,
+        SINK_URING,
+        SINK_PWRITE
+    };
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Chooses how every file opened from now on is written
+    --| Args:
+    --|     backend - SINK_AUTO (the default) takes io_uring where the system
+    --|               has it and pwrite otherwise, SINK_PWRITE always pwrite
+    --|     direct - Open files with O_DIRECT where the file system allows it
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    static void SetDefaults(Backend backend, bool direct);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Creates or truncates a file and gets a sink writing it
+    --| Args:
+    --|     file_name - Name of the file
+    --| Return:
+    --|     OutputSink* - The sink, to be closed and deleted, NULL if the
+    --|                   file cannot be opened
+    --|-------------------------------------------------------------------------
+    */
+    static OutputSink* Open(const char* file_name);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor. Backends close the file if Close was not called.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    virtual ~OutputSink();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Appends bytes to the file
+    --| Args:
+    --|     data - The bytes
+    --|     size - Number of bytes
+    --| Return:
+    --|     bool - false once anything failed to be written
+    --|-------------------------------------------------------------------------
+    */
+    bool Write(const void* data, size_t size);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Appends printf formatted text to the file, formatting it straight
+    --|     into the buffer
+    --| Args:
+    --|     format - printf format
+    --| Return:
+    --|     bool - false once anything failed to be written
+    --|-------------------------------------------------------------------------
+    */
+    bool Printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Writes what is left, waits for every write and closes the file
+    --| Args:
+    --|     none
+    --| Return:
+    --|     bool - true if the whole file was written
+    --|-------------------------------------------------------------------------
+    */
+    bool Close();
+
+protected:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     fd - The open file
+    --|     file_name - Name of the file, for messages
+    --|     direct - Whether fd was opened with O_DIRECT
+    --| Return:
+    --|     An OutputSink Object
+    --|-------------------------------------------------------------------------
+    */
+    OutputSink(int fd, const char* file_name, bool direct);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets an empty buffer to fill
+    --| Args:
+    --|     none
+    --| Return:
+    --|     unsigned char* - SINK_BUFFER_SIZE bytes aligned to SINK_ALIGN,
+    --|                      NULL if there is none
+    --|-------------------------------------------------------------------------
+    */
+    virtual unsigned char* GetBuffer() = 0;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Writes a filled buffer at its place in the file. The buffer is
+    --|     the backend's again once this is called.
+    --| Args:
+    --|     buffer - A buffer from GetBuffer
+    --|     size - Bytes to write
+    --|     offset - Where in the file they go
+    --| Return:
+    --|     bool - false if the write could not be started
+    --|-------------------------------------------------------------------------
+    */
+    virtual bool Submit(unsigned char* buffer, size_t size, uint64_t offset) = 0;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Waits for every submitted write of this file
+    --| Args:
+    --|     none
+    --| Return:
+    --|     bool - true if all of them wrote everything
+    --|-------------------------------------------------------------------------
+    */
+    virtual bool Finish() = 0;
+    
+    // The open file, -1 once closed
+    int fd;
+
+private:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Submits the buffer being filled
+    --| Args:
+    --|     none
+    --| Return:
+    --|     bool - false if it could not be submitted
+    --|-------------------------------------------------------------------------
+    */
+    bool Flush();
+    
+    // Name of the file, for messages
+    std::string file_name;
+    // Whether fd was opened with O_DIRECT
+    bool direct;
+    // Buffer being filled, NULL until the first byte
+    unsigned char* buffer;
+    // Bytes in it
+    size_t used;
+    // Where in the file the buffer goes
+    uint64_t offset;
+    // Whether anything failed so far
+    bool failed;
+};
+
+#endif //_OUTPUT_SINK_H_
@@ -0,0 +1,122 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+
+#include "WorkPool.h"
+#include "NumaPlacement.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets how many worker threads the parallel stages should use.
+--|     Defaults to the hardware concurrency and can be overridden with
+--|     the SLICYL_THREADS environment variable
+--| Args:
+--|     none
+--| Return:
+--|     size_t - Number of worker threads, at least one
+--|-------------------------------------------------------------------------
+*/
+inline size_t GetThreadCount()
+{
+    const char* env = getenv("SLICYL_THREADS");
+    if (env)
+    {
+        long n = strtol(env, NULL, 10);
+        if (n > 0)
+        {
+            return (size_t)n;
+        }
+    }
+    size_t n = std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Calls fn(i) for every i in [0, count) spread over the worker threads.
+--|     Indices are handed out one at a time so uneven layers balance out.
+--|     On a WorkPool worker the pool's threads are used instead. The
+--|     threads are pinned with NumaPlacement when it is enabled.
+--| Args:
+--|     count - Number of work items
+--|     fn - Callable taking a size_t index
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+template <typename Func>
+void ParallelFor(size_t count, Func fn)
+{
+    // Already sharing a pool with other jobs, let it spread the work
+    WorkPool* pool = WorkPool::GetCurrent();
+    if (pool)
+    {
+        pool->ForEach(count, std::function<void(size_t)>(fn));
+        return;
+    }
+    
+    size_t n_threads = GetThreadCount();
+    if (n_threads > count)
+    {
+        n_threads = count;
+    }
+    
+    // Not worth spinning up threads for this
+    if (n_threads <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            fn(i);
+        }
+        return;
+    }
+    
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < n_threads; t++)
+    {
+        workers.push_back(std::thread([&, t]()
+        {
+            NumaPlacement::PinWorker(t);
+            for (size_t i = next++; i < count; i = next++)
+            {
+                fn(i);
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+}
+
+#endif //_PARALLEL_H_
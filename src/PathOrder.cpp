@@ -0,0 +1,515 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "PathOrder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include "Parallel.h"
+#include "Log.h"
+#include "Trace.h"
+
+// A run of chained slicepieces that can be cut without lifting
+struct PathSpan
+{
+    size_t first;
+    size_t count;
+    bool closed;
+};
+
+// One way to cut a path: where to start and in which direction
+struct PathVisit
+{
+    size_t path;
+    size_t start;
+    bool reversed;
+};
+
+// Travel is measured on the rolled out sheet
+static inline double SheetDistance(const point &a, const point &b)
+{
+    double dx = (double)b.x - a.x;
+    double dy = (double)b.y - a.y;
+    return sqrt(dx*dx + dy*dy);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Uniform grid of points on the rolled out sheet. Entries carry an id and
+--| can be dropped lazily once the caller no longer wants them.
+--|-------------------------------------------------------------------------
+*/
+class PointGrid
+{
+public:
+    struct Entry
+    {
+        float x;
+        float y;
+        size_t id;
+    };
+    
+    // Sizes the grid so there are about as many cells as points
+    PointGrid(const std::vector<point> &points)
+    {
+        float min_x = std::numeric_limits<float>::max();
+        float min_y = min_x;
+        float max_x = -min_x;
+        float max_y = -min_x;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            min_x = std::min(min_x, points[i].x);
+            min_y = std::min(min_y, points[i].y);
+            max_x = std::max(max_x, points[i].x);
+            max_y = std::max(max_y, points[i].y);
+        }
+        if (points.empty())
+        {
+            min_x = min_y = max_x = max_y = 0.0f;
+        }
+        origin_x = min_x;
+        origin_y = min_y;
+        float w = std::max(max_x - min_x, 1e-6f);
+        float h = std::max(max_y - min_y, 1e-6f);
+        cell = std::max(sqrtf(w * h / (float)std::max(points.size(), (size_t)1)), std::max(w, h) / 4096.0f);
+        nx = (int)(w / cell) + 1;
+        ny = (int)(h / cell) + 1;
+        cells.resize((size_t)nx * ny);
+    }
+    
+    void Insert(const point &p, size_t id)
+    {
+        Entry e = {p.x, p.y, id};
+        cells[CellX(p.x) + (size_t)nx * CellY(p.y)].push_back(e);
+    }
+    
+    float GetExtent() const
+    {
+        return std::max(nx, ny) * cell;
+    }
+    
+    // Any live entry within eps of p, or false. live(id) says whether an entry still counts.
+    template <typename Live>
+    bool FindNear(const point &p, float eps, Live live, size_t &id)
+    {
+        int x0 = CellX(p.x - eps), x1 = CellX(p.x + eps);
+        int y0 = CellY(p.y - eps), y1 = CellY(p.y + eps);
+        for (int cy = y0; cy <= y1; cy++)
+        {
+            for (int cx = x0; cx <= x1; cx++)
+            {
+                std::vector<Entry> &c = cells[cx + (size_t)nx * cy];
+                for (size_t k = 0; k < c.size(); k++)
+                {
+                    if (fabsf(c[k].x - p.x) <= eps && fabsf(c[k].y - p.y) <= eps && live(c[k].id))
+                    {
+                        id = c[k].id;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+    
+    // Nearest live entry to p searching outward ring by ring, dropping dead entries on the way
+    template <typename Live>
+    bool FindNearest(const point &p, Live live, size_t &id)
+    {
+        int cx = CellX(p.x);
+        int cy = CellY(p.y);
+        double best = std::numeric_limits<double>::max();
+        bool found = false;
+        int rings = std::max(nx, ny);
+        for (int ring = 0; ring <= rings; ring++)
+        {
+            for (int y = cy - ring; y <= cy + ring; y++)
+            {
+                if (y < 0 || y >= ny)
+                {
+                    continue;
+                }
+                // Whole rows at the top and bottom of the ring, just the sides in between
+                int step = (y == cy - ring || y == cy + ring) ? 1 : std::max(2 * ring, 1);
+                for (int x = cx - ring; x <= cx + ring; x += step)
+                {
+                    if (x < 0 || x >= nx)
+                    {
+                        continue;
+                    }
+                    std::vector<Entry> &c = cells[x + (size_t)nx * y];
+                    for (size_t k = 0; k < c.size(); )
+                    {
+                        if (!live(c[k].id))
+                        {
+                            c[k] = c.back();
+                            c.pop_back();
+                            continue;
+                        }
+                        double dx = (double)c[k].x - p.x;
+                        double dy = (double)c[k].y - p.y;
+                        double d = dx*dx + dy*dy;
+                        if (d < best)
+                        {
+                            best = d;
+                            id = c[k].id;
+                            found = true;
+                        }
+                        k++;
+                    }
+                }
+            }
+            // Nothing further out can beat what we have
+            if (found && sqrt(best) <= ring * (double)cell)
+            {
+                break;
+            }
+        }
+        return found;
+    }
+
+private:
+    int CellX(float x) const
+    {
+        int c = (int)((x - origin_x) / cell);
+        return c < 0 ? 0 : (c >= nx ? nx - 1 : c);
+    }
+    
+    int CellY(float y) const
+    {
+        int c = (int)((y - origin_y) / cell);
+        return c < 0 ? 0 : (c >= ny ? ny - 1 : c);
+    }
+
+    float origin_x;
+    float origin_y;
+    float cell;
+    int nx;
+    int ny;
+    std::vector<std::vector<Entry> > cells;
+};
+
+// Flips a slicepiece end for end
+static inline slicepiece Flipped(const slicepiece &sp)
+{
+    return slicepiece(sp.b, sp.a, sp.distance);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chains slicepieces whose ends touch into paths. Pieces are flipped
+--|     as needed so each path runs end to start.
+--| Args:
+--|     pieces - The moves of one layer
+--|     chained - Gets the pieces path by path
+--|     paths - Gets where each path lives in chained
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+static void ChainPieces(const std::vector<slicepiece> &pieces, std::vector<slicepiece> &chained, std::vector<PathSpan> &paths)
+{
+    std::vector<point> ends(pieces.size() * 2);
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        ends[2*i] = pieces[i].a;
+        ends[2*i + 1] = pieces[i].b;
+    }
+    PointGrid grid(ends);
+    for (size_t i = 0; i < ends.size(); i++)
+    {
+        grid.Insert(ends[i], i);
+    }
+    
+    // Ends computed from the same edge by two triangles only differ by rounding
+    const float eps = 1e-5f * grid.GetExtent();
+    std::vector<char> used(pieces.size(), 0);
+    std::vector<slicepiece> head;
+    std::vector<slicepiece> tail;
+    
+    for (size_t s = 0; s < pieces.size(); s++)
+    {
+        if (used[s])
+        {
+            continue;
+        }
+        used[s] = 1;
+        tail.clear();
+        head.clear();
+        tail.push_back(pieces[s]);
+        
+        size_t end;
+        bool closed = false;
+        
+        // Grow forward from the last piece
+        while (grid.FindNear(tail.back().b, eps, [&](size_t e) { return !used[e / 2]; }, end))
+        {
+            used[end / 2] = 1;
+            tail.push_back((end & 1) ? Flipped(pieces[end / 2]) : pieces[end / 2]);
+            if (SheetDistance(tail.back().b, tail[0].a) <= eps)
+            {
+                closed = true;
+                break;
+            }
+        }
+        
+        // And backward from the first
+        while (!closed && grid.FindNear(tail[0].a, eps, [&](size_t e) { return !used[e / 2]; }, end))
+        {
+            used[end / 2] = 1;
+            head.push_back((end & 1) ? pieces[end / 2] : Flipped(pieces[end / 2]));
+            if (SheetDistance(head.back().a, tail.back().b) <= eps)
+            {
+                closed = true;
+            }
+        }
+        
+        PathSpan span = {chained.size(), head.size() + tail.size(), closed};
+        chained.insert(chained.end(), head.rbegin(), head.rend());
+        chained.insert(chained.end(), tail.begin(), tail.end());
+        paths.push_back(span);
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     refine_ms - Time in milliseconds each layer may spend on 2-opt, 0 skips it
+--| Return:
+--|     A PathOrder Object
+--|-------------------------------------------------------------------------
+*/
+PathOrder::PathOrder(double refine_ms) : refine_ms(refine_ms)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds up the jumps between the end of each move and the start of
+--|     the next
+--| Args:
+--|     pieces - The moves in cutting order
+--| Return:
+--|     double - Total travel distance
+--|-------------------------------------------------------------------------
+*/
+double PathOrder::TravelDistance(const std::vector<slicepiece> &pieces)
+{
+    double travel = 0.0;
+    for (size_t i = 1; i < pieces.size(); i++)
+    {
+        travel += SheetDistance(pieces[i-1].b, pieces[i].a);
+    }
+    return travel;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reorders the moves of one layer. Pieces may be flipped end for end.
+--| Args:
+--|     pieces - The moves to reorder, in place
+--|     travel_before - If not NULL gets the travel of the original order
+--| Return:
+--|     double - Travel distance of the new order
+--|-------------------------------------------------------------------------
+*/
+double PathOrder::OrderLayer(std::vector<slicepiece> &pieces, double* travel_before) const
+{
+    if (travel_before)
+    {
+        *travel_before = TravelDistance(pieces);
+    }
+    if (pieces.size() < 2)
+    {
+        return TravelDistance(pieces);
+    }
+    
+    std::vector<slicepiece> chained;
+    std::vector<PathSpan> paths;
+    ChainPieces(pieces, chained, paths);
+    
+    // Every place a path may be started: both ends of an open path, any
+    // corner of a closed loop
+    std::vector<PathVisit> options;
+    std::vector<point> option_points;
+    for (size_t p = 0; p < paths.size(); p++)
+    {
+        const PathSpan &ps = paths[p];
+        if (ps.closed)
+        {
+            for (size_t k = 0; k < ps.count; k++)
+            {
+                PathVisit v = {p, k, false};
+                options.push_back(v);
+                option_points.push_back(chained[ps.first + k].a);
+            }
+        }
+        else
+        {
+            PathVisit fwd = {p, 0, false};
+            PathVisit rev = {p, 0, true};
+            options.push_back(fwd);
+            option_points.push_back(chained[ps.first].a);
+            options.push_back(rev);
+            option_points.push_back(chained[ps.first + ps.count - 1].b);
+        }
+    }
+    PointGrid grid(option_points);
+    for (size_t i = 0; i < options.size(); i++)
+    {
+        grid.Insert(option_points[i], i);
+    }
+    
+    // Where a visit starts and where it leaves the tool
+    std::vector<PathVisit> tour;
+    std::vector<point> entry;
+    std::vector<point> exit;
+    tour.reserve(paths.size());
+    
+    // Greedy nearest neighbour, starting where the original order started
+    std::vector<char> visited(paths.size(), 0);
+    point pos = pieces[0].a;
+    size_t pick;
+    while (grid.FindNearest(pos, [&](size_t o) { return !visited[options[o].path]; }, pick))
+    {
+        const PathVisit &v = options[pick];
+        const PathSpan &ps = paths[v.path];
+        visited[v.path] = 1;
+        tour.push_back(v);
+        entry.push_back(option_points[pick]);
+        if (ps.closed)
+        {
+            exit.push_back(option_points[pick]);
+        }
+        else
+        {
+            exit.push_back(v.reversed ? chained[ps.first].a : chained[ps.first + ps.count - 1].b);
+        }
+        pos = exit.back();
+    }
+    
+    // 2-opt: reversing a stretch of the tour also reverses each path in it
+    if (refine_ms > 0.0 && tour.size() > 3)
+    {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::microseconds((long long)(refine_ms * 1000.0));
+        const size_t n = tour.size();
+        bool improved = true;
+        bool out_of_time = false;
+        while (improved && !out_of_time)
+        {
+            improved = false;
+            for (size_t i = 1; i + 1 < n && !out_of_time; i++)
+            {
+                for (size_t j = i + 1; j < n; j++)
+                {
+                    double before = SheetDistance(exit[i-1], entry[i]);
+                    double after = SheetDistance(exit[i-1], exit[j]);
+                    if (j + 1 < n)
+                    {
+                        before += SheetDistance(exit[j], entry[j+1]);
+                        after += SheetDistance(entry[i], entry[j+1]);
+                    }
+                    if (after < before - 1e-9)
+                    {
+                        std::reverse(tour.begin() + i, tour.begin() + j + 1);
+                        std::reverse(entry.begin() + i, entry.begin() + j + 1);
+                        std::reverse(exit.begin() + i, exit.begin() + j + 1);
+                        for (size_t k = i; k <= j; k++)
+                        {
+                            tour[k].reversed = !tour[k].reversed;
+                            std::swap(entry[k], exit[k]);
+                        }
+                        improved = true;
+                    }
+                }
+                out_of_time = std::chrono::steady_clock::now() > deadline;
+            }
+        }
+    }
+    
+    // Lay the pieces back out in tour order
+    pieces.clear();
+    for (size_t t = 0; t < tour.size(); t++)
+    {
+        const PathSpan &ps = paths[tour[t].path];
+        for (size_t k = 0; k < ps.count; k++)
+        {
+            // Closed loops walk around from their start corner, backwards if reversed
+            size_t idx = tour[t].reversed ? tour[t].start + ps.count - 1 - k : tour[t].start + k;
+            idx %= ps.count;
+            const slicepiece &sp = chained[ps.first + idx];
+            pieces.push_back(tour[t].reversed ? Flipped(sp) : sp);
+        }
+    }
+    return TravelDistance(pieces);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reorders the perimeters and, if given, the infill of every layer.
+--|     Layers are spread over the worker threads.
+--| Args:
+--|     layers - The sliced layers to reorder
+--|     toolpaths - Optional infill to reorder as well
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void PathOrder::OrderLayers(SlicedLayers* layers, LayerToolpaths* toolpaths) const
+{
+    LogPrintf("Ordering toolpaths now...\n");
+    const size_t nLayers = layers->GetSize();
+    std::vector<double> before(nLayers, 0.0);
+    std::vector<double> after(nLayers, 0.0);
+    ParallelFor(nLayers, [&](size_t i)
+    {
+        TRACE_SCOPE_ARG("order layer", "layer", i);
+        double b = 0.0;
+        after[i] = OrderLayer(layers->GetLayer(i), &b);
+        before[i] = b;
+        if (toolpaths && i < toolpaths->GetSize())
+        {
+            after[i] += OrderLayer(toolpaths->GetInfill(i), &b);
+            before[i] += b;
+        }
+    });
+    
+    double total_before = 0.0;
+    double total_after = 0.0;
+    for (size_t i = 0; i < nLayers; i++)
+    {
+        total_before += before[i];
+        total_after += after[i];
+    }
+    LogPrintf("...Done! Travel cut from %0.1f to %0.1f\n\n", total_before, total_after);
+}
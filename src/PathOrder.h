@@ -0,0 +1,104 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _PATH_ORDER_H_
+#define _PATH_ORDER_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "SlicedLayers.h"
+#include "LayerToolpaths.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that reorders the moves of each rolled out layer to cut down on
+--| travel between them.
+--|
+--| Touching slicepieces are first chained into paths. Paths are then
+--| visited greedily, always jumping to the nearest free path end (or any
+--| point of a closed loop) found through a uniform grid. The greedy tour
+--| is optionally polished with 2-opt until a time budget runs out.
+--|-------------------------------------------------------------------------
+*/
+class PathOrder
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     refine_ms - Time in milliseconds each layer may spend on 2-opt, 0 skips it
+    --| Return:
+    --|     A PathOrder Object
+    --|-------------------------------------------------------------------------
+    */
+    PathOrder(double refine_ms = 0.0);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Reorders the perimeters and, if given, the infill of every layer.
+    --|     Layers are spread over the worker threads.
+    --| Args:
+    --|     layers - The sliced layers to reorder
+    --|     toolpaths - Optional infill to reorder as well
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void OrderLayers(SlicedLayers* layers, LayerToolpaths* toolpaths) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Reorders the moves of one layer. Pieces may be flipped end for end.
+    --| Args:
+    --|     pieces - The moves to reorder, in place
+    --|     travel_before - If not NULL gets the travel of the original order
+    --| Return:
+    --|     double - Travel distance of the new order
+    --|-------------------------------------------------------------------------
+    */
+    double OrderLayer(std::vector<slicepiece> &pieces, double* travel_before) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Adds up the jumps between the end of each move and the start of
+    --|     the next
+    --| Args:
+    --|     pieces - The moves in cutting order
+    --| Return:
+    --|     double - Total travel distance
+    --|-------------------------------------------------------------------------
+    */
+    static double TravelDistance(const std::vector<slicepiece> &pieces);
+
+private:
+    // Milliseconds per layer for 2-opt
+    double refine_ms;
+};
+
+#endif //_PATH_ORDER_H_
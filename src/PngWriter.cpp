@@ -0,0 +1,110 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "PngWriter.h"
+
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+
+// Writes one PNG chunk
+static bool WritePngChunk(OutputSink* f, const char* type, const unsigned char* data, size_t size)
+{
+    unsigned char header[8] = {(unsigned char)(size >> 24), (unsigned char)(size >> 16), (unsigned char)(size >> 8), (unsigned char)size,
+                               (unsigned char)type[0], (unsigned char)type[1], (unsigned char)type[2], (unsigned char)type[3]};
+    uLong crc = crc32(0L, (const Bytef*)type, 4);
+    if (size > 0)
+    {
+        crc = crc32(crc, data, (uInt)size);
+    }
+    unsigned char footer[4] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc};
+    bool ok = f->Write(header, 8);
+    ok = ok && (size == 0 || f->Write(data, size));
+    return ok && f->Write(footer, 4);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes packed image rows as a PNG, deflating them row by row with
+--|     zlib so no second copy of the image is made
+--| Args:
+--|     f - Sink of the new file
+--|     pixels - height rows, each (width * channels * bit_depth + 7) / 8 bytes
+--|     width - Image width in pixels
+--|     height - Image height in pixels
+--|     bit_depth - Bits per channel, 1 or 8
+--|     color_type - PNG_GREY or PNG_RGB
+--| Return:
+--|     bool - true if everything was written
+--|-------------------------------------------------------------------------
+*/
+bool WritePNG(OutputSink* f, const unsigned char* pixels, size_t width, size_t height, int bit_depth, int color_type)
+{
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    unsigned char ihdr[13] = {(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+                              (unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+                              (unsigned char)bit_depth, (unsigned char)color_type, 0, 0, 0};
+    bool ok = f->Write(signature, 8);
+    ok = ok && WritePngChunk(f, "IHDR", ihdr, 13);
+    
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+    {
+        return false;
+    }
+    const size_t channels = color_type == PNG_RGB ? 3 : 1;
+    const size_t stride = (width * channels * bit_depth + 7) / 8;
+    std::vector<unsigned char> row(stride + 1, 0);
+    std::vector<unsigned char> chunk(1 << 16);
+    for (size_t y = 0; y <= height && ok; y++)
+    {
+        // Every row starts with filter type 0
+        int flush = Z_FINISH;
+        zs.avail_in = 0;
+        if (y < height)
+        {
+            memcpy(&row[1], pixels + y * stride, stride);
+            zs.next_in = &row[0];
+            zs.avail_in = (uInt)row.size();
+            flush = Z_NO_FLUSH;
+        }
+        int ret;
+        do
+        {
+            zs.next_out = &chunk[0];
+            zs.avail_out = (uInt)chunk.size();
+            ret = deflate(&zs, flush);
+            size_t produced = chunk.size() - zs.avail_out;
+            if (produced > 0)
+            {
+                ok = ok && WritePngChunk(f, "IDAT", &chunk[0], produced);
+            }
+        } while (ok && (zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END)));
+    }
+    deflateEnd(&zs);
+    
+    return ok && WritePngChunk(f, "IEND", NULL, 0);
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _PNG_WRITER_H_
+#define _PNG_WRITER_H_
+
+#include <stdio.h>
+#include "OutputSink.h"
+
+// PNG colour types the writer is used with
+#define PNG_GREY 0
+#define PNG_RGB 2
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes packed image rows as a PNG, deflating them row by row with
+--|     zlib so no second copy of the image is made
+--| Args:
+--|     f - Sink of the new file
+--|     pixels - height rows, each (width * channels * bit_depth + 7) / 8 bytes
+--|     width - Image width in pixels
+--|     height - Image height in pixels
+--|     bit_depth - Bits per channel, 1 or 8
+--|     color_type - PNG_GREY or PNG_RGB
+--| Return:
+--|     bool - true if everything was written
+--|-------------------------------------------------------------------------
+*/
+bool WritePNG(OutputSink* f, const unsigned char* pixels, size_t width, size_t height, int bit_depth, int color_type);
+
+#endif //_PNG_WRITER_H_
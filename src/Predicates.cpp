@@ -0,0 +1,241 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "Predicates.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Exact building blocks, each gives a rounded result x and the error y
+--| so that x + y is exactly the result. They need round to nearest double
+--| arithmetic without extended precision, which x86-64 and ARM64 have.
+--|-------------------------------------------------------------------------
+*/
+
+// a + b, any magnitudes
+static inline void TwoSum(double a, double b, double &x, double &y)
+{
+    x = a + b;
+    double b_virtual = x - a;
+    double a_virtual = x - b_virtual;
+    y = (a - a_virtual) + (b - b_virtual);
+}
+
+// a + b, |a| >= |b|
+static inline void FastTwoSum(double a, double b, double &x, double &y)
+{
+    x = a + b;
+    y = b - (x - a);
+}
+
+// Splits a into two halves of 26 bits each
+static inline void Split(double a, double &high, double &low)
+{
+    double c = 134217729.0 * a;
+    double big = c - a;
+    high = c - big;
+    low = a - high;
+}
+
+// a * b
+static inline void TwoProduct(double a, double b, double &x, double &y)
+{
+    x = a * b;
+    double a_high, a_low, b_high, b_low;
+    Split(a, a_high, a_low);
+    Split(b, b_high, b_low);
+    double error1 = x - (a_high * b_high);
+    double error2 = error1 - (a_low * b_high);
+    double error3 = error2 - (a_high * b_low);
+    y = (a_low * b_low) - error3;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor. Holds one double exactly.
+--| Args:
+--|     value - The number
+--| Return:
+--|     An Expansion Object
+--|-------------------------------------------------------------------------
+*/
+Expansion::Expansion(double value)
+{
+    if (value != 0.0)
+    {
+        terms.push_back(value);
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor. Holds zero.
+--| Args:
+--|     none
+--| Return:
+--|     An Expansion Object
+--|-------------------------------------------------------------------------
+*/
+Expansion::Expansion(void)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the sign of the number, which is that of its largest term
+--| Args:
+--|     none
+--| Return:
+--|     int - -1, 0 or 1
+--|-------------------------------------------------------------------------
+*/
+int Expansion::Sign() const
+{
+    if (terms.empty())
+    {
+        return 0;
+    }
+    return terms.back() > 0.0 ? 1 : -1;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds a double to this number, carrying it up through the terms
+--|     (Shewchuk's Grow-Expansion, dropping zeros)
+--| Args:
+--|     b - The double to add
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Expansion::Grow(double b)
+{
+    double carry = b;
+    size_t kept = 0;
+    for (size_t i = 0; i < terms.size(); i++)
+    {
+        double sum, error;
+        TwoSum(carry, terms[i], sum, error);
+        carry = sum;
+        if (error != 0.0)
+        {
+            terms[kept++] = error;
+        }
+    }
+    terms.resize(kept);
+    if (carry != 0.0)
+    {
+        terms.push_back(carry);
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets this number times a double (Shewchuk's Scale-Expansion,
+--|     dropping zeros)
+--| Args:
+--|     b - The double to multiply by
+--| Return:
+--|     Expansion - The product
+--|-------------------------------------------------------------------------
+*/
+Expansion Expansion::Scale(double b) const
+{
+    Expansion product;
+    if (terms.empty() || b == 0.0)
+    {
+        return product;
+    }
+    double carry, error;
+    TwoProduct(terms[0], b, carry, error);
+    if (error != 0.0)
+    {
+        product.terms.push_back(error);
+    }
+    for (size_t i = 1; i < terms.size(); i++)
+    {
+        double high, low, sum;
+        TwoProduct(terms[i], b, high, low);
+        TwoSum(carry, low, sum, error);
+        if (error != 0.0)
+        {
+            product.terms.push_back(error);
+        }
+        FastTwoSum(high, sum, carry, error);
+        if (error != 0.0)
+        {
+            product.terms.push_back(error);
+        }
+    }
+    if (carry != 0.0)
+    {
+        product.terms.push_back(carry);
+    }
+    return product;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Exact sum, difference and product of two Expansions
+--| Args:
+--|     a - Left operand
+--|     b - Right operand
+--| Return:
+--|     Expansion - The exact result
+--|-------------------------------------------------------------------------
+*/
+Expansion operator+(const Expansion &a, const Expansion &b)
+{
+    Expansion sum(a);
+    for (size_t i = 0; i < b.terms.size(); i++)
+    {
+        sum.Grow(b.terms[i]);
+    }
+    return sum;
+}
+
+Expansion operator-(const Expansion &a, const Expansion &b)
+{
+    Expansion difference(a);
+    for (size_t i = 0; i < b.terms.size(); i++)
+    {
+        difference.Grow(-b.terms[i]);
+    }
+    return difference;
+}
+
+Expansion operator*(const Expansion &a, const Expansion &b)
+{
+    Expansion product;
+    for (size_t i = 0; i < b.terms.size(); i++)
+    {
+        product = product + a.Scale(b.terms[i]);
+    }
+    return product;
+}
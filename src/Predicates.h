@@ -0,0 +1,415 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _PREDICATES_H_
+#define _PREDICATES_H_
+
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <vector>
+#include "dimensional_space.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Predicates decide which side of a layer's surface each vertex of a
+--| Triangle is on and whether an edge with both ends outside dips inside.
+--| Worked out in float they go wrong for vertices on or next to the surface,
+--| and two Triangles sharing an edge can disagree, leaving a gap or a double
+--| segment in the layer.
+--|
+--| The robust predicates first check the kernel's own values against a
+--| bound on their rounding error, which settles all but the Triangles
+--| right next to the surface. Those are worked out again in double with a
+--| running error bound, and only when that can't settle a sign it is done
+--| exactly with expansion arithmetic. A vertex exactly on the surface counts
+--| as outside, as if the surface were pulled in by a hair, so every Triangle
+--| around it sees the same thing. The surface policies give the quadratic
+--| of their level along an edge in any number type for this.
+--|-------------------------------------------------------------------------
+*/
+
+/*
+--|-------------------------------------------------------------------------
+--| A double along with a bound on how far it may be from the exact value
+--| of what it was worked out from. Values built from a float or double are
+--| exact.
+--|-------------------------------------------------------------------------
+*/
+struct BoundedReal
+{
+    double value;
+    double error;
+    
+    BoundedReal(double value) : value(value), error(0.0) {}
+    BoundedReal(double value, double error) : value(value), error(error) {}
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the sign of the exact value, if the error bound allows
+    --| Args:
+    --|     sign - Gets -1, 0 or 1
+    --| Return:
+    --|     bool - True if the sign is certain
+    --|-------------------------------------------------------------------------
+    */
+    bool Sign(int &sign) const
+    {
+        sign = (value > 0.0) - (value < 0.0);
+        return std::fabs(value) > error || error == 0.0;
+    }
+};
+
+// DBL_EPSILON is twice the rounding error of one operation, which leaves
+// room for the rounding in working out the bounds themselves
+inline BoundedReal operator+(const BoundedReal &a, const BoundedReal &b)
+{
+    double sum = a.value + b.value;
+    return BoundedReal(sum, a.error + b.error + std::fabs(sum) * DBL_EPSILON);
+}
+
+inline BoundedReal operator-(const BoundedReal &a, const BoundedReal &b)
+{
+    double difference = a.value - b.value;
+    return BoundedReal(difference, a.error + b.error + std::fabs(difference) * DBL_EPSILON);
+}
+
+inline BoundedReal operator*(const BoundedReal &a, const BoundedReal &b)
+{
+    double product = a.value * b.value;
+    return BoundedReal(product, std::fabs(a.value) * b.error + std::fabs(b.value) * a.error + a.error * b.error + std::fabs(product) * DBL_EPSILON);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| A number held exactly as a sum of doubles that don't overlap, smallest
+--| first (Shewchuk's expansions). Slow, only for the signs the error bounds
+--| can't settle.
+--|-------------------------------------------------------------------------
+*/
+class Expansion
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor. Holds one double exactly.
+    --| Args:
+    --|     value - The number
+    --| Return:
+    --|     An Expansion Object
+    --|-------------------------------------------------------------------------
+    */
+    Expansion(double value);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the sign of the number, which is that of its largest term
+    --| Args:
+    --|     none
+    --| Return:
+    --|     int - -1, 0 or 1
+    --|-------------------------------------------------------------------------
+    */
+    int Sign() const;
+    
+    // Exact arithmetic
+    friend Expansion operator+(const Expansion &a, const Expansion &b);
+    friend Expansion operator-(const Expansion &a, const Expansion &b);
+    friend Expansion operator*(const Expansion &a, const Expansion &b);
+    
+private:
+    Expansion(void);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Adds a double to this number
+    --| Args:
+    --|     b - The double to add
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Grow(double b);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets this number times a double
+    --| Args:
+    --|     b - The double to multiply by
+    --| Return:
+    --|     Expansion - The product
+    --|-------------------------------------------------------------------------
+    */
+    Expansion Scale(double b) const;
+    
+    // The terms, smallest first, no zeros
+    std::vector<double> terms;
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| The predicates as they always were: the signs of the values worked out
+--| in the kernel's own precision, edges worked along as the Triangle winds.
+--|-------------------------------------------------------------------------
+*/
+struct FastPredicates
+{
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Whether an edge is worked along from p1 to p0 instead
+    --| Args:
+    --|     p0 - Start of the edge as the Triangle winds
+    --|     p1 - End of the edge as the Triangle winds
+    --| Return:
+    --|     bool - Always false
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Real>
+    static bool Reversed(const PointT<Real> &p0, const PointT<Real> &p1)
+    {
+        return false;
+    }
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Whether the vertices' sides as the kernel found them are certain
+    --|     and no edge with both ends outside can dip inside
+    --| Args:
+    --|     surface - The surface policy for the layer
+    --|     p - The Triangle's vertices
+    --|     f - The surface's level at each vertex
+    --|     sag - The Triangle's sag (a quarter of its longest edge squared)
+    --|     inside - Bit per vertex as the kernel found it
+    --| Return:
+    --|     bool - Always false, the kernel works every edge out
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    static bool Settled(const Surface &surface, const PointT<typename Surface::Real> p[3], const typename Surface::Real f[3], float sag, int inside)
+    {
+        return false;
+    }
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Settles which vertices are inside and which edges dip inside
+    --| Args:
+    --|     surface - The surface policy for the layer
+    --|     p - The Triangle's vertices
+    --|     inside - Bit per vertex, as the kernel found it, kept
+    --|     dips - Bit per edge, as the kernel found it, kept
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    static void Refine(const Surface &surface, const PointT<typename Surface::Real> p[3], int &inside, int &dips)
+    {
+    }
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| The robust predicates: exact signs through error bound filters with an
+--| exact fallback, and every edge worked along from its lexically lower end
+--| so both Triangles sharing it put the crossings in the same place.
+--|-------------------------------------------------------------------------
+*/
+struct RobustPredicates
+{
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Whether an edge is worked along from p1 to p0 instead, so that it
+    --|     always goes from its lexically lower end
+    --| Args:
+    --|     p0 - Start of the edge as the Triangle winds
+    --|     p1 - End of the edge as the Triangle winds
+    --| Return:
+    --|     bool - True if p1 comes first
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Real>
+    static bool Reversed(const PointT<Real> &p0, const PointT<Real> &p1)
+    {
+        // Without branches, which half the edges would mispredict
+        return (p1.x < p0.x) | ((p1.x == p0.x) & ((p1.y < p0.y) | ((p1.y == p0.y) & (p1.z < p0.z))));
+    }
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Whether the vertices' sides as the kernel found them are certain
+    --|     and no edge with both ends outside can dip inside. Decides all but
+    --|     the Triangles right next to the surface.
+    --| Args:
+    --|     surface - The surface policy for the layer
+    --|     p - The Triangle's vertices
+    --|     f - The surface's level at each vertex
+    --|     sag - The Triangle's sag (a quarter of its longest edge squared)
+    --|     inside - Bit per vertex as the kernel found it
+    --| Return:
+    --|     bool - True if settled, Refine isn't needed then
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    static bool Settled(const Surface &surface, const PointT<typename Surface::Real> p[3], const typename Surface::Real f[3], float sag, int inside)
+    {
+        typedef typename Surface::Real Real;
+        const Real eps = std::numeric_limits<Real>::epsilon();
+        
+        // Each level is off by a few epsilon of the terms that made it up,
+        // which come to at most |f| + 2*Scale
+        Real slack[3];
+        int sure = 1;
+        for (int vertex = 0; vertex < 3; vertex++)
+        {
+            slack[vertex] = Real(8) * eps * (std::fabs(f[vertex]) + Real(2) * surface.Scale(p[vertex]));
+            sure &= std::fabs(f[vertex]) > slack[vertex];
+        }
+        
+        // Along an edge the level is (1-t)*f0 + t*f1 less at most the sag,
+        // so an edge with both ends further out than that can't dip inside
+        const Real reach = Real(sag);
+        for (int edge = 0; edge < 3; edge++)
+        {
+            int next = (edge + 1) % 3;
+            int in = ((inside >> edge) | (inside >> next)) & 1;
+            sure &= in | ((f[edge] - slack[edge] > reach) & (f[next] - slack[next] > reach));
+        }
+        return sure;
+    }
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Works out exactly which vertices are inside and which edges with
+    --|     both ends outside dip inside, replacing what the kernel found
+    --| Args:
+    --|     surface - The surface policy for the layer
+    --|     p - The Triangle's vertices
+    --|     inside - Gets a bit per vertex
+    --|     dips - Gets a bit per edge
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    static void Refine(const Surface &surface, const PointT<typename Surface::Real> p[3], int &inside, int &dips)
+    {
+        BoundedReal A[3] = {0.0, 0.0, 0.0};
+        BoundedReal B[3] = {0.0, 0.0, 0.0};
+        BoundedReal C[3] = {0.0, 0.0, 0.0};
+        inside = 0;
+        for (int edge = 0; edge < 3; edge++)
+        {
+            surface.Quadratic(p[edge], p[(edge + 1) % 3], A[edge], B[edge], C[edge]);
+            inside |= VertexInside(surface, p[edge], C[edge]) << edge;
+        }
+        
+        dips = 0;
+        for (int edge = 0; edge < 3; edge++)
+        {
+            int next = (edge + 1) % 3;
+            if (!((inside >> edge) & 1) && !((inside >> next) & 1))
+            {
+                dips |= EdgeDips(surface, p[edge], p[next], A[edge], B[edge], C[edge]) << edge;
+            }
+        }
+    }
+    
+private:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Whether a vertex is strictly inside the surface
+    --| Args:
+    --|     surface - The surface policy for the layer
+    --|     p - The vertex
+    --|     level - The surface's level at p with its error bound
+    --| Return:
+    --|     int - 1 if inside, 0 if on or outside
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    static int VertexInside(const Surface &surface, const PointT<typename Surface::Real> &p, const BoundedReal &level)
+    {
+        int sign;
+        if (!level.Sign(sign))
+        {
+            Expansion A(0.0), B(0.0), C(0.0);
+            surface.Quadratic(p, p, A, B, C);
+            sign = C.Sign();
+        }
+        return sign < 0;
+    }
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Whether an edge with both ends outside passes strictly inside the
+    --|     surface: its level A*t^2 + B*t + C opens upwards and has its lowest
+    --|     point below zero somewhere between the ends
+    --| Args:
+    --|     surface - The surface policy for the layer
+    --|     p0 - Start of the edge
+    --|     p1 - End of the edge
+    --|     A, B, C - The level along the edge with error bounds
+    --| Return:
+    --|     int - 1 if the edge dips inside
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    static int EdgeDips(const Surface &surface, const PointT<typename Surface::Real> &p0, const PointT<typename Surface::Real> &p1,
+                        const BoundedReal &A, const BoundedReal &B, const BoundedReal &C)
+    {
+        // Most edges are far from the surface and fail on the discriminant
+        int delta_sign, a_sign, b_sign, end_sign;
+        bool sure = (B*B - BoundedReal(4.0)*A*C).Sign(delta_sign);
+        if (sure && delta_sign <= 0)
+        {
+            return 0;
+        }
+        sure &= A.Sign(a_sign) & B.Sign(b_sign) & (BoundedReal(2.0)*A + B).Sign(end_sign);
+        if (!sure)
+        {
+            Expansion Ae(0.0), Be(0.0), Ce(0.0);
+            surface.Quadratic(p0, p1, Ae, Be, Ce);
+            delta_sign = (Be*Be - Expansion(4.0)*Ae*Ce).Sign();
+            a_sign = Ae.Sign();
+            b_sign = Be.Sign();
+            end_sign = (Expansion(2.0)*Ae + Be).Sign();
+        }
+        return delta_sign > 0 && a_sign > 0 && b_sign < 0 && end_sign > 0;
+    }
+};
+
+#endif //_PREDICATES_H_
@@ -0,0 +1,128 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "PwriteSink.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     fd - The open file
+--|     file_name - Name of the file, for messages
+--|     direct - Whether fd was opened with O_DIRECT
+--| Return:
+--|     A PwriteSink Object
+--|-------------------------------------------------------------------------
+*/
+PwriteSink::PwriteSink(int fd, const char* file_name, bool direct) : OutputSink(fd, file_name, direct), own_buffer(NULL)
+{
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor. Closes the file if Close was not called.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+PwriteSink::~PwriteSink()
+{
+    Close();
+    free(own_buffer);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the one buffer, allocating it the first time
+--| Args:
+--|     none
+--| Return:
+--|     unsigned char* - The buffer, NULL if it cannot be allocated
+--|-------------------------------------------------------------------------
+*/
+unsigned char* PwriteSink::GetBuffer()
+{
+    if (!own_buffer && posix_memalign((void**)&own_buffer, SINK_ALIGN, SINK_BUFFER_SIZE) != 0)
+    {
+        own_buffer = NULL;
+    }
+    return own_buffer;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes a filled buffer at its place in the file, all of it before
+--|     returning
+--| Args:
+--|     buffer - The buffer from GetBuffer
+--|     size - Bytes to write
+--|     offset - Where in the file they go
+--| Return:
+--|     bool - true if everything was written
+--|-------------------------------------------------------------------------
+*/
+bool PwriteSink::Submit(unsigned char* buffer, size_t size, uint64_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, buffer, size, (off_t)offset);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        buffer += n;
+        size -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Nothing is left in flight once Submit returns
+--| Args:
+--|     none
+--| Return:
+--|     bool - true
+--|-------------------------------------------------------------------------
+*/
+bool PwriteSink::Finish()
+{
+    return true;
+}
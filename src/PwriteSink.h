@@ -0,0 +1,77 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef _PWRITE_SINK_H_
+#define _PWRITE_SINK_H_
+
+#include "OutputSink.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Backend that writes every buffer with pwrite before carrying on. Only
+--| needs POSIX, so it is what a sink falls back on where io_uring is
+--| missing or not allowed.
+--|-------------------------------------------------------------------------
+*/
+class PwriteSink : public OutputSink
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     fd - The open file
+    --|     file_name - Name of the file, for messages
+    --|     direct - Whether fd was opened with O_DIRECT
+    --| Return:
+    --|     A PwriteSink Object
+    --|-------------------------------------------------------------------------
+    */
+    PwriteSink(int fd, const char* file_name, bool direct);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor. Closes the file if Close was not called.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    ~PwriteSink();
+
+protected:
+    // The backend half of OutputSink, see there
+    unsigned char* GetBuffer();
+    bool Submit(unsigned char* buffer, size_t size, uint64_t offset);
+    bool Finish();
+
+private:
+    // The one buffer, filled and written in turn
+    unsigned char* own_buffer;
+};
+
+#endif //_PWRITE_SINK_H_
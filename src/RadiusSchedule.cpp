@@ -0,0 +1,322 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "RadiusSchedule.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Log.h"
+
+// Adaptive radii sit on a grid this many times finer than the thinnest layer
+static const int GRID_STEPS = 4;
+
+// A Triangle's wish for the thickness of the layers over its radial extent
+struct ThicknessSpan
+{
+    long first;
+    long last;
+    float thickness;
+    
+    bool operator<(const ThicknessSpan &other) const
+    {
+        return thickness < other.thickness;
+    }
+};
+
+// One corner of a Triangle, sorting brings the copies of a vertex together
+struct MeshCorner
+{
+    point p;
+    size_t triangle;
+    int corner;
+    
+    bool operator<(const MeshCorner &other) const
+    {
+        if (p.x != other.p.x) return p.x < other.p.x;
+        if (p.y != other.p.y) return p.y < other.p.y;
+        return p.z < other.p.z;
+    }
+};
+
+// Index of the grid radius for the last step that is still in range
+static long LastIndex(float start_radius, float step, float end_radius)
+{
+    if (end_radius <= start_radius)
+    {
+        return 0;
+    }
+    long last = (long)floor((double)(end_radius - start_radius) / step);
+    if (start_radius + last * (double)step < end_radius - 1e-4 * step)
+    {
+        last++;
+    }
+    return last;
+}
+
+// Follows painted spans to the next bin nobody has claimed yet
+static long NextFree(std::vector<long> &next, long i)
+{
+    long root = i;
+    while (next[root] != root)
+    {
+        root = next[root];
+    }
+    while (next[i] != root)
+    {
+        long up = next[i];
+        next[i] = root;
+        i = up;
+    }
+    return root;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     min_thickness - Thinnest layer, also the cusp height allowed
+--|     max_thickness - Thickest layer
+--| Return:
+--|     A RadiusSchedule Object
+--|-------------------------------------------------------------------------
+*/
+RadiusSchedule::RadiusSchedule(float min_thickness, float max_thickness) : min_thickness(min_thickness), max_thickness(std::max(min_thickness, max_thickness))
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Evenly spaced radii from start until end is reached
+--| Args:
+--|     start_radius - Smallest Slicyl radius
+--|     thickness - Thickness between Slicyls
+--|     end_radius - The last radius is the first one at or past this
+--|     radii - Gets the radii, smallest first
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void RadiusSchedule::Uniform(float start_radius, float thickness, float end_radius, std::vector<float> &radii)
+{
+    radii.clear();
+    if (thickness <= 0.0f)
+    {
+        radii.push_back(start_radius);
+        return;
+    }
+    const long last = LastIndex(start_radius, thickness, end_radius);
+    for (long i = 0; i <= last; i++)
+    {
+        radii.push_back((float)(start_radius + i * (double)thickness));
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Radii from start until end is reached, spaced to follow the mesh
+--| Args:
+--|     mesh - The mesh that will be sliced
+--|     start_radius - Smallest Slicyl radius
+--|     end_radius - The last radius is the first one at or past this
+--|     radii - Gets the radii, smallest first
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void RadiusSchedule::Adaptive(const TriangleMesh* mesh, float start_radius, float end_radius, std::vector<float> &radii) const
+{
+    radii.clear();
+    if (min_thickness <= 0.0f)
+    {
+        radii.push_back(start_radius);
+        return;
+    }
+    const float step = min_thickness / GRID_STEPS;
+    const long last = LastIndex(start_radius, step, end_radius);
+    const long min_steps = GRID_STEPS;
+    const long max_steps = std::max(min_steps, (long)floorf(max_thickness / step));
+    const size_t nTriangles = mesh->GetMeshSize();
+    
+    // What each Triangle asks for, and the radii where something starts or stops
+    std::vector<ThicknessSpan> spans;
+    std::vector<long> critical;
+    std::vector<float> r_min(nTriangles), r_max(nTriangles);
+    for (size_t j = 0; j < nTriangles; j++)
+    {
+        const Triangle &tri = mesh->GetTriangle(j);
+        tri.GetRadialExtent(r_min[j], r_max[j]);
+        if (r_max[j] < start_radius || r_min[j] > end_radius)
+        {
+            continue;
+        }
+        
+        // The normal from the vertices, STL files do not always fill it in
+        const point &a = tri.GetVertex(0);
+        const point &b = tri.GetVertex(1);
+        const point &c = tri.GetVertex(2);
+        float ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+        float vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+        float ny = uz*vx - ux*vz;
+        float nz = ux*vy - uy*vx;
+        float nx = uy*vz - uz*vy;
+        float n_len = sqrtf(nx*nx + ny*ny + nz*nz);
+        if (n_len == 0.0f)
+        {
+            continue;
+        }
+        
+        // Steepest the surface gets in the radial direction
+        float along = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            const point &p = tri.GetVertex(k);
+            float r = sqrtf(p.y*p.y + p.z*p.z);
+            if (r > 0.0f)
+            {
+                along = std::max(along, fabsf(ny*p.y + nz*p.z) / (r * n_len));
+            }
+        }
+        float thickness = along > 0.0f ? min_thickness / along : max_thickness;
+        thickness = std::min(max_thickness, std::max(min_thickness, thickness));
+        
+        ThicknessSpan span;
+        span.first = std::max(0L, (long)floorf((r_min[j] - start_radius) / step));
+        span.last = std::min(last, (long)ceilf((r_max[j] - start_radius) / step));
+        span.thickness = thickness;
+        if (span.first <= span.last)
+        {
+            spans.push_back(span);
+        }
+        
+        // Faces that sit at one radius, slice both sides of them
+        if (r_max[j] - r_min[j] <= step)
+        {
+            float mid = 0.5f * (r_min[j] + r_max[j]);
+            critical.push_back((long)floorf((mid - start_radius) / step));
+            critical.push_back((long)floorf((mid - start_radius) / step) + 1);
+        }
+    }
+    
+    // Thinnest layer any Triangle asks for at each grid radius
+    std::vector<float> allowed(last + 1, max_thickness);
+    std::vector<long> next(last + 2);
+    for (long i = 0; i <= last + 1; i++)
+    {
+        next[i] = i;
+    }
+    std::sort(spans.begin(), spans.end());
+    for (size_t s = 0; s < spans.size(); s++)
+    {
+        for (long i = NextFree(next, spans[s].first); i <= spans[s].last; i = NextFree(next, i))
+        {
+            allowed[i] = spans[s].thickness;
+            next[i] = i + 1;
+        }
+    }
+    
+    // Vertices closer to or further from the axis than all their neighbours
+    std::vector<MeshCorner> corners(nTriangles * 3);
+    for (size_t j = 0; j < nTriangles; j++)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            MeshCorner mc = {mesh->GetTriangle(j).GetVertex(k), j, k};
+            corners[j*3 + k] = mc;
+        }
+    }
+    std::sort(corners.begin(), corners.end());
+    for (size_t first = 0; first < corners.size(); )
+    {
+        size_t end = first + 1;
+        while (end < corners.size() && !(corners[first] < corners[end]))
+        {
+            end++;
+        }
+        const point &p = corners[first].p;
+        const float r = sqrtf(p.y*p.y + p.z*p.z);
+        bool lowest = true, highest = true;
+        for (size_t k = first; k < end; k++)
+        {
+            const Triangle &tri = mesh->GetTriangle(corners[k].triangle);
+            for (int o = 1; o < 3; o++)
+            {
+                const point &q = tri.GetVertex((corners[k].corner + o) % 3);
+                const float rq = sqrtf(q.y*q.y + q.z*q.z);
+                lowest = lowest && rq > r;
+                highest = highest && rq < r;
+            }
+        }
+        // A feature shows up just past where it starts and ends just before where it stops
+        if (lowest)
+        {
+            critical.push_back((long)floorf((r - start_radius) / step) + 1);
+        }
+        if (highest)
+        {
+            critical.push_back((long)ceilf((r - start_radius) / step) - 1);
+        }
+        first = end;
+    }
+    std::sort(critical.begin(), critical.end());
+    
+    // Walk out from the start taking the longest step every grid radius allows
+    size_t forced = 0;
+    long idx = 0;
+    radii.push_back(start_radius);
+    while (idx < last)
+    {
+        long k = 0;
+        float thinnest = allowed[idx];
+        for (long s = 1; s <= max_steps && idx + s <= last; s++)
+        {
+            thinnest = std::min(thinnest, allowed[idx + s]);
+            if (thinnest < s * step * (1.0f - 1e-4f))
+            {
+                break;
+            }
+            k = s;
+        }
+        k = std::max(k, min_steps);
+        
+        // Do not step over a critical radius, unless it is too close to the last layer
+        while (forced < critical.size() && critical[forced] < idx + min_steps)
+        {
+            forced++;
+        }
+        if (forced < critical.size() && critical[forced] < idx + k)
+        {
+            k = critical[forced] - idx;
+        }
+        idx = std::min(idx + k, last);
+        radii.push_back((float)(start_radius + idx * (double)step));
+    }
+    
+    std::vector<float> uniform;
+    Uniform(start_radius, min_thickness, end_radius, uniform);
+    LogPrintf("Adaptive radii: %lu layers where %lu evenly spaced ones would be needed\n", (unsigned long)radii.size(), (unsigned long)uniform.size());
+}
@@ -0,0 +1,101 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _RADIUS_SCHEDULE_H_
+#define _RADIUS_SCHEDULE_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that picks the radii of the Slicyls.
+--|
+--| Every radius is start + index * step for an integer index, so long runs
+--| of layers do not drift the way repeatedly adding the thickness does.
+--| The adaptive schedule works like cusp height slicing turned on its side:
+--| a Triangle whose normal points along the radius changes the layer
+--| outline quickly and asks for thin layers, one whose normal is square to
+--| the radius hardly changes it and lets the layers spread out. Layers are
+--| also added where features start or stop, at the radii of vertices that
+--| are closer to or further from the axis than all of their neighbours and
+--| of faces that sit at one radius.
+--|-------------------------------------------------------------------------
+*/
+class RadiusSchedule
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     min_thickness - Thinnest layer, also the cusp height allowed
+    --|     max_thickness - Thickest layer
+    --| Return:
+    --|     A RadiusSchedule Object
+    --|-------------------------------------------------------------------------
+    */
+    RadiusSchedule(float min_thickness, float max_thickness);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Evenly spaced radii from start until end is reached
+    --| Args:
+    --|     start_radius - Smallest Slicyl radius
+    --|     thickness - Thickness between Slicyls
+    --|     end_radius - The last radius is the first one at or past this
+    --|     radii - Gets the radii, smallest first
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    static void Uniform(float start_radius, float thickness, float end_radius, std::vector<float> &radii);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Radii from start until end is reached, spaced to follow the mesh
+    --| Args:
+    --|     mesh - The mesh that will be sliced
+    --|     start_radius - Smallest Slicyl radius
+    --|     end_radius - The last radius is the first one at or past this
+    --|     radii - Gets the radii, smallest first
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Adaptive(const TriangleMesh* mesh, float start_radius, float end_radius, std::vector<float> &radii) const;
+
+private:
+    // Thinnest layer, also the cusp height allowed
+    float min_thickness;
+    
+    // Thickest layer
+    float max_thickness;
+};
+
+#endif //_RADIUS_SCHEDULE_H_
@@ -0,0 +1,260 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "RasterExporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include "Parallel.h"
+#include "PngWriter.h"
+#include "Rollout.h"
+#include "Log.h"
+#include "Trace.h"
+
+// Model units are taken to be millimetres
+static const float MM_PER_INCH = 25.4f;
+
+// One edge of the outline in pixel space
+struct RasterEdge
+{
+    float y_min;
+    float y_max;
+    float x_at_min;
+    float dx_dy;
+};
+
+static bool RasterEdgeBefore(const RasterEdge &a, const RasterEdge &b)
+{
+    return a.y_min < b.y_min;
+}
+
+// Sets pixels [x0, x1) of a packed row, whole bytes at a time in the middle
+static void FillSpan(unsigned char* row, size_t x0, size_t x1)
+{
+    if (x0 >= x1)
+    {
+        return;
+    }
+    size_t b0 = x0 >> 3;
+    size_t b1 = (x1 - 1) >> 3;
+    unsigned char first = (unsigned char)(0xFF >> (x0 & 7));
+    unsigned char last = (unsigned char)(0xFF << (7 - ((x1 - 1) & 7)));
+    if (b0 == b1)
+    {
+        row[b0] |= first & last;
+        return;
+    }
+    row[b0] |= first;
+    memset(row + b0 + 1, 0xFF, b1 - b0 - 1);
+    row[b1] |= last;
+}
+
+// Writes a bitmap as a raw PBM, which already is a packed bitplane
+static bool WritePbm(OutputSink* f, const std::vector<unsigned char> &bits, size_t width, size_t height)
+{
+    bool ok = f->Printf("P4\n%lu %lu\n", (unsigned long)width, (unsigned long)height);
+    return ok && (bits.empty() || f->Write(&bits[0], bits.size()));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     dpi - Pixels per inch, taking model units as millimetres
+--|     format - File format of the masks
+--| Return:
+--|     A RasterExporter Object
+--|-------------------------------------------------------------------------
+*/
+RasterExporter::RasterExporter(float dpi, Format format) : pixels_per_unit(dpi / MM_PER_INCH), format(format)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Renders one layer into a packed bitmap, most significant bit first
+--| Args:
+--|     perimeter - The slicepieces of the layer
+--|     x_min - Model x of the left edge of the bitmap
+--|     width - Bitmap width in pixels
+--|     height - Bitmap height in pixels
+--|     bits - Gets height rows of (width + 7) / 8 bytes
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void RasterExporter::RasterizeLayer(const std::vector<slicepiece> &perimeter, float x_min, size_t width, size_t height, std::vector<unsigned char> &bits) const
+{
+    const size_t stride = (width + 7) / 8;
+    bits.assign(stride * height, 0);
+    
+    std::vector<LineSeg> outline;
+    Rollout::CloseOutline(perimeter, outline);
+    
+    // Edge table in pixel space, sorted by first row
+    std::vector<RasterEdge> edges;
+    edges.reserve(outline.size());
+    for (size_t i = 0; i < outline.size(); i++)
+    {
+        float x0 = (outline[i].pt0.x - x_min) * pixels_per_unit;
+        float y0 = outline[i].pt0.y * pixels_per_unit;
+        float x1 = (outline[i].pt1.x - x_min) * pixels_per_unit;
+        float y1 = outline[i].pt1.y * pixels_per_unit;
+        if (y0 == y1)
+        {
+            continue;
+        }
+        if (y1 < y0)
+        {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        RasterEdge e = {y0, y1, x0, (x1 - x0)/(y1 - y0)};
+        edges.push_back(e);
+    }
+    std::sort(edges.begin(), edges.end(), RasterEdgeBefore);
+    
+    // Sample every row at pixel centres, edges are live on [y_min, y_max)
+    std::vector<size_t> active;
+    std::vector<float> crossings;
+    size_t next_edge = 0;
+    for (size_t row = 0; row < height; row++)
+    {
+        const float y = row + 0.5f;
+        while (next_edge < edges.size() && edges[next_edge].y_min <= y)
+        {
+            active.push_back(next_edge++);
+        }
+        
+        crossings.clear();
+        size_t kept = 0;
+        for (size_t k = 0; k < active.size(); k++)
+        {
+            const RasterEdge &e = edges[active[k]];
+            if (e.y_max <= y)
+            {
+                continue;
+            }
+            active[kept++] = active[k];
+            crossings.push_back(e.x_at_min + (y - e.y_min)*e.dx_dy);
+        }
+        active.resize(kept);
+        std::sort(crossings.begin(), crossings.end());
+        
+        // Pixel centres between each pair of crossings
+        unsigned char* bits_row = &bits[row * stride];
+        for (size_t k = 0; k + 1 < crossings.size(); k += 2)
+        {
+            float from = ceilf(crossings[k] - 0.5f);
+            float to = ceilf(crossings[k+1] - 0.5f);
+            from = std::max(from, 0.0f);
+            to = std::min(to, (float)width);
+            if (from < to)
+            {
+                FillSpan(bits_row, (size_t)from, (size_t)to);
+            }
+        }
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Renders and writes every layer. Layers are rendered in parallel
+--|     and each mask is freed once written, so memory use is bounded by
+--|     the number of worker threads rather than the number of layers.
+--| Args:
+--|     layers - The sliced layers to render
+--|     prefix - Start of each file name, the layer number and extension are added
+--|     which - Indices of the layers to write, NULL for all. The masks
+--|             still span the x range of every layer
+--| Return:
+--|     bool - true if every file was written
+--|-------------------------------------------------------------------------
+*/
+bool RasterExporter::ExportLayers(const SlicedLayers* layers, const char* prefix, const std::vector<size_t>* which) const
+{
+    const size_t nLayers = layers->GetSize();
+    const size_t nWrite = which ? which->size() : nLayers;
+    LogPrintf("Generating %lu layer masks %s_*.%s now...\n", (unsigned long)nWrite, prefix, format == RASTER_PNG ? "png" : "pbm");
+    
+    // Every mask spans the x range of the whole model
+    float x_min = std::numeric_limits<float>::max();
+    float x_max = -x_min;
+    for (size_t i = 0; i < nLayers; i++)
+    {
+        const std::vector<slicepiece> &sp = layers->GetLayer(i);
+        for (size_t j = 0; j < sp.size(); j++)
+        {
+            x_min = std::min(x_min, std::min(sp[j].a.x, sp[j].b.x));
+            x_max = std::max(x_max, std::max(sp[j].a.x, sp[j].b.x));
+        }
+    }
+    if (x_min > x_max)
+    {
+        x_min = x_max = 0.0f;
+    }
+    const size_t width = (size_t)ceilf((x_max - x_min) * pixels_per_unit) + 1;
+    
+    std::atomic<size_t> failed(0);
+    ParallelFor(nWrite, [&](size_t k)
+    {
+        const size_t i = which ? (*which)[k] : k;
+        TRACE_SCOPE_ARG("raster layer", "layer", i);
+        const float circumference = 2.0f * 3.14159265358979f * layers->GetLayerRadius(i);
+        const size_t height = (size_t)ceilf(circumference * pixels_per_unit) + 1;
+        std::vector<unsigned char> bits;
+        RasterizeLayer(layers->GetLayer(i), x_min, width, height, bits);
+        
+        char file_name[1024];
+        snprintf(file_name, sizeof(file_name), "%s_%05lu.%s", prefix, (unsigned long)i, format == RASTER_PNG ? "png" : "pbm");
+        OutputSink* f = OutputSink::Open(file_name);
+        bool ok = f != NULL;
+        if (ok)
+        {
+            ok = format == RASTER_PNG ? WritePNG(f, bits.empty() ? NULL : &bits[0], width, height, 1, PNG_GREY) : WritePbm(f, bits, width, height);
+            ok = f->Close() && ok;
+            delete f;
+        }
+        if (!ok)
+        {
+            failed++;
+        }
+    });
+    
+    if (failed > 0)
+    {
+        LogPrintf("ERROR writing %lu layer masks!\n", (unsigned long)failed);
+        return false;
+    }
+    LogPrintf("...Done! Masks are %lu pixels wide starting at x = %f\n\n", (unsigned long)width, x_min);
+    return true;
+}
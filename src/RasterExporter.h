@@ -0,0 +1,106 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _RASTER_EXPORTER_H_
+#define _RASTER_EXPORTER_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "SlicedLayers.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that renders each rolled out layer into a 1 bit mask.
+--|
+--| Columns run along x over the x range of the whole model, so masks of
+--| different layers line up, and rows run along the arc from the seam.
+--| Pixels whose centre is inside the layer's outline (even-odd rule) are
+--| set. Each mask is written to its own file as a 1 bit PNG or raw PBM.
+--|-------------------------------------------------------------------------
+*/
+class RasterExporter
+{
+public:
+    // File formats a mask can be written in
+    enum Format
+    {
+        RASTER_PNG,
+        RASTER_PBM
+    };
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     dpi - Pixels per inch, taking model units as millimetres
+    --|     format - File format of the masks
+    --| Return:
+    --|     A RasterExporter Object
+    --|-------------------------------------------------------------------------
+    */
+    RasterExporter(float dpi, Format format = RASTER_PNG);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Renders and writes every layer. Layers are rendered in parallel
+    --|     and each mask is freed once written, so memory use is bounded by
+    --|     the number of worker threads rather than the number of layers.
+    --| Args:
+    --|     layers - The sliced layers to render
+    --|     prefix - Start of each file name, the layer number and extension are added
+    --|     which - Indices of the layers to write, NULL for all. The masks
+    --|             still span the x range of every layer
+    --| Return:
+    --|     bool - true if every file was written
+    --|-------------------------------------------------------------------------
+    */
+    bool ExportLayers(const SlicedLayers* layers, const char* prefix, const std::vector<size_t>* which = NULL) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Renders one layer into a packed bitmap, most significant bit first
+    --| Args:
+    --|     perimeter - The slicepieces of the layer
+    --|     x_min - Model x of the left edge of the bitmap
+    --|     width - Bitmap width in pixels
+    --|     height - Bitmap height in pixels
+    --|     bits - Gets height rows of (width + 7) / 8 bytes
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void RasterizeLayer(const std::vector<slicepiece> &perimeter, float x_min, size_t width, size_t height, std::vector<unsigned char> &bits) const;
+
+private:
+    // Pixels per model unit
+    float pixels_per_unit;
+    
+    // File format of the masks
+    Format format;
+};
+
+#endif //_RASTER_EXPORTER_H_
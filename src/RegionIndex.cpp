@@ -0,0 +1,314 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "RegionIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const float TWO_PI = 6.28318530717958647692f;
+
+// Wraps an angle into [0, 2*pi)
+static float WrapAngle(float angle)
+{
+    angle -= TWO_PI * floorf(angle / TWO_PI);
+    return angle >= TWO_PI ? 0.0f : angle;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Region constructor, the whole model
+--| Args:
+--|     none
+--| Return:
+--|     A SliceRegion Object
+--|-------------------------------------------------------------------------
+*/
+SliceRegion::SliceRegion() : x_min(-std::numeric_limits<float>::max()), x_max(std::numeric_limits<float>::max()), angle_start(0.0f), angle_span(TWO_PI)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Tells whether this region leaves anything out
+--| Args:
+--|     none
+--| Return:
+--|     bool - true if part of the model is left out
+--|-------------------------------------------------------------------------
+*/
+bool SliceRegion::IsLimited() const
+{
+    return IsSector() || x_min > -std::numeric_limits<float>::max() || x_max < std::numeric_limits<float>::max();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Tells whether the sector leaves any angles out
+--| Args:
+--|     none
+--| Return:
+--|     bool - true if the sector is less than a full turn
+--|-------------------------------------------------------------------------
+*/
+bool SliceRegion::IsSector() const
+{
+    return angle_span < TWO_PI;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor. Buckets every Triangle of the mesh.
+--| Args:
+--|     mesh - The mesh to index, must outlive the index
+--|     x_buckets - Number of buckets along x
+--|     angle_buckets - Number of buckets around the axis
+--| Return:
+--|     A RegionIndex Object
+--|-------------------------------------------------------------------------
+*/
+RegionIndex::RegionIndex(const TriangleMesh* mesh, size_t x_buckets, size_t angle_buckets) :
+    x_buckets(std::max((size_t)1, x_buckets)), angle_buckets(std::max((size_t)1, angle_buckets))
+{
+    const size_t nTriangles = mesh->GetMeshSize();
+    point lower, upper;
+    mesh->GetBBox(lower, upper);
+    x_lower = lower.x;
+    x_scale = upper.x > lower.x ? this->x_buckets / (upper.x - lower.x) : 0.0f;
+    
+    tri_x_min.resize(nTriangles);
+    tri_x_max.resize(nTriangles);
+    tri_angle_start.resize(nTriangles);
+    tri_angle_span.resize(nTriangles);
+    for (size_t j = 0; j < nTriangles; j++)
+    {
+        const Triangle &tri = mesh->GetTriangle(j);
+        float a[3];
+        bool on_axis = false;
+        tri_x_min[j] = tri_x_max[j] = tri.GetVertex(0).x;
+        for (int k = 0; k < 3; k++)
+        {
+            const point &p = tri.GetVertex(k);
+            tri_x_min[j] = std::min(tri_x_min[j], p.x);
+            tri_x_max[j] = std::max(tri_x_max[j], p.x);
+            on_axis = on_axis || (p.y == 0.0f && p.z == 0.0f);
+            a[k] = WrapAngle(atan2f(p.y, p.z));
+        }
+        float r_min, r_max;
+        tri.GetRadialExtent(r_min, r_max);
+        if (on_axis || r_min <= 0.0f)
+        {
+            tri_angle_start[j] = 0.0f;
+            tri_angle_span[j] = -1.0f;
+            continue;
+        }
+        
+        // The shadow misses the axis, so it covers the arc that skips the widest gap
+        std::sort(a, a + 3);
+        float gaps[3] = {a[1] - a[0], a[2] - a[1], a[0] + TWO_PI - a[2]};
+        int widest = (int)(std::max_element(gaps, gaps + 3) - gaps);
+        tri_angle_start[j] = a[(widest + 1) % 3];
+        tri_angle_span[j] = TWO_PI - gaps[widest];
+    }
+    
+    // Count, then pack, the Triangles of every bucket
+    bucket_start.assign(this->x_buckets * this->angle_buckets + 1, 0);
+    axis_start.assign(this->x_buckets + 1, 0);
+    for (int fill = 0; fill < 2; fill++)
+    {
+        std::vector<size_t> bucket_next(bucket_start.begin(), bucket_start.end() - 1);
+        std::vector<size_t> axis_next(axis_start.begin(), axis_start.end() - 1);
+        for (size_t j = 0; j < nTriangles; j++)
+        {
+            const size_t x0 = XBucket(tri_x_min[j]);
+            const size_t x1 = XBucket(tri_x_max[j]);
+            for (size_t xb = x0; xb <= x1; xb++)
+            {
+                if (tri_angle_span[j] < 0.0f)
+                {
+                    if (fill)
+                    {
+                        axis_triangles[axis_next[xb]++] = (unsigned int)j;
+                    }
+                    else
+                    {
+                        axis_start[xb + 1]++;
+                    }
+                    continue;
+                }
+                const size_t a0 = AngleBucket(tri_angle_start[j]);
+                const size_t n = std::min(this->angle_buckets, AngleBucket(tri_angle_start[j] + tri_angle_span[j]) - a0 + 1);
+                for (size_t k = 0; k < n; k++)
+                {
+                    const size_t bucket = xb * this->angle_buckets + (a0 + k) % this->angle_buckets;
+                    if (fill)
+                    {
+                        bucket_triangles[bucket_next[bucket]++] = (unsigned int)j;
+                    }
+                    else
+                    {
+                        bucket_start[bucket + 1]++;
+                    }
+                }
+            }
+        }
+        if (!fill)
+        {
+            for (size_t b = 1; b < bucket_start.size(); b++)
+            {
+                bucket_start[b] += bucket_start[b - 1];
+            }
+            for (size_t b = 1; b < axis_start.size(); b++)
+            {
+                axis_start[b] += axis_start[b - 1];
+            }
+            bucket_triangles.resize(bucket_start.back());
+            axis_triangles.resize(axis_start.back());
+        }
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Finds the Triangles that reach into a region
+--| Args:
+--|     region - The region to look in
+--|     triangles - Gets the Triangle numbers, smallest first
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void RegionIndex::Query(const SliceRegion &region, std::vector<unsigned int> &triangles) const
+{
+    triangles.clear();
+    if (region.x_min > region.x_max || region.angle_span <= 0.0f)
+    {
+        return;
+    }
+    const size_t x0 = XBucket(region.x_min);
+    const size_t x1 = XBucket(region.x_max);
+    size_t a0 = 0;
+    size_t n = angle_buckets;
+    if (region.IsSector())
+    {
+        a0 = AngleBucket(WrapAngle(region.angle_start));
+        n = std::min(angle_buckets, AngleBucket(WrapAngle(region.angle_start) + region.angle_span) - a0 + 1);
+    }
+    
+    for (size_t xb = x0; xb <= x1; xb++)
+    {
+        for (size_t k = 0; k < n; k++)
+        {
+            const size_t bucket = xb * angle_buckets + (a0 + k) % angle_buckets;
+            for (size_t i = bucket_start[bucket]; i < bucket_start[bucket + 1]; i++)
+            {
+                if (Overlaps(bucket_triangles[i], region))
+                {
+                    triangles.push_back(bucket_triangles[i]);
+                }
+            }
+        }
+        for (size_t i = axis_start[xb]; i < axis_start[xb + 1]; i++)
+        {
+            if (Overlaps(axis_triangles[i], region))
+            {
+                triangles.push_back(axis_triangles[i]);
+            }
+        }
+    }
+    
+    // A Triangle sits in every bucket it spans
+    std::sort(triangles.begin(), triangles.end());
+    triangles.erase(std::unique(triangles.begin(), triangles.end()), triangles.end());
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Finds the bucket of an x coordinate, clamped to the grid
+--| Args:
+--|     x - The coordinate
+--| Return:
+--|     size_t - The bucket
+--|-------------------------------------------------------------------------
+*/
+size_t RegionIndex::XBucket(float x) const
+{
+    float b = (x - x_lower) * x_scale;
+    if (!(b > 0.0f))
+    {
+        return 0;
+    }
+    return std::min(x_buckets - 1, (size_t)std::min(b, (float)x_buckets));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Finds the bucket of an angle. Angles past a full turn are not
+--|     wrapped, so the end of a span stays after its start
+--| Args:
+--|     angle - Angle in radians, at least 0
+--| Return:
+--|     size_t - The bucket
+--|-------------------------------------------------------------------------
+*/
+size_t RegionIndex::AngleBucket(float angle) const
+{
+    return (size_t)(angle * (angle_buckets / TWO_PI));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Tells whether a Triangle really reaches into a region
+--| Args:
+--|     t - Number of the Triangle
+--|     region - The region
+--| Return:
+--|     bool - true if it does
+--|-------------------------------------------------------------------------
+*/
+bool RegionIndex::Overlaps(unsigned int t, const SliceRegion &region) const
+{
+    if (tri_x_max[t] < region.x_min || tri_x_min[t] > region.x_max)
+    {
+        return false;
+    }
+    if (!region.IsSector() || tri_angle_span[t] < 0.0f)
+    {
+        return true;
+    }
+    
+    // Where the Triangle's angles start, seen from the start of the sector
+    const float d = WrapAngle(tri_angle_start[t] - region.angle_start);
+    return d <= region.angle_span || d + tri_angle_span[t] >= TWO_PI;
+}
@@ -0,0 +1,126 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _REGION_INDEX_H_
+#define _REGION_INDEX_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| A part of the model to slice: an x range and a sector of angles around
+--| the x axis. Angles are measured like the rollout theta, from +z towards
+--| +y, and the sector runs from angle_start through angle_span radians.
+--|-------------------------------------------------------------------------
+*/
+typedef struct SliceRegion
+{
+    float x_min;
+    float x_max;
+    float angle_start;
+    float angle_span;
+    
+    // The whole model
+    SliceRegion();
+    
+    // Whether this region leaves anything out
+    bool IsLimited() const;
+    
+    // Whether the sector leaves any angles out
+    bool IsSector() const;
+}SliceRegion;
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that buckets the Triangles of a mesh on a grid over x and the
+--| angle around the x axis, so the Triangles a region can touch are found
+--| without looking at the rest. Triangles whose shadow on the yz plane
+--| covers the axis see every angle and are kept apart per x bucket.
+--|-------------------------------------------------------------------------
+*/
+class RegionIndex
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor. Buckets every Triangle of the mesh.
+    --| Args:
+    --|     mesh - The mesh to index, must outlive the index
+    --|     x_buckets - Number of buckets along x
+    --|     angle_buckets - Number of buckets around the axis
+    --| Return:
+    --|     A RegionIndex Object
+    --|-------------------------------------------------------------------------
+    */
+    RegionIndex(const TriangleMesh* mesh, size_t x_buckets = 64, size_t angle_buckets = 64);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Finds the Triangles that reach into a region
+    --| Args:
+    --|     region - The region to look in
+    --|     triangles - Gets the Triangle numbers, smallest first
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Query(const SliceRegion &region, std::vector<unsigned int> &triangles) const;
+
+private:
+    // Bucket of an x coordinate
+    size_t XBucket(float x) const;
+    
+    // Bucket of an angle from 0, past a full turn is not wrapped
+    size_t AngleBucket(float angle) const;
+    
+    // Whether a Triangle really reaches into a region
+    bool Overlaps(unsigned int t, const SliceRegion &region) const;
+    
+    size_t x_buckets;
+    size_t angle_buckets;
+    float x_lower;
+    float x_scale;
+    
+    // Extent of every Triangle along x
+    std::vector<float> tri_x_min;
+    std::vector<float> tri_x_max;
+    
+    // Angles every Triangle covers, from start through span, span < 0 for all of them
+    std::vector<float> tri_angle_start;
+    std::vector<float> tri_angle_span;
+    
+    // Triangles of each x and angle bucket, packed one bucket after another
+    std::vector<size_t> bucket_start;
+    std::vector<unsigned int> bucket_triangles;
+    
+    // Triangles around the axis in each x bucket, packed the same way
+    std::vector<size_t> axis_start;
+    std::vector<unsigned int> axis_triangles;
+};
+
+#endif //_REGION_INDEX_H_
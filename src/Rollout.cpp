@@ -0,0 +1,344 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "Rollout.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const float TWO_PI = 6.28318530717958647692f;
+static const float HALF_PI = 1.57079632679489661923f;
+static const float ONE_PI = 3.14159265358979323846f;
+
+// 2*pi for the double rollout, cast down it is TWO_PI
+static const double TWO_PI_EXACT = 6.28318530717958647692;
+
+// Fraction of a turn a segment may run backwards before it counts as crossing the seam
+static const float SEAM_TOLERANCE = 1e-3f;
+
+// Points unrolled per vector operation
+static const size_t ROLLOUT_BATCH = 4;
+
+// ROLLOUT_BATCH floats handled as one unit, one SSE/NEON register
+typedef float batch_float __attribute__((vector_size(ROLLOUT_BATCH * sizeof(float))));
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     The atan2 approximation, written once for a single float or a whole
+--|     batch. Every choice is a select so batches never branch.
+--| Args:
+--|     y - Sine side
+--|     x - Cosine side
+--| Return:
+--|     Angle in (-pi, pi]
+--|-------------------------------------------------------------------------
+*/
+template <typename T>
+static inline T Atan2Kernel(T y, T x)
+{
+    const T zero = T() + 0.0f;
+    const T one = zero + 1.0f;
+    
+    T ay = y < zero ? -y : y;
+    T ax = x < zero ? -x : x;
+    T hi = ay > ax ? ay : ax;
+    T lo = ay > ax ? ax : ay;
+    
+    // Ratio in [0, 1], the origin maps to 0
+    T a = lo / (hi > zero ? hi : one);
+    T s = a * a;
+    T p = zero + 0.0028662257f;
+    p = p * s - 0.0161657367f;
+    p = p * s + 0.0429096138f;
+    p = p * s - 0.0752896400f;
+    p = p * s + 0.1065626393f;
+    p = p * s - 0.1420889944f;
+    p = p * s + 0.1999355085f;
+    p = p * s - 0.3333314528f;
+    T r = a + a * s * p;
+    
+    // Unfold the octant, quadrant and sign
+    r = ay > ax ? HALF_PI - r : r;
+    r = x < zero ? ONE_PI - r : r;
+    return y < zero ? -r : r;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     seam_angle - Angle in radians, measured like theta, where the Slicyl is cut open
+--| Return:
+--|     A Rollout Object
+--|-------------------------------------------------------------------------
+*/
+Rollout::Rollout(float seam_angle)
+{
+    // Keep the seam in [-pi, pi) so theta - seam needs at most one wrap
+    seam = seam_angle - TWO_PI * floorf((seam_angle + ONE_PI) / TWO_PI);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets where the Slicyl is cut open
+--| Args:
+--|     none
+--| Return:
+--|     float - Angle in radians in [-pi, pi)
+--|-------------------------------------------------------------------------
+*/
+float Rollout::GetSeamAngle() const
+{
+    return seam;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Branch free atan2. Uses the Abramowitz & Stegun 4.4.49 polynomial
+--|     (|error| <= 2e-8 on [0,1]) after folding into the first octant.
+--|     Including float rounding the result is within 4e-7 radians of
+--|     the true angle, so an arc is good to 4e-7 * r.
+--| Args:
+--|     y - Sine side
+--|     x - Cosine side
+--| Return:
+--|     float - Angle in (-pi, pi]
+--|-------------------------------------------------------------------------
+*/
+float Rollout::FastAtan2(float y, float x)
+{
+    return Atan2Kernel<float>(y, x);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Unrolls the angles of a batch of points lying on one Slicyl. Points
+--|     are handled ROLLOUT_BATCH at a time as vectors, with a scalar loop
+--|     for whatever is left over.
+--| Args:
+--|     y - y coordinates of the points
+--|     z - z coordinates of the points
+--|     count - How many points
+--|     radius - Radius of the Slicyl
+--|     arc - Output arc lengths along the unrolled sheet, in [0, 2*pi*r)
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Rollout::RolloutArcs(const float* y, const float* z, size_t count, float radius, float* arc) const
+{
+    const batch_float zero = batch_float() + 0.0f;
+    size_t i = 0;
+    for (; i + ROLLOUT_BATCH <= count; i += ROLLOUT_BATCH)
+    {
+        batch_float by, bz;
+        memcpy(&by, y + i, sizeof(batch_float));
+        memcpy(&bz, z + i, sizeof(batch_float));
+        
+        batch_float u = Atan2Kernel<batch_float>(by, bz) - seam;
+        batch_float ba = (u < zero ? u + TWO_PI : u) * radius;
+        memcpy(arc + i, &ba, sizeof(batch_float));
+    }
+    
+    // Leftovers that don't fill a batch
+    for (; i < count; i++)
+    {
+        float u = FastAtan2(y[i], z[i]) - seam;
+        arc[i] = (u < 0.0f ? u + TWO_PI : u) * radius;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Unrolls the angles of a batch of points lying on one Slicyl in
+--|     double, with the exact atan2 so large radii keep their accuracy.
+--| Args:
+--|     y - y coordinates of the points
+--|     z - z coordinates of the points
+--|     count - How many points
+--|     radius - Radius of the Slicyl
+--|     arc - Output arc lengths along the unrolled sheet, in [0, 2*pi*r)
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Rollout::RolloutArcs(const double* y, const double* z, size_t count, double radius, double* arc) const
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        double u = atan2(y[i], z[i]) - (double)seam;
+        arc[i] = (u < 0.0 ? u + TWO_PI_EXACT : u) * radius;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Unrolls every segment found on one Slicyl into slicepieces,
+--|     splitting those that cross the seam.
+--|     Segments must run the way theta grows, as FindSegments makes them.
+--|     Real is the precision it is worked out in, float or double; the
+--|     slicepieces are stored in float either way.
+--| Args:
+--|     segments - Intersection segments on the Slicyl
+--|     radius - Radius of the Slicyl
+--|     out - Vector the slicepieces get appended to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+template <typename Real>
+void Rollout::RolloutLayer(const std::vector<LineSegT<Real> > &segments, Real radius, std::vector<slicepiece> &out) const
+{
+    RolloutLayer(CylinderSurface<Real>(radius), segments, out);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Unrolls every segment found on one layer of any surface into
+--|     slicepieces, splitting those that cross the seam. The surface
+--|     policy says where each point goes on the sheet.
+--|     Segments must run the way theta grows, as CutSegments makes them.
+--| Args:
+--|     surface - The surface policy for the layer (see Surface.h)
+--|     segments - Intersection segments on the layer
+--|     out - Vector the slicepieces get appended to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+template <typename Surface>
+void Rollout::RolloutLayer(const Surface &surface, const std::vector<LineSegT<typename Surface::Real> > &segments, std::vector<slicepiece> &out) const
+{
+    typedef typename Surface::Real Real;
+    const Real radius = surface.ArcRadius();
+    
+    // Gather every endpoint so the whole layer is unrolled in batches
+    const size_t count = segments.size() * 2;
+    std::vector<Real> y(count);
+    std::vector<Real> z(count);
+    std::vector<Real> arc(count);
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        y[2*i] = surface.AngleY(segments[i].pt0);
+        z[2*i] = surface.AngleZ(segments[i].pt0);
+        y[2*i + 1] = surface.AngleY(segments[i].pt1);
+        z[2*i + 1] = surface.AngleZ(segments[i].pt1);
+    }
+    if (count > 0)
+    {
+        RolloutArcs(&y[0], &z[0], count, radius, &arc[0]);
+    }
+    
+    const Real circumference = (Real)TWO_PI_EXACT * radius;
+    const Real tolerance = (Real)SEAM_TOLERANCE * circumference;
+    out.reserve(out.size() + segments.size());
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        PointT<Real> a(surface.SheetX(segments[i].pt0), arc[2*i], radius);
+        PointT<Real> b(surface.SheetX(segments[i].pt1), arc[2*i + 1], radius);
+        
+        // Segments run the way theta grows, so going backwards means going over
+        // the seam. Going back by a hair is just rounding on a segment that
+        // runs straight along x.
+        Real span = b.y - a.y;
+        if (span < -tolerance)
+        {
+            span += circumference;
+            Real t = (circumference - a.y) / span;
+            Real x = a.x + (b.x - a.x) * t;
+            
+            PointT<Real> a_end(x, circumference, radius);
+            PointT<Real> b_start(x, Real(0), radius);
+            out.push_back(slicepiece(point(a), point(a_end), (float)std::sqrt((x - a.x)*(x - a.x) + (circumference - a.y)*(circumference - a.y))));
+            out.push_back(slicepiece(point(b_start), point(b), (float)std::sqrt((b.x - x)*(b.x - x) + b.y*b.y)));
+        }
+        else
+        {
+            out.push_back(slicepiece(point(a), point(b), (float)std::sqrt((b.x - a.x)*(b.x - a.x) + span*span)));
+        }
+    }
+}
+
+// The precisions and surfaces the slicer runs with
+template void Rollout::RolloutLayer<float>(const std::vector<LineSegT<float> > &segments, float radius, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<double>(const std::vector<LineSegT<double> > &segments, double radius, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<CylinderSurface<float> >(const CylinderSurface<float> &surface, const std::vector<LineSegT<float> > &segments, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<CylinderSurface<double> >(const CylinderSurface<double> &surface, const std::vector<LineSegT<double> > &segments, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<ConeSurface<float> >(const ConeSurface<float> &surface, const std::vector<LineSegT<float> > &segments, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<ConeSurface<double> >(const ConeSurface<double> &surface, const std::vector<LineSegT<double> > &segments, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<SphereSurface<float> >(const SphereSurface<float> &surface, const std::vector<LineSegT<float> > &segments, std::vector<slicepiece> &out) const;
+template void Rollout::RolloutLayer<SphereSurface<double> >(const SphereSurface<double> &surface, const std::vector<LineSegT<double> > &segments, std::vector<slicepiece> &out) const;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Turns the perimeter of a rolled out layer into a closed outline.
+--|     Cutting the Slicyl open splits every contour crossing the seam, so
+--|     along the seam the material starts and stops at each split. The
+--|     matching stretches of both sheet edges are added to close it up.
+--| Args:
+--|     perimeter - The slicepieces of one rolled out layer
+--|     outline - Vector the closed outline gets appended to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Rollout::CloseOutline(const std::vector<slicepiece> &perimeter, std::vector<LineSeg> &outline)
+{
+    std::vector<float> seam_x;
+    float top = 0.0f;
+    for (size_t i = 0; i < perimeter.size(); i++)
+    {
+        if (perimeter[i].a.y <= 0.0f)
+        {
+            seam_x.push_back(perimeter[i].a.x);
+        }
+        if (perimeter[i].b.y <= 0.0f)
+        {
+            seam_x.push_back(perimeter[i].b.x);
+        }
+        top = std::max(top, std::max(perimeter[i].a.y, perimeter[i].b.y));
+    }
+    std::sort(seam_x.begin(), seam_x.end());
+    
+    outline.reserve(outline.size() + perimeter.size() + seam_x.size());
+    for (size_t i = 0; i < perimeter.size(); i++)
+    {
+        outline.push_back(LineSeg(perimeter[i].a, perimeter[i].b));
+    }
+    for (size_t i = 0; i + 1 < seam_x.size(); i += 2)
+    {
+        outline.push_back(LineSeg(point(seam_x[i], 0.0f), point(seam_x[i+1], 0.0f)));
+        outline.push_back(LineSeg(point(seam_x[i], top), point(seam_x[i+1], top)));
+    }
+}
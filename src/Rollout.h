@@ -0,0 +1,178 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _ROLLOUT_H_
+#define _ROLLOUT_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "Surface.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that unrolls the points of a Slicyl onto a flat sheet.
+--|
+--| A point (x, y, z) on a Slicyl of radius r goes to (x, arc, r) where
+--| arc = r * (theta - seam) wrapped into [0, 2*pi*r) and theta = atan2(y, z)
+--| is the full angle around the x axis measured from +z towards +y.
+--| Segments that cross the seam are split so nothing wraps around the sheet.
+--|-------------------------------------------------------------------------
+*/
+class Rollout
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     seam_angle - Angle in radians, measured like theta, where the Slicyl is cut open
+    --| Return:
+    --|     A Rollout Object
+    --|-------------------------------------------------------------------------
+    */
+    Rollout(float seam_angle = 0.0f);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets where the Slicyl is cut open
+    --| Args:
+    --|     none
+    --| Return:
+    --|     float - Angle in radians in [-pi, pi)
+    --|-------------------------------------------------------------------------
+    */
+    float GetSeamAngle() const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Branch free atan2. Uses the Abramowitz & Stegun 4.4.49 polynomial
+    --|     (|error| <= 2e-8 on [0,1]) after folding into the first octant.
+    --|     Including float rounding the result is within 4e-7 radians of
+    --|     the true angle, so an arc is good to 4e-7 * r.
+    --| Args:
+    --|     y - Sine side
+    --|     x - Cosine side
+    --| Return:
+    --|     float - Angle in (-pi, pi]
+    --|-------------------------------------------------------------------------
+    */
+    static float FastAtan2(float y, float x);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Unrolls the angles of a batch of points lying on one Slicyl. Points
+    --|     are handled ROLLOUT_BATCH at a time as vectors, with a scalar loop
+    --|     for whatever is left over.
+    --| Args:
+    --|     y - y coordinates of the points
+    --|     z - z coordinates of the points
+    --|     count - How many points
+    --|     radius - Radius of the Slicyl
+    --|     arc - Output arc lengths along the unrolled sheet, in [0, 2*pi*r)
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void RolloutArcs(const float* y, const float* z, size_t count, float radius, float* arc) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Unrolls the angles of a batch of points lying on one Slicyl in
+    --|     double, with the exact atan2 so large radii keep their accuracy.
+    --| Args:
+    --|     y - y coordinates of the points
+    --|     z - z coordinates of the points
+    --|     count - How many points
+    --|     radius - Radius of the Slicyl
+    --|     arc - Output arc lengths along the unrolled sheet, in [0, 2*pi*r)
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void RolloutArcs(const double* y, const double* z, size_t count, double radius, double* arc) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Unrolls every segment found on one Slicyl into slicepieces,
+    --|     splitting those that cross the seam.
+    --|     Segments must run the way theta grows, as FindSegments makes them.
+    --|     Real is the precision it is worked out in, float or double; the
+    --|     slicepieces are stored in float either way.
+    --| Args:
+    --|     segments - Intersection segments on the Slicyl
+    --|     radius - Radius of the Slicyl
+    --|     out - Vector the slicepieces get appended to
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Real>
+    void RolloutLayer(const std::vector<LineSegT<Real> > &segments, Real radius, std::vector<slicepiece> &out) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Unrolls every segment found on one layer of any surface into
+    --|     slicepieces, splitting those that cross the seam. The surface
+    --|     policy says where each point goes on the sheet.
+    --|     Segments must run the way theta grows, as CutSegments makes them.
+    --| Args:
+    --|     surface - The surface policy for the layer (see Surface.h)
+    --|     segments - Intersection segments on the layer
+    --|     out - Vector the slicepieces get appended to
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    void RolloutLayer(const Surface &surface, const std::vector<LineSegT<typename Surface::Real> > &segments, std::vector<slicepiece> &out) const;
+
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Turns the perimeter of a rolled out layer into a closed outline.
+    --|     Cutting the Slicyl open splits every contour crossing the seam, so
+    --|     along the seam the material starts and stops at each split. The
+    --|     matching stretches of both sheet edges are added to close it up.
+    --| Args:
+    --|     perimeter - The slicepieces of one rolled out layer
+    --|     outline - Vector the closed outline gets appended to
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    static void CloseOutline(const std::vector<slicepiece> &perimeter, std::vector<LineSeg> &outline);
+
+private:
+    // Where the Slicyl is cut open, in radians
+    float seam;
+};
+
+#endif //_ROLLOUT_H_
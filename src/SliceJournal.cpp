@@ -0,0 +1,344 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "SliceJournal.h"
+
+#include <cstring>
+#include <errno.h>
+#include <unistd.h>
+#include "Triangle.h"
+#include "Fnv.h"
+#include "Log.h"
+
+static const char JOURNAL_MAGIC[4] = {'S', 'L', 'C', 'J'};
+static const uint32_t JOURNAL_VERSION = 1;
+
+// Magic, version, two hashes and the layer count
+static const size_t HEADER_SIZE = 4 + sizeof(uint32_t) + 2 * sizeof(uint64_t) + sizeof(uint32_t);
+
+// Index, radius and piece count in front of every record
+static const size_t RECORD_SIZE = 3 * sizeof(uint32_t);
+
+// A slicepiece is stored as its seven floats
+static const size_t PIECE_FLOATS = 7;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     sync_seconds - How often what was appended is flushed to disk
+--| Return:
+--|     A SliceJournal Object
+--|-------------------------------------------------------------------------
+*/
+SliceJournal::SliceJournal(double sync_seconds) : sync_seconds(sync_seconds), file(NULL), file_name(NULL)
+{
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor. Closes the journal.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+SliceJournal::~SliceJournal()
+{
+    Close();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Starts a new, empty journal, replacing any old one
+--| Args:
+--|     file_name - Name of the journal file
+--|     mesh_hash - HashMesh of the mesh being sliced
+--|     settings_hash - Slicer::HashSettings of the run
+--|     layers - Number of layers in the run
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool SliceJournal::Create(const char* file_name, uint64_t mesh_hash, uint64_t settings_hash, size_t layers)
+{
+    Close();
+    this->file_name = file_name;
+    file = fopen(file_name, "wb");
+    if (!file)
+    {
+        LogPrintf("ERROR opening %s for writing!\n", file_name);
+        return false;
+    }
+    unsigned char header[HEADER_SIZE];
+    const uint32_t count = (uint32_t)layers;
+    memcpy(header, JOURNAL_MAGIC, 4);
+    memcpy(header + 4, &JOURNAL_VERSION, sizeof(uint32_t));
+    memcpy(header + 8, &mesh_hash, sizeof(uint64_t));
+    memcpy(header + 16, &settings_hash, sizeof(uint64_t));
+    memcpy(header + 24, &count, sizeof(uint32_t));
+    if (fwrite(header, 1, HEADER_SIZE, file) != HEADER_SIZE || !Sync())
+    {
+        LogPrintf("ERROR writing %s!\n", file_name);
+        return false;
+    }
+    LogPrintf("Journalling finished layers into %s every %0.0f s\n", file_name, sync_seconds);
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Opens the journal of an earlier run to carry on with, reading the
+--|     layers it holds. A half written last record is cut off. Without a
+--|     journal file a new one is started.
+--| Args:
+--|     file_name - Name of the journal file
+--|     mesh_hash - HashMesh of the mesh being sliced
+--|     settings_hash - Slicer::HashSettings of the run
+--|     layers - Number of layers in the run
+--|     done - Gets the layers the journal holds
+--| Return:
+--|     bool - false if the journal is for another mesh or other settings,
+--|            or cannot be read
+--|-------------------------------------------------------------------------
+*/
+bool SliceJournal::Resume(const char* file_name, uint64_t mesh_hash, uint64_t settings_hash, size_t layers, SlicedLayers* done)
+{
+    Close();
+    FILE* f = fopen(file_name, "rb");
+    if (!f)
+    {
+        if (errno != ENOENT)
+        {
+            LogPrintf("ERROR opening %s for reading!\n", file_name);
+            return false;
+        }
+        LogPrintf("No journal %s to resume from, starting over\n", file_name);
+        return Create(file_name, mesh_hash, settings_hash, layers);
+    }
+    std::vector<unsigned char> buffer;
+    unsigned char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    fclose(f);
+    
+    // Only a run of the same mesh and settings may carry on
+    uint32_t version = 0, count = 0;
+    uint64_t old_mesh = 0, old_settings = 0;
+    if (buffer.size() < HEADER_SIZE || memcmp(&buffer[0], JOURNAL_MAGIC, 4) != 0)
+    {
+        LogPrintf("ERROR %s is not a slicyl journal!\n", file_name);
+        return false;
+    }
+    memcpy(&version, &buffer[4], sizeof(uint32_t));
+    memcpy(&old_mesh, &buffer[8], sizeof(uint64_t));
+    memcpy(&old_settings, &buffer[16], sizeof(uint64_t));
+    memcpy(&count, &buffer[24], sizeof(uint32_t));
+    if (version != JOURNAL_VERSION)
+    {
+        LogPrintf("ERROR %s has unsupported version %u!\n", file_name, version);
+        return false;
+    }
+    if (old_mesh != mesh_hash)
+    {
+        LogPrintf("ERROR %s was written for a different mesh!\n", file_name);
+        return false;
+    }
+    if (old_settings != settings_hash || count != layers)
+    {
+        LogPrintf("ERROR %s was written with different radii or slicing options!\n", file_name);
+        return false;
+    }
+    
+    // Read records up to the first one that did not make it to disk whole
+    done->Resize(layers);
+    size_t pos = HEADER_SIZE;
+    size_t read_back = 0;
+    while (pos + RECORD_SIZE <= buffer.size())
+    {
+        uint32_t index, pieces;
+        float radius;
+        memcpy(&index, &buffer[pos], sizeof(uint32_t));
+        memcpy(&radius, &buffer[pos + 4], sizeof(float));
+        memcpy(&pieces, &buffer[pos + 8], sizeof(uint32_t));
+        const size_t body = (size_t)pieces * PIECE_FLOATS * sizeof(float);
+        const size_t end = pos + RECORD_SIZE + body + sizeof(uint64_t);
+        if (index >= layers || end > buffer.size())
+        {
+            break;
+        }
+        uint64_t stored;
+        memcpy(&stored, &buffer[end - sizeof(uint64_t)], sizeof(uint64_t));
+        if (stored != Fnv1a(&buffer[pos], RECORD_SIZE + body))
+        {
+            break;
+        }
+        std::vector<slicepiece> layer;
+        layer.reserve(pieces);
+        for (size_t i = 0; i < pieces; i++)
+        {
+            float v[PIECE_FLOATS];
+            memcpy(v, &buffer[pos + RECORD_SIZE + i * sizeof(v)], sizeof(v));
+            layer.push_back(slicepiece(point(v[0], v[1], v[2]), point(v[3], v[4], v[5]), v[6]));
+        }
+        done->SetLayer(index, layer, radius);
+        read_back++;
+        pos = end;
+    }
+    
+    // Carry on appending right after the last whole record
+    this->file_name = file_name;
+    file = fopen(file_name, "r+b");
+    if (!file || ftruncate(fileno(file), (off_t)pos) != 0 || fseek(file, (long)pos, SEEK_SET) != 0)
+    {
+        LogPrintf("ERROR opening %s for writing!\n", file_name);
+        return false;
+    }
+    if (pos != buffer.size())
+    {
+        LogPrintf("Dropped %lu bytes of a layer %s did not finish writing\n", (unsigned long)(buffer.size() - pos), file_name);
+    }
+    LogPrintf("Resuming from %s with %lu of the %lu layers done\n", file_name, (unsigned long)read_back, (unsigned long)layers);
+    last_sync = std::chrono::steady_clock::now();
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Appends a finished layer, flushing to disk when the last flush is
+--|     sync_seconds old
+--| Args:
+--|     index - Layer number
+--|     radius - Layer radius
+--|     layer - The slicepieces of the layer
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool SliceJournal::Append(size_t index, float radius, const std::vector<slicepiece> &layer)
+{
+    if (!file)
+    {
+        return false;
+    }
+    const uint32_t header[3] = {(uint32_t)index, 0, (uint32_t)layer.size()};
+    std::vector<unsigned char> record(RECORD_SIZE + layer.size() * PIECE_FLOATS * sizeof(float));
+    memcpy(&record[0], header, RECORD_SIZE);
+    memcpy(&record[4], &radius, sizeof(float));
+    for (size_t i = 0; i < layer.size(); i++)
+    {
+        const slicepiece &sp = layer[i];
+        const float v[PIECE_FLOATS] = {sp.a.x, sp.a.y, sp.a.z, sp.b.x, sp.b.y, sp.b.z, sp.distance};
+        memcpy(&record[RECORD_SIZE + i * sizeof(v)], v, sizeof(v));
+    }
+    const uint64_t hash = Fnv1a(&record[0], record.size());
+    if (fwrite(&record[0], 1, record.size(), file) != record.size() || fwrite(&hash, sizeof(hash), 1, file) != 1)
+    {
+        LogPrintf("ERROR writing %s!\n", file_name);
+        return false;
+    }
+    if (std::chrono::duration<double>(std::chrono::steady_clock::now() - last_sync).count() >= sync_seconds)
+    {
+        return Sync();
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Flushes what is left to disk and closes the journal
+--| Args:
+--|     none
+--| Return:
+--|     bool - true if everything appended is on disk
+--|-------------------------------------------------------------------------
+*/
+bool SliceJournal::Close()
+{
+    if (!file)
+    {
+        return true;
+    }
+    bool ok = Sync();
+    ok = (fclose(file) == 0) && ok;
+    file = NULL;
+    return ok;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Hashes the vertices of every Triangle of a mesh, in order
+--| Args:
+--|     mesh - The mesh, already moved where it is sliced
+--| Return:
+--|     uint64_t - The hash
+--|-------------------------------------------------------------------------
+*/
+uint64_t SliceJournal::HashMesh(const TriangleMesh* mesh)
+{
+    uint64_t hash = FNV_OFFSET;
+    for (size_t i = 0; i < mesh->GetMeshSize(); i++)
+    {
+        const Triangle &tri = mesh->GetTriangle((int)i);
+        for (int k = 0; k < 3; k++)
+        {
+            const point &p = tri.GetVertex(k);
+            const float v[3] = {p.x, p.y, p.z};
+            hash = Fnv1a(v, sizeof(v), hash);
+        }
+    }
+    return hash;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Flushes everything appended so far to disk
+--| Args:
+--|     none
+--| Return:
+--|     bool - true on success
+--|-------------------------------------------------------------------------
+*/
+bool SliceJournal::Sync()
+{
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0)
+    {
+        LogPrintf("ERROR flushing %s to disk!\n", file_name);
+        return false;
+    }
+    last_sync = std::chrono::steady_clock::now();
+    return true;
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef _SLICE_JOURNAL_H_
+#define _SLICE_JOURNAL_H_
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+#include "SlicedLayers.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that keeps finished layers on disk while a long slice runs, so a
+--| run that gets killed can be resumed instead of started over.
+--|
+--| Layers are appended as they finish and the file is flushed to disk
+--| with fsync every so many seconds, so at most that much work is lost.
+--| The slicepieces are kept as they are, not quantized like a .slc file,
+--| so resumed layers are the same as freshly sliced ones. A journal only
+--| resumes a run with the same mesh and settings, which the header holds
+--| hashes of. Each record ends in a hash of itself, so a record that was
+--| only partly written when the run died is found and dropped.
+--|     "SLCJ" | uint32 version | uint64 mesh hash | uint64 settings hash | uint32 layers
+--|     { uint32 index | float radius | uint32 pieces | slicepiece[pieces] | uint64 hash }*
+--|-------------------------------------------------------------------------
+*/
+class SliceJournal
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     sync_seconds - How often what was appended is flushed to disk
+    --| Return:
+    --|     A SliceJournal Object
+    --|-------------------------------------------------------------------------
+    */
+    SliceJournal(double sync_seconds = 30.0);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor. Closes the journal.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    ~SliceJournal();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Starts a new, empty journal, replacing any old one
+    --| Args:
+    --|     file_name - Name of the journal file
+    --|     mesh_hash - HashMesh of the mesh being sliced
+    --|     settings_hash - Slicer::HashSettings of the run
+    --|     layers - Number of layers in the run
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool Create(const char* file_name, uint64_t mesh_hash, uint64_t settings_hash, size_t layers);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Opens the journal of an earlier run to carry on with, reading the
+    --|     layers it holds. A half written last record is cut off. Without a
+    --|     journal file a new one is started.
+    --| Args:
+    --|     file_name - Name of the journal file
+    --|     mesh_hash - HashMesh of the mesh being sliced
+    --|     settings_hash - Slicer::HashSettings of the run
+    --|     layers - Number of layers in the run
+    --|     done - Gets the layers the journal holds
+    --| Return:
+    --|     bool - false if the journal is for another mesh or other settings,
+    --|            or cannot be read
+    --|-------------------------------------------------------------------------
+    */
+    bool Resume(const char* file_name, uint64_t mesh_hash, uint64_t settings_hash, size_t layers, SlicedLayers* done);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Appends a finished layer, flushing to disk when the last flush is
+    --|     sync_seconds old
+    --| Args:
+    --|     index - Layer number
+    --|     radius - Layer radius
+    --|     layer - The slicepieces of the layer
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool Append(size_t index, float radius, const std::vector<slicepiece> &layer);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Flushes what is left to disk and closes the journal
+    --| Args:
+    --|     none
+    --| Return:
+    --|     bool - true if everything appended is on disk
+    --|-------------------------------------------------------------------------
+    */
+    bool Close();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Hashes the vertices of every Triangle of a mesh, in order
+    --| Args:
+    --|     mesh - The mesh, already moved where it is sliced
+    --| Return:
+    --|     uint64_t - The hash
+    --|-------------------------------------------------------------------------
+    */
+    static uint64_t HashMesh(const TriangleMesh* mesh);
+
+private:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Flushes everything appended so far to disk
+    --| Args:
+    --|     none
+    --| Return:
+    --|     bool - true on success
+    --|-------------------------------------------------------------------------
+    */
+    bool Sync();
+    
+    // How often what was appended is flushed to disk
+    double sync_seconds;
+    // The open journal, NULL when closed
+    FILE* file;
+    // Name of the journal, for messages
+    const char* file_name;
+    // When the journal was last flushed to disk
+    std::chrono::steady_clock::time_point last_sync;
+};
+
+#endif //_SLICE_JOURNAL_H_
@@ -24,6 +24,10 @@ THE SOFTWARE.
 
 #include "SlicedLayers.h"
 
+#include <cmath>
+
+static const float TWO_PI = 6.28318530717958647692f;
+
 /*
 --|-------------------------------------------------------------------------
 --| Purpose:
@@ -80,8 +84,27 @@ std::vector<std::vector<slicepiece> > SlicedLayers::GetSlicedLayers()
 --|-------------------------------------------------------------------------
 */
 void SlicedLayers::AddLayer(std::vector<slicepiece> &layer) 
+{
+    // After rollout every point sits at z = radius
+    AddLayer(layer, layer.empty() ? 0.0f : layer[0].a.z);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds a new outer layer for one slice and remembers its Slicyl radius
+--| Args:
+--|     layer - The slicepieces of the layer
+--|     radius - Radius of the Slicyl the layer was cut at
+--| Return:
+--|     None
+--|-------------------------------------------------------------------------
+*/
+void SlicedLayers::AddLayer(std::vector<slicepiece> &layer, float radius) 
 {
     all_layers.push_back(layer);
+    layer_radii.push_back(radius);
+    layer_done.push_back(1);
 }
 
 /*
@@ -97,6 +120,52 @@ void SlicedLayers::AddLayer(std::vector<slicepiece> &layer)
 void SlicedLayers::RemovePiece()
 {
     all_layers.pop_back();
+    layer_radii.pop_back();
+    layer_done.pop_back();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes room for a number of layers, new ones start out empty and
+--|     not yet sliced, so they can then be filled in any order
+--| Args:
+--|     count - How many layers there should be
+--| Return:
+--|     None
+--|-------------------------------------------------------------------------
+*/
+void SlicedLayers::Resize(size_t count)
+{
+    all_layers.resize(count);
+    layer_radii.resize(count, 0.0f);
+    layer_done.resize(count, 0);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Fills in the layer at a given index, growing the set if needed.
+--|     Different layers may be set from different threads at the same
+--|     time as long as the set is already big enough.
+--| Args:
+--|     i - Which layer is being filled in
+--|     layer - The slicepieces of the layer, taken over and left empty
+--|     radius - Radius of the Slicyl the layer was cut at
+--| Return:
+--|     None
+--|-------------------------------------------------------------------------
+*/
+void SlicedLayers::SetLayer(int i, std::vector<slicepiece> &layer, float radius)
+{
+    if ((size_t)i >= all_layers.size())
+    {
+        Resize(i + 1);
+    }
+    all_layers[i].swap(layer);
+    layer.clear();
+    layer_radii[i] = radius;
+    layer_done[i] = 1;
 }
 
 /*
@@ -124,7 +193,92 @@ size_t SlicedLayers::GetSize() const
 --|     const vector containing all the slice pieces at the requested slice
 --|-------------------------------------------------------------------------
 */
-const std::vector<slicepiece> SlicedLayers::GetLayer(int i)
+const std::vector<slicepiece>& SlicedLayers::GetLayer(int i) const
 {
     return all_layers[i];
-}
\ No newline at end of file
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets a specific layer for rearranging. Different layers may be
+--|     worked on from different threads at the same time.
+--| Args:
+--|     i - Which layer is being requested
+--| Return:
+--|     vector containing all the slice pieces at the requested slice
+--|-------------------------------------------------------------------------
+*/
+std::vector<slicepiece>& SlicedLayers::GetLayer(int i)
+{
+    return all_layers[i];
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the Slicyl radius of a specific layer
+--| Args:
+--|     i - Which layer is being requested
+--| Return:
+--|     float - Radius the layer was cut at
+--|-------------------------------------------------------------------------
+*/
+float SlicedLayers::GetLayerRadius(int i) const
+{
+    return layer_radii[i];
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Tells whether a layer has been sliced yet, as opposed to just
+--|     being room made by Resize
+--| Args:
+--|     i - Which layer is being requested
+--| Return:
+--|     bool - true if the layer was added or set
+--|-------------------------------------------------------------------------
+*/
+bool SlicedLayers::HasLayer(int i) const
+{
+    return layer_done[i] != 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Works out the grid the layers are laid out on for previews. Layers
+--|     fill rows of about sqrt(n) cells, each cell 1.5 times the mesh width
+--|     and 1.5 times the taller of the mesh and the largest circumference.
+--| Args:
+--|     aabbSize - Size of the mesh bounding box
+--|     per_row - Gets the number of layers in each row
+--|     cell_width - Gets the x spacing of the cells
+--|     cell_height - Gets the y spacing of the cells
+--| Return:
+--|     None
+--|-------------------------------------------------------------------------
+*/
+void SlicedLayers::GetGridLayout(const point &aabbSize, size_t &per_row, float &cell_width, float &cell_height) const
+{
+    const size_t nSlices = all_layers.size();
+    per_row = (size_t)sqrt((float)nSlices);
+    if (per_row == 0)
+    {
+        per_row = 1;
+    }
+    
+    // Rolled out layers are up to one circumference tall
+    float rowHeight = aabbSize.y;
+    for (size_t i=0; i<nSlices; i++)
+    {
+        float circumference = TWO_PI*layer_radii[i];
+        if (circumference > rowHeight)
+        {
+            rowHeight = circumference;
+        }
+    }
+    cell_width = aabbSize.x*1.5f;
+    cell_height = rowHeight*1.5f;
+}
@@ -84,6 +84,19 @@ public:
     */
     void AddLayer(std::vector<slicepiece> &layer);
     
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Adds a new outer layer for one slice and remembers its Slicyl radius
+    --| Args:
+    --|     layer - The slicepieces of the layer
+    --|     radius - Radius of the Slicyl the layer was cut at
+    --| Return:
+    --|     None
+    --|-------------------------------------------------------------------------
+    */
+    void AddLayer(std::vector<slicepiece> &layer, float radius);
+    
     /*
     --|-------------------------------------------------------------------------
     --| Purpose:
@@ -96,6 +109,35 @@ public:
     */
     void RemovePiece();
     
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Makes room for a number of layers, new ones start out empty and
+    --|     not yet sliced, so they can then be filled in any order
+    --| Args:
+    --|     count - How many layers there should be
+    --| Return:
+    --|     None
+    --|-------------------------------------------------------------------------
+    */
+    void Resize(size_t count);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Fills in the layer at a given index, growing the set if needed.
+    --|     Different layers may be set from different threads at the same
+    --|     time as long as the set is already big enough.
+    --| Args:
+    --|     i - Which layer is being filled in
+    --|     layer - The slicepieces of the layer, taken over and left empty
+    --|     radius - Radius of the Slicyl the layer was cut at
+    --| Return:
+    --|     None
+    --|-------------------------------------------------------------------------
+    */
+    void SetLayer(int i, std::vector<slicepiece> &layer, float radius);
+    
     /*
     --|-------------------------------------------------------------------------
     --| Purpose:
@@ -118,10 +160,71 @@ public:
     --|     const vector containing all the slice pieces at the requested slice
     --|-------------------------------------------------------------------------
     */
-    const std::vector<slicepiece> GetLayer(int i);
+    const std::vector<slicepiece>& GetLayer(int i) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets a specific layer for rearranging. Different layers may be
+    --|     worked on from different threads at the same time.
+    --| Args:
+    --|     i - Which layer is being requested
+    --| Return:
+    --|     vector containing all the slice pieces at the requested slice
+    --|-------------------------------------------------------------------------
+    */
+    std::vector<slicepiece>& GetLayer(int i);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the Slicyl radius of a specific layer
+    --| Args:
+    --|     i - Which layer is being requested
+    --| Return:
+    --|     float - Radius the layer was cut at
+    --|-------------------------------------------------------------------------
+    */
+    float GetLayerRadius(int i) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Tells whether a layer has been sliced yet, as opposed to just
+    --|     being room made by Resize
+    --| Args:
+    --|     i - Which layer is being requested
+    --| Return:
+    --|     bool - true if the layer was added or set
+    --|-------------------------------------------------------------------------
+    */
+    bool HasLayer(int i) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Works out the grid the layers are laid out on for previews. Layers
+    --|     fill rows of about sqrt(n) cells, each cell 1.5 times the mesh width
+    --|     and 1.5 times the taller of the mesh and the largest circumference.
+    --| Args:
+    --|     aabbSize - Size of the mesh bounding box
+    --|     per_row - Gets the number of layers in each row
+    --|     cell_width - Gets the x spacing of the cells
+    --|     cell_height - Gets the y spacing of the cells
+    --| Return:
+    --|     None
+    --|-------------------------------------------------------------------------
+    */
+    void GetGridLayout(const point &aabbSize, size_t &per_row, float &cell_width, float &cell_height) const;
 
 private:
     std::vector<std::vector<slicepiece> > all_layers;
+    
+    // Slicyl radius of each layer, parallel to all_layers
+    std::vector<float> layer_radii;
+    
+    // Whether each layer has been sliced yet, parallel to all_layers
+    std::vector<char> layer_done;
 };
 
 #endif //_SLICED_LAYERS_H_
\ No newline at end of file
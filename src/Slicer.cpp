@@ -0,0 +1,685 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "Slicer.h"
+#include "Log.h"
+#include "Trace.h"
+#include "RadiusSchedule.h"
+#include "Parallel.h"
+#include "Fnv.h"
+#include "OutputSink.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor. The Slicyls are cut open along the +z axis.
+--| Args:
+--|     none
+--| Return:
+--|     A Slicer Object
+--|-------------------------------------------------------------------------
+*/
+Slicer::Slicer(void) : rollout(0.0f), precision(PRECISION_FLOAT), robust(false), placement(NULL)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets where the Slicyls are cut open for rollout
+--| Args:
+--|     seam_angle - Angle in radians around the x axis, measured from +z towards +y
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SetSeamAngle(float seam_angle)
+{
+    rollout = Rollout(seam_angle);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses what the Slicyls are worked out in. Float is fastest,
+--|     double keeps large radii accurate. Layers are stored in float
+--|     either way.
+--| Args:
+--|     precision - PRECISION_FLOAT (the default) or PRECISION_DOUBLE
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SetPrecision(Precision precision)
+{
+    this->precision = precision;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses robust predicates: which side of a layer each vertex is on
+--|     is worked out exactly where float can't tell, and vertices on a
+--|     layer count as outside, so Triangles sharing an edge or vertex
+--|     always agree and layers have no gaps or doubled segments. Costs a
+--|     little speed, so it is off by default.
+--| Args:
+--|     robust - True for robust predicates
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SetRobust(bool robust)
+{
+    this->robust = robust;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses the shape every layer is cut with: a cylinder (the default),
+--|     a cone or a sphere. Layer radii then mean the cone's radius at x = 0
+--|     or the sphere's radius.
+--| Args:
+--|     shape - The surface
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SetSurface(const SurfaceShape &shape)
+{
+    surface = shape;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Limits slicing to a part of the model. Only Triangles reaching into
+--|     it are sliced and the layers are clipped to it. A sector also moves
+--|     the seam to its start, so each layer runs from 0 to r * angle_span.
+--| Args:
+--|     region - The part to slice, SliceRegion() for all of it
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SetRegion(const SliceRegion &region)
+{
+    this->region = region;
+    if (region.IsSector())
+    {
+        rollout = Rollout(region.angle_start);
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Lets slicing read the per node copies of a mesh. Only the mesh the
+--|     placement was made for is read through it, any other mesh is read
+--|     where it is, so a run makes its copies once however often it slices.
+--| Args:
+--|     placement - Copies of the mesh about to be sliced, NULL for none.
+--|                 Must outlive the slicing.
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SetPlacement(const NumaPlacement* placement)
+{
+    this->placement = placement;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the mesh the calling thread should read
+--| Args:
+--|     mesh - Pointer to the TriangleMesh being sliced
+--| Return:
+--|     const TriangleMesh* - The copy on the thread's node if there is a
+--|                           placement for mesh, else mesh itself
+--|-------------------------------------------------------------------------
+*/
+const TriangleMesh* Slicer::LocalMesh(const TriangleMesh* mesh) const
+{
+    return placement && placement->GetMesh() == mesh ? placement->GetLocalMesh() : mesh;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Hashes everything besides the mesh that decides what the layers
+--|     come out as: the radii, seam, region, precision, predicates and
+--|     surface. Two runs with the same hash slice a mesh the same.
+--| Args:
+--|     radii - Slicyl radii
+--| Return:
+--|     uint64_t - The hash
+--|-------------------------------------------------------------------------
+*/
+uint64_t Slicer::HashSettings(const std::vector<float> &radii) const
+{
+    // Field by field, the padding inside the structs is not to be trusted
+    uint64_t hash = Fnv1a(radii.empty() ? NULL : &radii[0], radii.size() * sizeof(float));
+    const float seam = rollout.GetSeamAngle();
+    const float box[4] = {region.x_min, region.x_max, region.angle_start, region.angle_span};
+    const int32_t modes[3] = {(int32_t)precision, robust ? 1 : 0, (int32_t)surface.kind};
+    const float shape[4] = {surface.half_angle, surface.centre.x, surface.centre.y, surface.centre.z};
+    hash = Fnv1a(&seam, sizeof(seam), hash);
+    hash = Fnv1a(box, sizeof(box), hash);
+    hash = Fnv1a(modes, sizeof(modes), hash);
+    return Fnv1a(shape, sizeof(shape), hash);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a TriangleMesh into slicepieces according to a Slicyl
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     output_slicepieces
+--|     thickness - Thickness between Slicyls
+--|     end_radius - Largest Slicyl radius
+--|     start_radius - Smallest Slicyl radius
+--| Return:
+--|     A pointer to the created TriangleMesh
+--|-------------------------------------------------------------------------
+*/
+int Slicer::SliceMesh(const TriangleMesh* mesh, SlicedLayers* output, float thickness, float end_radius, float start_radius)
+{
+    std::vector<float> radii;
+    RadiusSchedule::Uniform(start_radius, thickness, end_radius, radii);
+    return SliceMesh(mesh, output, radii);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a TriangleMesh into slicepieces with a Slicyl at each of
+--|     the given radii. Layers are sliced in parallel, on a WorkPool
+--|     worker the idle workers of the pool pitch in, each reading its
+--|     node's copy of the mesh if SetPlacement was given one.
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     output - Gets one layer per radius, after any it already has
+--|     radii - Slicyl radii, smallest first
+--| Return:
+--|     int - 0
+--|-------------------------------------------------------------------------
+*/
+int Slicer::SliceMesh(const TriangleMesh* mesh, SlicedLayers* output, const std::vector<float> &radii)
+{
+    LogPrintf("Slicing Model Now...be patient\n");
+    std::vector<unsigned int> candidates;
+    const std::vector<unsigned int>* in_region = FindRegion(mesh, candidates);
+    
+    // Room for every layer up front, so each worker only touches its own
+    const size_t first = output->GetSize();
+    output->Resize(first + radii.size());
+    std::vector<std::array<int, 4> > layer_cuts(radii.size());
+    
+    // For each Slicyl of such a radius
+    ParallelFor(radii.size(), [&](size_t i)
+    {
+        int* cuts = &layer_cuts[i][0];
+        cuts[0] = cuts[1] = cuts[2] = cuts[3] = 0;
+        std::vector<slicepiece> all_pieces_in_layer;
+        SliceLayer(LocalMesh(mesh), in_region, radii[i], all_pieces_in_layer, cuts);
+        // Kept layers take no more room than their slicepieces
+        all_pieces_in_layer.shrink_to_fit();
+        output->SetLayer((int)(first + i), all_pieces_in_layer, radii[i]);
+    });
+    
+    int cuts[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < radii.size(); i++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            cuts[k] += layer_cuts[i][k];
+        }
+    }
+    PrintSummary(cuts, (int)radii.size());
+        
+    return 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a TriangleMesh coarse to fine. The first pass takes every
+--|     2^k-th radius, each later pass fills in the radii halfway between,
+--|     until the last pass has done every radius. Layers of a pass are
+--|     sliced in parallel and keep their index into radii throughout.
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     output - Gets one layer per radius, those not reached stay unsliced
+--|     radii - Slicyl radii, smallest first
+--|     callback - Called after every pass, returning false stops early. May be NULL
+--|     user - Handed to the callback
+--| Return:
+--|     int - How many passes were finished
+--|-------------------------------------------------------------------------
+*/
+int Slicer::SliceProgressive(const TriangleMesh* mesh, SlicedLayers* output, const std::vector<float> &radii, SlicePassCallback callback, void* user) const
+{
+    LogPrintf("Slicing Model Now, coarse to fine...\n");
+    const size_t nLayers = radii.size();
+    output->Resize(nLayers);
+    std::vector<unsigned int> candidates;
+    const std::vector<unsigned int>* in_region = FindRegion(mesh, candidates);
+    
+    // Largest power of two stride that still leaves a gap to fill in
+    size_t stride = 1;
+    int passes = 1;
+    while (stride * 2 < nLayers)
+    {
+        stride *= 2;
+        passes++;
+    }
+    
+    std::vector<std::array<int, 4> > layer_cuts(nLayers);
+    int num_slices = 0;
+    int pass = 0;
+    for (; pass < passes; pass++, stride /= 2)
+    {
+        // Every multiple of the stride not done yet, plus the outermost radius up front
+        std::vector<size_t> todo;
+        for (size_t i = 0; i < nLayers; i++)
+        {
+            if (!output->HasLayer(i) && (i % stride == 0 || (pass == 0 && i == nLayers - 1)))
+            {
+                todo.push_back(i);
+            }
+        }
+        ParallelFor(todo.size(), [&](size_t t)
+        {
+            const size_t i = todo[t];
+            int* cuts = &layer_cuts[i][0];
+            cuts[0] = cuts[1] = cuts[2] = cuts[3] = 0;
+            std::vector<slicepiece> all_pieces_in_layer;
+            SliceLayer(LocalMesh(mesh), in_region, radii[i], all_pieces_in_layer, cuts);
+            output->SetLayer(i, all_pieces_in_layer, radii[i]);
+        });
+        num_slices += (int)todo.size();
+        LogPrintf("Pass %d of %d: %lu more layers, %d of %lu done\n", pass + 1, passes, (unsigned long)todo.size(), num_slices, (unsigned long)nLayers);
+        
+        if (callback && !callback(output, pass, passes, user))
+        {
+            LogPrintf("Stopped after pass %d of %d\n", pass + 1, passes);
+            pass++;
+            break;
+        }
+    }
+    
+    int cuts[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < nLayers; i++)
+    {
+        if (output->HasLayer(i))
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                cuts[k] += layer_cuts[i][k];
+            }
+        }
+    }
+    PrintSummary(cuts, num_slices);
+    return pass;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a TriangleMesh and hands each layer to a callback instead
+--|     of keeping it. A few layers at a time, one per worker thread, are
+--|     sliced in parallel, then handed over in order and dropped.
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     radii - Slicyl radii, smallest first
+--|     callback - Gets every layer
+--|     user - Handed to the callback
+--| Return:
+--|     size_t - How many layers were handed over
+--|-------------------------------------------------------------------------
+*/
+size_t Slicer::SliceStream(const TriangleMesh* mesh, const std::vector<float> &radii, SliceLayerCallback callback, void* user) const
+{
+    LogPrintf("Slicing Model Now, layer by layer...\n");
+    std::vector<unsigned int> candidates;
+    const std::vector<unsigned int>* in_region = FindRegion(mesh, candidates);
+    
+    const size_t batch = GetThreadCount();
+    std::vector<std::vector<slicepiece> > pieces(batch);
+    std::vector<std::array<int, 4> > layer_cuts(batch);
+    int cuts[4] = {0, 0, 0, 0};
+    size_t handed = 0;
+    bool going = true;
+    for (size_t first = 0; first < radii.size() && going; first += batch)
+    {
+        const size_t count = std::min(batch, radii.size() - first);
+        ParallelFor(count, [&](size_t t)
+        {
+            int* c = &layer_cuts[t][0];
+            c[0] = c[1] = c[2] = c[3] = 0;
+            pieces[t].clear();
+            SliceLayer(LocalMesh(mesh), in_region, radii[first + t], pieces[t], c);
+        });
+        for (size_t t = 0; t < count && going; t++)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                cuts[k] += layer_cuts[t][k];
+            }
+            TRACE_SCOPE_ARG("hand over layer", "layer", first + t);
+            going = callback(first + t, radii[first + t], pieces[t], user);
+            handed++;
+        }
+    }
+    PrintSummary(cuts, (int)handed);
+    return handed;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Finds the Triangles that reach into the region, if there is one
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     candidates - Gets the Triangle numbers
+--| Return:
+--|     const vector* - candidates, or NULL when the whole mesh is sliced
+--|-------------------------------------------------------------------------
+*/
+const std::vector<unsigned int>* Slicer::FindRegion(const TriangleMesh* mesh, std::vector<unsigned int> &candidates) const
+{
+    if (!region.IsLimited())
+    {
+        return NULL;
+    }
+    RegionIndex index(mesh);
+    index.Query(region, candidates);
+    LogPrintf("Region reaches %lu of %lu Triangles\n", (unsigned long)candidates.size(), (unsigned long)mesh->GetMeshSize());
+    return &candidates;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices one Slicyl and rolls it out
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     in_region - Triangles to slice, NULL for all of them
+--|     rad - Radius of the Slicyl
+--|     pieces - Gets the rolled out slicepieces
+--|     cuts - Counts of Triangles cut into zero to three segments, added to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::SliceLayer(const TriangleMesh* mesh, const std::vector<unsigned int>* in_region, float rad, std::vector<slicepiece> &pieces, int cuts[4]) const
+{
+    TRACE_SCOPE_ARG("slice layer", "radius", rad);
+    // Pick the surface and precision once a layer, the loop over Triangles
+    // is compiled for each pair
+    const bool wide = precision == PRECISION_DOUBLE;
+    switch (surface.kind)
+    {
+    case SurfaceShape::SURFACE_CONE:
+        if (wide)
+        {
+            CutLayer(mesh, in_region, ConeSurface<double>(rad, surface.half_angle), pieces, cuts);
+        }
+        else
+        {
+            CutLayer(mesh, in_region, ConeSurface<float>(rad, surface.half_angle), pieces, cuts);
+        }
+        break;
+    case SurfaceShape::SURFACE_SPHERE:
+        if (wide)
+        {
+            CutLayer(mesh, in_region, SphereSurface<double>(rad, surface.centre), pieces, cuts);
+        }
+        else
+        {
+            CutLayer(mesh, in_region, SphereSurface<float>(rad, surface.centre), pieces, cuts);
+        }
+        break;
+    default:
+        if (wide)
+        {
+            CutLayer(mesh, in_region, CylinderSurface<double>(rad), pieces, cuts);
+        }
+        else
+        {
+            CutLayer(mesh, in_region, CylinderSurface<float>(rad), pieces, cuts);
+        }
+        break;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Cuts one layer through the Triangles and rolls it out, for one
+--|     surface policy in one precision from start to end
+--| Args:
+--|     mesh - Pointer to the TriangleMesh to be sliced
+--|     in_region - Triangles to slice, NULL for all of them
+--|     layer - The surface policy for the layer
+--|     pieces - Gets the rolled out slicepieces
+--|     cuts - Counts of Triangles cut into zero to three segments, added to
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+template <typename Surface>
+void Slicer::CutLayer(const TriangleMesh* mesh, const std::vector<unsigned int>* in_region, const Surface &layer, std::vector<slicepiece> &pieces, int cuts[4]) const
+{
+    typedef typename Surface::Real Real;
+    std::vector<LineSegT<Real> > segments_in_layer;
+    const size_t count = in_region ? in_region->size() : mesh->GetMeshSize();
+    // For each Triangle in the mesh
+    for (size_t j = 0; j < count; j++) 
+    {
+        //Grab a Triangle
+        const Triangle &tri = mesh->GetTriangle(in_region ? (*in_region)[j] : j);
+        
+        //Find where a Slicyl of such a radius cuts through this Triangle
+        LineSegT<Real> segments[3];
+        int found = robust ? tri.CutSegments<Surface, RobustPredicates>(layer, segments)
+                           : tri.CutSegments<Surface, FastPredicates>(layer, segments);
+        
+        // Keep track of how each Triangle was cut, nothing...too bad
+        cuts[found]++;
+        segments_in_layer.insert(segments_in_layer.end(), segments, segments + found);
+    }
+    
+    // Rollout the whole layer in one go
+    TRACE_SCOPE_ARG("assemble layer", "segments", segments_in_layer.size());
+    if (!in_region)
+    {
+        rollout.RolloutLayer(layer, segments_in_layer, pieces);
+        return;
+    }
+    std::vector<slicepiece> unclipped;
+    rollout.RolloutLayer(layer, segments_in_layer, unclipped);
+    
+    // Clip to the region, which is a rectangle on the sheet
+    const float lo[2] = {region.x_min, 0.0f};
+    const float hi[2] = {region.x_max, region.IsSector() ? (float)layer.ArcRadius() * region.angle_span : std::numeric_limits<float>::max()};
+    for (size_t i = 0; i < unclipped.size(); i++)
+    {
+        const point &a = unclipped[i].a;
+        const point &b = unclipped[i].b;
+        const float start[2] = {a.x, a.y};
+        const float delta[2] = {b.x - a.x, b.y - a.y};
+        float t0 = 0.0f;
+        float t1 = 1.0f;
+        for (int axis = 0; axis < 2 && t0 <= t1; axis++)
+        {
+            if (delta[axis] == 0.0f)
+            {
+                if (start[axis] < lo[axis] || start[axis] > hi[axis])
+                {
+                    t1 = -1.0f;
+                }
+                continue;
+            }
+            float ta = (lo[axis] - start[axis]) / delta[axis];
+            float tb = (hi[axis] - start[axis]) / delta[axis];
+            if (ta > tb)
+            {
+                std::swap(ta, tb);
+            }
+            t0 = std::max(t0, ta);
+            t1 = std::min(t1, tb);
+        }
+        if (t0 >= t1)
+        {
+            continue;
+        }
+        point ca(a.x + t0*delta[0], a.y + t0*delta[1], a.z);
+        point cb(a.x + t1*delta[0], a.y + t1*delta[1], b.z);
+        pieces.push_back(slicepiece(ca, cb, unclipped[i].distance * (t1 - t0)));
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Prints how the Triangles were cut
+--| Args:
+--|     cuts - Counts of Triangles cut into zero to three segments
+--|     num_slices - How many layers were sliced
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::PrintSummary(const int cuts[4], int num_slices) const
+{
+    LogPrintf("\n\n\n=======================================================================================================\n\nNo segments: %d\nOne segment: %d\nTwo segments: %d\nThree segments: %d\n\nTotal slices: %d \n\n=======================================================================================================\n\n",cuts[0],cuts[1],cuts[2],cuts[3],num_slices);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Exports a slicepiece set into GIV format
+--| Args:
+--|     output_slices - Set of slicepieces to output
+--|     aabbSize - Bounding box size
+--|     toolpaths - Optional infill to draw on top of each layer
+--|     file_name - Name of the GIV file
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Slicer::exportGIV(SlicedLayers* output_slices, const point &aabbSize, const LayerToolpaths* toolpaths, const char* file_name) 
+{
+    float dx=0, dy=0;
+
+    OutputSink* f = OutputSink::Open(file_name);
+    if (!f)
+    {
+        LogPrintf("ERROR opening %s for writing!\n", file_name);
+        return;
+    }
+    LogPrintf("Generating Output GIV file %s now...\n", file_name);
+    TRACE_SCOPE("export giv");
+    const size_t nSlices = output_slices->GetSize();
+    size_t slicePerRow;
+    float cellWidth, cellHeight;
+    output_slices->GetGridLayout(aabbSize, slicePerRow, cellWidth, cellHeight);
+
+    for (size_t i=0; i<nSlices; i++) 
+    {
+        const std::vector<slicepiece> &sp = output_slices->GetLayer(i);
+        dx = (float)(i%slicePerRow)*cellWidth;
+        dy = (float)(i/slicePerRow)*cellHeight;
+        // One formatted write per line, alternating colours
+        for (size_t j=0; j<sp.size(); ++j) 
+        {   
+            f->Printf("\n\n$line\n$color %s\n%f %f\n%f %f", (j % 2) ? "blue" : "red",
+                      dx+sp[j].a.x, dy+sp[j].a.y, dx+sp[j].b.x, dy+sp[j].b.y);
+        }
+        
+        // Infill goes on top in green
+        if (toolpaths && i < toolpaths->GetSize())
+        {
+            const std::vector<slicepiece> &fill = toolpaths->GetInfill(i);
+            for (size_t j=0; j<fill.size(); ++j)
+            {
+                f->Printf("\n\n$line\n$color green\n%f %f\n%f %f", dx+fill[j].a.x, dy+fill[j].a.y, dx+fill[j].b.x, dy+fill[j].b.y);
+            }
+        }
+    }
+    f->Close();
+    delete f;
+    LogPrintf("...Done!\n\n");
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Exports a mesh into STL
+--| Args:
+--|     mesh - Pointer to a mesh to export
+--|     file_name - Name of the stl file
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+
+void Slicer::exportSTL(TriangleMesh* mesh, const char* file_name)
+{
+    OutputSink* out = OutputSink::Open(file_name);
+    if (!out)
+    {
+        LogPrintf("ERROR opening %s for writing!\n", file_name);
+        return;
+    }
+
+    out->Printf("solid ascii\n");
+    
+    // For each Triangle in the mesh, %g writes floats the way a stream does
+    for (size_t j = 0; j < mesh->GetMeshSize(); j++) 
+    {
+        //Grab a Triangle
+        const Triangle &tri = mesh->GetTriangle(j);
+        point normal = tri.GetNormal();
+        point v0 = tri.GetVertex(0);
+        point v1 = tri.GetVertex(1);
+        point v2 = tri.GetVertex(2);
+        out->Printf("facet normal %g %g %g\nouter loop\n", normal.x, normal.y, normal.z);
+        out->Printf("vertex %g %g %g \nvertex %g %g %g \nvertex %g %g %g \n", v0.x, v0.y, v0.z, v1.x, v1.y, v1.z, v2.x, v2.y, v2.z);
+        out->Printf("endloop\nendfacet\n");
+    }
+    out->Printf("endsolid\n");
+    out->Close();
+    delete out;
+}
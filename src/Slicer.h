@@ -0,0 +1,380 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _SLICER_H_
+#define _SLICER_H_
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "dimensional_space.h"
+#include "TriangleMesh.h"
+#include "Triangle.h"
+#include "SlicedLayers.h"
+#include "Rollout.h"
+#include "LayerToolpaths.h"
+#include "RegionIndex.h"
+#include "Surface.h"
+#include "NumaPlacement.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Called after every pass of a progressive slice with the layers so far,
+--| the pass just finished and how many passes there are. Returning false
+--| stops slicing.
+--|-------------------------------------------------------------------------
+*/
+typedef bool (*SlicePassCallback)(const SlicedLayers* layers, int pass, int passes, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Called with every finished layer of a streamed slice, in order of radius.
+--| The slicepieces are only good until the callback returns. Returning
+--| false stops slicing.
+--|-------------------------------------------------------------------------
+*/
+typedef bool (*SliceLayerCallback)(size_t index, float radius, const std::vector<slicepiece> &layer, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| The class which slices
+--|-------------------------------------------------------------------------
+*/
+class Slicer
+{
+public:
+    // What the intersection and rollout kernels work in
+    enum Precision
+    {
+        PRECISION_FLOAT,
+        PRECISION_DOUBLE
+    };
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor. The Slicyls are cut open along the +z axis.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     A Slicer Object
+    --|-------------------------------------------------------------------------
+    */
+    Slicer(void);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Sets where the Slicyls are cut open for rollout
+    --| Args:
+    --|     seam_angle - Angle in radians around the x axis, measured from +z towards +y
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetSeamAngle(float seam_angle);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Chooses what the Slicyls are worked out in. Float is fastest,
+    --|     double keeps large radii accurate. Layers are stored in float
+    --|     either way.
+    --| Args:
+    --|     precision - PRECISION_FLOAT (the default) or PRECISION_DOUBLE
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetPrecision(Precision precision);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Chooses robust predicates: which side of a layer each vertex is on
+    --|     is worked out exactly where float can't tell, and vertices on a
+    --|     layer count as outside, so Triangles sharing an edge or vertex
+    --|     always agree and layers have no gaps or doubled segments. Costs a
+    --|     little speed, so it is off by default.
+    --| Args:
+    --|     robust - True for robust predicates
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetRobust(bool robust);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Chooses the shape every layer is cut with: a cylinder (the default),
+    --|     a cone or a sphere. Layer radii then mean the cone's radius at x = 0
+    --|     or the sphere's radius.
+    --| Args:
+    --|     shape - The surface
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetSurface(const SurfaceShape &shape);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Limits slicing to a part of the model. Only Triangles reaching into
+    --|     it are sliced and the layers are clipped to it. A sector also moves
+    --|     the seam to its start, so each layer runs from 0 to r * angle_span.
+    --| Args:
+    --|     region - The part to slice, SliceRegion() for all of it
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetRegion(const SliceRegion &region);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Lets slicing read the per node copies of a mesh. Only the mesh the
+    --|     placement was made for is read through it, any other mesh is read
+    --|     where it is, so a run makes its copies once however often it slices.
+    --| Args:
+    --|     placement - Copies of the mesh about to be sliced, NULL for none.
+    --|                 Must outlive the slicing.
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetPlacement(const NumaPlacement* placement);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Hashes everything besides the mesh that decides what the layers
+    --|     come out as: the radii, seam, region, precision, predicates and
+    --|     surface. Two runs with the same hash slice a mesh the same.
+    --| Args:
+    --|     radii - Slicyl radii
+    --| Return:
+    --|     uint64_t - The hash
+    --|-------------------------------------------------------------------------
+    */
+    uint64_t HashSettings(const std::vector<float> &radii) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Slices a TriangleMesh into slicepieces according to a Slicyl
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     output_slicepieces - 
+    --|     thickness - Thickness between Slicyls
+    --|     end_radius - Largest Slicyl radius
+    --|     start_radius - Smallest Slicyl radius
+    --| Return:
+    --|     A pointer to the created TriangleMesh
+    --|-------------------------------------------------------------------------
+    */
+    int SliceMesh(const TriangleMesh* mesh, SlicedLayers* output, const float thickness, float end_radius, float start_radius);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Slices a TriangleMesh into slicepieces with a Slicyl at each of
+    --|     the given radii. Layers are sliced in parallel, on a WorkPool
+    --|     worker the idle workers of the pool pitch in, each reading its
+    --|     node's copy of the mesh if SetPlacement was given one.
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     output - Gets one layer per radius, after any it already has
+    --|     radii - Slicyl radii, smallest first
+    --| Return:
+    --|     int - 0
+    --|-------------------------------------------------------------------------
+    */
+    int SliceMesh(const TriangleMesh* mesh, SlicedLayers* output, const std::vector<float> &radii);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Slices a TriangleMesh coarse to fine. The first pass takes every
+    --|     2^k-th radius, each later pass fills in the radii halfway between,
+    --|     until the last pass has done every radius. Layers of a pass are
+    --|     sliced in parallel and keep their index into radii throughout.
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     output - Gets one layer per radius, those not reached stay unsliced
+    --|     radii - Slicyl radii, smallest first
+    --|     callback - Called after every pass, returning false stops early. May be NULL
+    --|     user - Handed to the callback
+    --| Return:
+    --|     int - How many passes were finished
+    --|-------------------------------------------------------------------------
+    */
+    int SliceProgressive(const TriangleMesh* mesh, SlicedLayers* output, const std::vector<float> &radii, SlicePassCallback callback, void* user) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Slices a TriangleMesh and hands each layer to a callback instead
+    --|     of keeping it. A few layers at a time, one per worker thread, are
+    --|     sliced in parallel, then handed over in order and dropped.
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     radii - Slicyl radii, smallest first
+    --|     callback - Gets every layer
+    --|     user - Handed to the callback
+    --| Return:
+    --|     size_t - How many layers were handed over
+    --|-------------------------------------------------------------------------
+    */
+    size_t SliceStream(const TriangleMesh* mesh, const std::vector<float> &radii, SliceLayerCallback callback, void* user) const;
+
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Exports a slicepiece set into GIV format
+    --| Args:
+    --|     output_slices - Set of slicepieces to output
+    --|     aabbSize - Bounding box size
+    --|     toolpaths - Optional infill to draw on top of each layer
+    --|     file_name - Name of the GIV file
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void exportGIV(SlicedLayers* output_slices, const point &aabbSize, const LayerToolpaths* toolpaths = NULL, const char* file_name = "slicyl_out.marks");
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Exports a mesh into STL
+    --| Args:
+    --|     mesh - Pointer to a mesh to export
+    --|     file_name - Name of the stl file
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void exportSTL(TriangleMesh* mesh, const char* file_name);
+
+private:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Finds the Triangles that reach into the region, if there is one
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     candidates - Gets the Triangle numbers
+    --| Return:
+    --|     const vector* - candidates, or NULL when the whole mesh is sliced
+    --|-------------------------------------------------------------------------
+    */
+    const std::vector<unsigned int>* FindRegion(const TriangleMesh* mesh, std::vector<unsigned int> &candidates) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Slices one Slicyl and rolls it out
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     in_region - Triangles to slice, NULL for all of them
+    --|     rad - Radius of the Slicyl
+    --|     pieces - Gets the rolled out slicepieces
+    --|     cuts - Counts of Triangles cut into zero to three segments, added to
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SliceLayer(const TriangleMesh* mesh, const std::vector<unsigned int>* in_region, float rad, std::vector<slicepiece> &pieces, int cuts[4]) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Cuts one layer through the Triangles and rolls it out, for one
+    --|     surface policy in one precision from start to end
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh to be sliced
+    --|     in_region - Triangles to slice, NULL for all of them
+    --|     layer - The surface policy for the layer
+    --|     pieces - Gets the rolled out slicepieces
+    --|     cuts - Counts of Triangles cut into zero to three segments, added to
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface>
+    void CutLayer(const TriangleMesh* mesh, const std::vector<unsigned int>* in_region, const Surface &layer, std::vector<slicepiece> &pieces, int cuts[4]) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Prints how the Triangles were cut
+    --| Args:
+    --|     cuts - Counts of Triangles cut into zero to three segments
+    --|     num_slices - How many layers were sliced
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void PrintSummary(const int cuts[4], int num_slices) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the mesh the calling thread should read
+    --| Args:
+    --|     mesh - Pointer to the TriangleMesh being sliced
+    --| Return:
+    --|     const TriangleMesh* - The copy on the thread's node if there is a
+    --|                           placement for mesh, else mesh itself
+    --|-------------------------------------------------------------------------
+    */
+    const TriangleMesh* LocalMesh(const TriangleMesh* mesh) const;
+    
+    // Unrolls the segments of each Slicyl
+    Rollout rollout;
+    
+    // Part of the model to slice
+    SliceRegion region;
+    
+    // What the kernels work in
+    Precision precision;
+    
+    // Whether the kernels use RobustPredicates
+    bool robust;
+    
+    // Shape of the layers
+    SurfaceShape surface;
+    
+    // Per node copies of the mesh being sliced, NULL for none
+    const NumaPlacement* placement;
+};
+
+#endif //_SLICER_H_
\ No newline at end of file
@@ -0,0 +1,268 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _SURFACE_H_
+#define _SURFACE_H_
+
+#include <cmath>
+#include "dimensional_space.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| The shape every layer is cut with. Layer radii are the radius of the
+--| cylinder, the radius of the cone where it crosses x = 0, or the radius
+--| of the sphere.
+--|-------------------------------------------------------------------------
+*/
+typedef struct SurfaceShape
+{
+    enum Kind
+    {
+        SURFACE_CYLINDER,
+        SURFACE_CONE,
+        SURFACE_SPHERE
+    };
+    Kind kind;
+    
+    // Cone half angle in radians, the radius grows with x when positive
+    float half_angle;
+    
+    // Sphere centre
+    point centre;
+    
+    // A cylinder about the x axis
+    SurfaceShape() : kind(SURFACE_CYLINDER), half_angle(0.0f), centre(0, 0, 0) {}
+}SurfaceShape;
+
+/*
+--|-------------------------------------------------------------------------
+--| Surface policies, one layer of one shape in precision Real each. The
+--| slicing and rollout kernels are templates over them, so every shape gets
+--| its own compiled loop. A policy gives:
+--|     Level - Negative inside the surface, positive outside. Along an edge
+--|             p0 + t*(p1 - p0) it has to be a quadratic in t.
+--|     EdgeTerms - The t^2 and t coefficients of Level along an edge
+--|     Quadratic - All three coefficients of Level along an edge in any
+--|                 number type T built from doubles, worked out from the
+--|                 ends and the layer's own parameters so it can be exact
+--|     Scale - At least what Level takes away at a point, which bounds
+--|             its rounding error along with Level itself
+--|     Backwards - Whether a piece from a to b on a Triangle runs the way
+--|                 theta = atan2(y, z) about the axis shrinks
+--|     SheetX - Where a point goes across the rolled out sheet
+--|     AngleY, AngleZ - The point seen from the axis, for its theta
+--|     ArcRadius - Arc length per radian along the sheet
+--|-------------------------------------------------------------------------
+*/
+
+/*
+--|-------------------------------------------------------------------------
+--| The Slicyl: y^2 + z^2 = r^2. The sheet is the exact unrolling.
+--|-------------------------------------------------------------------------
+*/
+template <typename R>
+struct CylinderSurface
+{
+    typedef R Real;
+    R radius;
+    R r2;
+    
+    explicit CylinderSurface(R radius) : radius(radius), r2(radius * radius) {}
+    
+    R Level(const PointT<R> &p) const
+    {
+        return p.y * p.y + p.z * p.z - r2;
+    }
+    
+    R Scale(const PointT<R> &p) const { return r2; }
+    
+    void EdgeTerms(const PointT<R> &p0, const PointT<R> &p1, R &A, R &B) const
+    {
+        R v = p1.y - p0.y;
+        R w = p1.z - p0.z;
+        A = v*v + w*w;
+        B = R(2)*(p0.y*v + p0.z*w);
+    }
+    
+    template <typename T>
+    void Quadratic(const PointT<R> &p0, const PointT<R> &p1, T &A, T &B, T &C) const
+    {
+        T y0(p0.y), z0(p0.z), r(radius);
+        T v = T(p1.y) - y0;
+        T w = T(p1.z) - z0;
+        A = v*v + w*w;
+        B = T(2.0)*(y0*v + z0*w);
+        C = y0*y0 + z0*z0 - r*r;
+    }
+    
+    // Going round the Slicyl with the inside of the cut on the left turns
+    // theta backwards exactly when the winding normal has a positive x
+    bool Backwards(const PointT<R> p[3], const PointT<R> &a, const PointT<R> &b) const
+    {
+        R nx = (p[1].y - p[0].y)*(p[2].z - p[0].z) - (p[1].z - p[0].z)*(p[2].y - p[0].y);
+        return nx > R(0);
+    }
+    
+    R SheetX(const PointT<R> &p) const { return p.x; }
+    R AngleY(const PointT<R> &p) const { return p.y; }
+    R AngleZ(const PointT<R> &p) const { return p.z; }
+    R ArcRadius() const { return radius; }
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| A cone about the x axis: sqrt(y^2 + z^2) = r + x*tan(half_angle). Only
+--| the nappe with a positive radius is meant, so the apex has to stay out
+--| of the x range of the mesh. Across the sheet a point goes as far as it
+--| is along the cone's side from x = 0; along the sheet it goes r * theta,
+--| so arcs are stretched by r over the local radius.
+--|-------------------------------------------------------------------------
+*/
+template <typename R>
+struct ConeSurface
+{
+    typedef R Real;
+    R radius;
+    R slope;
+    R stretch;
+    
+    ConeSurface(R radius, R half_angle) : radius(radius), slope(std::tan(half_angle)), stretch(R(1) / std::cos(half_angle)) {}
+    
+    R Level(const PointT<R> &p) const
+    {
+        R q = radius + slope * p.x;
+        return p.y * p.y + p.z * p.z - q * q;
+    }
+    
+    // Taken from the parts of q, which may nearly cancel towards the apex
+    R Scale(const PointT<R> &p) const
+    {
+        R q = std::fabs(radius) + std::fabs(slope * p.x);
+        return q * q;
+    }
+    
+    void EdgeTerms(const PointT<R> &p0, const PointT<R> &p1, R &A, R &B) const
+    {
+        R v = p1.y - p0.y;
+        R w = p1.z - p0.z;
+        R k = slope * (p1.x - p0.x);
+        R q0 = radius + slope * p0.x;
+        A = v*v + w*w - k*k;
+        B = R(2)*(p0.y*v + p0.z*w - q0*k);
+    }
+    
+    template <typename T>
+    void Quadratic(const PointT<R> &p0, const PointT<R> &p1, T &A, T &B, T &C) const
+    {
+        T y0(p0.y), z0(p0.z), s(slope);
+        T v = T(p1.y) - y0;
+        T w = T(p1.z) - z0;
+        T k = s * (T(p1.x) - T(p0.x));
+        T q0 = T(radius) + s * T(p0.x);
+        A = v*v + w*w - k*k;
+        B = T(2.0)*(y0*v + z0*w - q0*k);
+        C = y0*y0 + z0*z0 - q0*q0;
+    }
+    
+    // Pieces are short, so the shorter way round between the ends is the way they run
+    bool Backwards(const PointT<R> p[3], const PointT<R> &a, const PointT<R> &b) const
+    {
+        return a.z * b.y - a.y * b.z < R(0);
+    }
+    
+    R SheetX(const PointT<R> &p) const { return p.x * stretch; }
+    R AngleY(const PointT<R> &p) const { return p.y; }
+    R AngleZ(const PointT<R> &p) const { return p.z; }
+    R ArcRadius() const { return radius; }
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| A sphere: |p - centre| = r, with theta measured about the line through
+--| the centre along x. The sheet is the equirectangular map: across it a
+--| point goes its arc length from the centre's x along the meridian, along
+--| it r * theta, so arcs are stretched towards the poles.
+--|-------------------------------------------------------------------------
+*/
+template <typename R>
+struct SphereSurface
+{
+    typedef R Real;
+    R radius;
+    R r2;
+    PointT<R> centre;
+    
+    SphereSurface(R radius, const point &centre) : radius(radius), r2(radius * radius), centre(centre) {}
+    
+    R Level(const PointT<R> &p) const
+    {
+        R dx = p.x - centre.x;
+        R dy = p.y - centre.y;
+        R dz = p.z - centre.z;
+        return dx*dx + dy*dy + dz*dz - r2;
+    }
+    
+    R Scale(const PointT<R> &p) const { return r2; }
+    
+    void EdgeTerms(const PointT<R> &p0, const PointT<R> &p1, R &A, R &B) const
+    {
+        R u = p1.x - p0.x;
+        R v = p1.y - p0.y;
+        R w = p1.z - p0.z;
+        A = u*u + v*v + w*w;
+        B = R(2)*((p0.x - centre.x)*u + (p0.y - centre.y)*v + (p0.z - centre.z)*w);
+    }
+    
+    template <typename T>
+    void Quadratic(const PointT<R> &p0, const PointT<R> &p1, T &A, T &B, T &C) const
+    {
+        T cx(centre.x), cy(centre.y), cz(centre.z), r(radius);
+        T dx = T(p0.x) - cx;
+        T dy = T(p0.y) - cy;
+        T dz = T(p0.z) - cz;
+        T u = T(p1.x) - T(p0.x);
+        T v = T(p1.y) - T(p0.y);
+        T w = T(p1.z) - T(p0.z);
+        A = u*u + v*v + w*w;
+        B = T(2.0)*(dx*u + dy*v + dz*w);
+        C = dx*dx + dy*dy + dz*dz - r*r;
+    }
+    
+    // Pieces are short, so the shorter way round between the ends is the way they run
+    bool Backwards(const PointT<R> p[3], const PointT<R> &a, const PointT<R> &b) const
+    {
+        return AngleZ(a) * AngleY(b) - AngleY(a) * AngleZ(b) < R(0);
+    }
+    
+    R SheetX(const PointT<R> &p) const
+    {
+        R s = (p.x - centre.x) / radius;
+        s = s < R(-1) ? R(-1) : (s > R(1) ? R(1) : s);
+        return radius * std::asin(s);
+    }
+    R AngleY(const PointT<R> &p) const { return p.y - centre.y; }
+    R AngleZ(const PointT<R> &p) const { return p.z - centre.z; }
+    R ArcRadius() const { return radius; }
+};
+
+#endif //_SURFACE_H_
@@ -0,0 +1,293 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "TilePyramid.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+#include "Parallel.h"
+#include "PngWriter.h"
+#include "Log.h"
+#include "Trace.h"
+
+// Model units are taken to be millimetres
+static const float MM_PER_INCH = 25.4f;
+
+// Colours the GIV preview uses, as RGB
+static const unsigned char TILE_COLORS[3][3] = {{255, 0, 0}, {0, 0, 255}, {0, 160, 0}};
+
+// One line of the grid in model units
+struct TileLine
+{
+    float x0, y0, x1, y1;
+    unsigned char color;
+};
+
+// A line that touches a tile, sorting groups the lines of each tile
+struct TileHit
+{
+    uint64_t tile;
+    uint32_t line;
+    
+    bool operator<(const TileHit &other) const
+    {
+        return tile < other.tile || (tile == other.tile && line < other.line);
+    }
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     dpi - Resolution of the finest level, taking model units as millimetres
+--|     tile_size - Width and height of every tile in pixels
+--| Return:
+--|     A TilePyramid Object
+--|-------------------------------------------------------------------------
+*/
+TilePyramid::TilePyramid(float dpi, size_t tile_size) : pixels_per_unit(dpi / MM_PER_INCH), tile_size(tile_size)
+{
+
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Renders and writes every non-empty tile of every level, in
+--|     parallel, then writes the index file
+--| Args:
+--|     layers - The sliced layers to draw
+--|     aabbSize - Size of the mesh bounding box, sets the grid spacing
+--|     toolpaths - Infill to draw on top, or NULL
+--|     prefix - Start of every file name
+--| Return:
+--|     bool - true if every file was written
+--|-------------------------------------------------------------------------
+*/
+bool TilePyramid::ExportTiles(const SlicedLayers* layers, const point &aabbSize, const LayerToolpaths* toolpaths, const char* prefix) const
+{
+    LogPrintf("Generating preview tiles %s_*.png now...\n", prefix);
+    
+    // Lay the layers out the same way the GIV preview does
+    const size_t nSlices = layers->GetSize();
+    size_t slicePerRow;
+    float cellWidth, cellHeight;
+    layers->GetGridLayout(aabbSize, slicePerRow, cellWidth, cellHeight);
+    
+    std::vector<TileLine> lines;
+    float min_x = std::numeric_limits<float>::max();
+    float min_y = min_x;
+    float max_x = -min_x;
+    float max_y = -min_x;
+    for (size_t i=0; i<nSlices; i++)
+    {
+        const float dx = (float)(i%slicePerRow)*cellWidth;
+        const float dy = (float)(i/slicePerRow)*cellHeight;
+        const std::vector<slicepiece> &sp = layers->GetLayer(i);
+        for (size_t j=0; j<sp.size(); ++j)
+        {
+            TileLine l = {dx+sp[j].a.x, dy+sp[j].a.y, dx+sp[j].b.x, dy+sp[j].b.y, (unsigned char)(j % 2)};
+            lines.push_back(l);
+        }
+        if (toolpaths && i < toolpaths->GetSize())
+        {
+            const std::vector<slicepiece> &fill = toolpaths->GetInfill(i);
+            for (size_t j=0; j<fill.size(); ++j)
+            {
+                TileLine l = {dx+fill[j].a.x, dy+fill[j].a.y, dx+fill[j].b.x, dy+fill[j].b.y, 2};
+                lines.push_back(l);
+            }
+        }
+    }
+    for (size_t i=0; i<lines.size(); i++)
+    {
+        min_x = std::min(min_x, std::min(lines[i].x0, lines[i].x1));
+        max_x = std::max(max_x, std::max(lines[i].x0, lines[i].x1));
+        min_y = std::min(min_y, std::min(lines[i].y0, lines[i].y1));
+        max_y = std::max(max_y, std::max(lines[i].y0, lines[i].y1));
+    }
+    if (lines.empty())
+    {
+        min_x = min_y = max_x = max_y = 0.0f;
+    }
+    
+    // Enough levels that the coarsest fits in one tile
+    const float extent = std::max(max_x - min_x, max_y - min_y) * pixels_per_unit;
+    size_t nLevels = 1;
+    while ((float)(tile_size << (nLevels - 1)) < extent && nLevels < 24)
+    {
+        nLevels++;
+    }
+    
+    std::vector<std::vector<uint64_t> > written(nLevels);
+    std::atomic<size_t> failed(0);
+    size_t total = 0;
+    for (size_t level = 0; level < nLevels; level++)
+    {
+        const float ppu = pixels_per_unit / (float)(1u << (nLevels - 1 - level));
+        const float tiles_f = (float)tile_size;
+        
+        // Bucket the lines by the tiles their bounding boxes touch
+        std::vector<TileHit> hits;
+        for (size_t i=0; i<lines.size(); i++)
+        {
+            const TileLine &l = lines[i];
+            uint32_t tx0 = (uint32_t)(((std::min(l.x0, l.x1) - min_x) * ppu) / tiles_f);
+            uint32_t tx1 = (uint32_t)(((std::max(l.x0, l.x1) - min_x) * ppu) / tiles_f);
+            uint32_t ty0 = (uint32_t)(((max_y - std::max(l.y0, l.y1)) * ppu) / tiles_f);
+            uint32_t ty1 = (uint32_t)(((max_y - std::min(l.y0, l.y1)) * ppu) / tiles_f);
+            for (uint32_t ty = ty0; ty <= ty1; ty++)
+            {
+                for (uint32_t tx = tx0; tx <= tx1; tx++)
+                {
+                    TileHit h = {((uint64_t)ty << 32) | tx, (uint32_t)i};
+                    hits.push_back(h);
+                }
+            }
+        }
+        std::sort(hits.begin(), hits.end());
+        std::vector<size_t> starts;
+        for (size_t k=0; k<hits.size(); k++)
+        {
+            if (k == 0 || hits[k].tile != hits[k-1].tile)
+            {
+                starts.push_back(k);
+            }
+        }
+        starts.push_back(hits.size());
+        
+        // Each worker draws one tile at a time, nothing is drawn twice
+        std::vector<char> drawn(starts.size() - 1, 0);
+        ParallelFor(starts.size() - 1, [&](size_t t)
+        {
+            TRACE_SCOPE("draw tile");
+            const uint64_t tile = hits[starts[t]].tile;
+            const float ox = (float)(tile & 0xFFFFFFFFu) * tiles_f;
+            const float oy = (float)(tile >> 32) * tiles_f;
+            std::vector<unsigned char> rgb(tile_size * tile_size * 3, 255);
+            bool any = false;
+            for (size_t k = starts[t]; k < starts[t+1]; k++)
+            {
+                const TileLine &l = lines[hits[k].line];
+                const float px0 = (l.x0 - min_x) * ppu - ox;
+                const float py0 = (max_y - l.y0) * ppu - oy;
+                const float px1 = (l.x1 - min_x) * ppu - ox;
+                const float py1 = (max_y - l.y1) * ppu - oy;
+                
+                // One sample per pixel along the longer axis
+                const float steps = ceilf(std::max(fabsf(px1 - px0), fabsf(py1 - py0)));
+                const size_t n = (size_t)steps + 1;
+                for (size_t s = 0; s < n; s++)
+                {
+                    const float u = steps > 0.0f ? (float)s / steps : 0.0f;
+                    const float fx = floorf(px0 + (px1 - px0) * u);
+                    const float fy = floorf(py0 + (py1 - py0) * u);
+                    if (fx < 0.0f || fy < 0.0f || fx >= tiles_f || fy >= tiles_f)
+                    {
+                        continue;
+                    }
+                    unsigned char* px = &rgb[((size_t)fy * tile_size + (size_t)fx) * 3];
+                    memcpy(px, TILE_COLORS[l.color], 3);
+                    any = true;
+                }
+            }
+            if (!any)
+            {
+                return;
+            }
+            
+            char file_name[1024];
+            snprintf(file_name, sizeof(file_name), "%s_%lu_%lu_%lu.png", prefix, (unsigned long)level,
+                     (unsigned long)(tile & 0xFFFFFFFFu), (unsigned long)(tile >> 32));
+            OutputSink* f = OutputSink::Open(file_name);
+            bool ok = f != NULL;
+            if (ok)
+            {
+                ok = WritePNG(f, &rgb[0], tile_size, tile_size, 8, PNG_RGB);
+                ok = f->Close() && ok;
+                delete f;
+            }
+            if (!ok)
+            {
+                failed++;
+                return;
+            }
+            drawn[t] = 1;
+        });
+        
+        for (size_t t=0; t+1<starts.size(); t++)
+        {
+            if (drawn[t])
+            {
+                written[level].push_back(hits[starts[t]].tile);
+            }
+        }
+        total += written[level].size();
+    }
+    
+    // Small text index of the layout and the tiles that exist
+    char index_name[1024];
+    snprintf(index_name, sizeof(index_name), "%s.idx", prefix);
+    OutputSink* f = OutputSink::Open(index_name);
+    if (!f)
+    {
+        LogPrintf("ERROR could not open %s\n", index_name);
+        return false;
+    }
+    f->Printf("slicyl_tiles 1\n");
+    f->Printf("tile_size %lu\n", (unsigned long)tile_size);
+    f->Printf("levels %lu\n", (unsigned long)nLevels);
+    f->Printf("bounds %f %f %f %f\n", min_x, min_y, max_x, max_y);
+    f->Printf("grid %lu %f %f\n", (unsigned long)slicePerRow, cellWidth, cellHeight);
+    for (size_t i=0; i<nSlices; i++)
+    {
+        f->Printf("layer %lu %f %f %f\n", (unsigned long)i, layers->GetLayerRadius(i),
+                  (float)(i%slicePerRow)*cellWidth, (float)(i/slicePerRow)*cellHeight);
+    }
+    for (size_t level = 0; level < nLevels; level++)
+    {
+        f->Printf("level %lu %f %lu\n", (unsigned long)level, pixels_per_unit / (float)(1u << (nLevels - 1 - level)),
+                  (unsigned long)written[level].size());
+        for (size_t t=0; t<written[level].size(); t++)
+        {
+            f->Printf("tile %lu %lu %lu\n", (unsigned long)level, (unsigned long)(written[level][t] & 0xFFFFFFFFu),
+                      (unsigned long)(written[level][t] >> 32));
+        }
+    }
+    bool ok = f->Close();
+    delete f;
+    
+    if (failed > 0 || !ok)
+    {
+        LogPrintf("ERROR writing %lu preview tiles!\n", (unsigned long)failed);
+        return false;
+    }
+    LogPrintf("...Done! %lu tiles over %lu zoom levels\n\n", (unsigned long)total, (unsigned long)nLevels);
+    return true;
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _TILE_PYRAMID_H_
+#define _TILE_PYRAMID_H_
+
+#include <vector>
+#include <stdio.h>
+#include "dimensional_space.h"
+#include "SlicedLayers.h"
+#include "LayerToolpaths.h"
+
+/*
+--|-------------------------------------------------------------------------
+--| Class that renders the layer grid of the GIV preview into a pyramid of
+--| fixed size PNG tiles, so a viewer only loads what is on screen.
+--|
+--| Zoom level 0 fits the whole grid in one tile and every level after it
+--| doubles the resolution, up to the requested one. Tile (x, y) of a level
+--| covers pixels [x*size, (x+1)*size) across and [y*size, (y+1)*size) down
+--| from the top of the grid. Only tiles that something is drawn on are
+--| written, as <prefix>_<level>_<x>_<y>.png, and <prefix>.idx lists them.
+--|-------------------------------------------------------------------------
+*/
+class TilePyramid
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     dpi - Resolution of the finest level, taking model units as millimetres
+    --|     tile_size - Width and height of every tile in pixels
+    --| Return:
+    --|     A TilePyramid Object
+    --|-------------------------------------------------------------------------
+    */
+    TilePyramid(float dpi, size_t tile_size = 256);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Renders and writes every non-empty tile of every level, in
+    --|     parallel, then writes the index file
+    --| Args:
+    --|     layers - The sliced layers to draw
+    --|     aabbSize - Size of the mesh bounding box, sets the grid spacing
+    --|     toolpaths - Infill to draw on top, or NULL
+    --|     prefix - Start of every file name
+    --| Return:
+    --|     bool - true if every file was written
+    --|-------------------------------------------------------------------------
+    */
+    bool ExportTiles(const SlicedLayers* layers, const point &aabbSize, const LayerToolpaths* toolpaths, const char* prefix) const;
+
+private:
+    // Pixels per model unit at the finest level
+    float pixels_per_unit;
+    
+    // Width and height of every tile in pixels
+    size_t tile_size;
+};
+
+#endif //_TILE_PYRAMID_H_
@@ -0,0 +1,246 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "Trace.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+std::atomic<bool> trace_enabled(false);
+
+// One finished scope
+struct TraceEvent
+{
+    const char* name;
+    const char* arg_name;
+    double arg;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// The scopes of one thread, written by that thread only
+struct TraceRing
+{
+    std::vector<TraceEvent> events;
+    uint64_t recorded;
+    unsigned int tid;
+};
+
+static std::mutex trace_lock;
+static std::vector<TraceRing*> trace_rings;
+static std::string trace_file;
+static uint64_t trace_start = 0;
+static thread_local TraceRing* thread_ring = NULL;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the calling thread's ring, making it the first time
+--| Args:
+--|     none
+--| Return:
+--|     TraceRing* - The ring, kept until the program exits
+--|-------------------------------------------------------------------------
+*/
+static TraceRing* GetThreadRing()
+{
+    if (!thread_ring)
+    {
+        TraceRing* ring = new TraceRing;
+        ring->events.resize(TRACE_RING_EVENTS);
+        ring->recorded = 0;
+        std::lock_guard<std::mutex> hold(trace_lock);
+        ring->tid = (unsigned int)trace_rings.size();
+        trace_rings.push_back(ring);
+        thread_ring = ring;
+    }
+    return thread_ring;
+}
+
+#ifdef SLICYL_TRACE
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Writes the trace when the program exits
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+static void WriteTraceAtExit()
+{
+    WriteTrace();
+}
+#endif
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Starts recording scopes on every thread and arranges for them to be
+--|     written to a file when the program exits
+--| Args:
+--|     file_name - Name of the Chrome trace JSON file
+--| Return:
+--|     bool - false if tracing was not built in
+--|-------------------------------------------------------------------------
+*/
+bool StartTrace(const char* file_name)
+{
+#ifdef SLICYL_TRACE
+    if (trace_file.empty())
+    {
+        atexit(WriteTraceAtExit);
+    }
+    trace_file = file_name;
+    trace_start = TraceClock();
+    // The starting thread comes first and is called main
+    GetThreadRing();
+    trace_enabled = true;
+    return true;
+#else
+    LogPrintf("ERROR tracing is not built in, rebuild with make clean && make TRACE=1\n");
+    return false;
+#endif
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Stops recording and writes what was recorded. Called at exit, no
+--|     other thread may be recording by then.
+--| Args:
+--|     none
+--| Return:
+--|     bool - false if nothing was started or the file could not be written
+--|-------------------------------------------------------------------------
+*/
+bool WriteTrace()
+{
+    if (!trace_enabled.exchange(false))
+    {
+        return false;
+    }
+    
+    FILE* f = fopen(trace_file.c_str(), "w");
+    if (!f)
+    {
+        LogPrintf("ERROR could not write the trace to %s\n", trace_file.c_str());
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> hold(trace_lock);
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"slicyl\"}}");
+    size_t written = 0;
+    uint64_t dropped = 0;
+    for (size_t r = 0; r < trace_rings.size(); r++)
+    {
+        const TraceRing* ring = trace_rings[r];
+        if (ring->tid == 0)
+        {
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}");
+        }
+        else
+        {
+            fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}", ring->tid, ring->tid);
+        }
+        
+        // Oldest first, from where the ring was last written over
+        const uint64_t n = std::min(ring->recorded, (uint64_t)TRACE_RING_EVENTS);
+        dropped += ring->recorded - n;
+        for (uint64_t k = ring->recorded - n; k < ring->recorded; k++)
+        {
+            const TraceEvent &e = ring->events[k % TRACE_RING_EVENTS];
+            const uint64_t begin = e.begin > trace_start ? e.begin - trace_start : 0;
+            fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f", e.name, ring->tid, begin / 1000.0, (e.end - e.begin) / 1000.0);
+            if (e.arg_name)
+            {
+                fprintf(f, ",\"args\":{\"%s\":%.9g}", e.arg_name, e.arg);
+            }
+            fprintf(f, "}");
+            written++;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = (fclose(f) == 0);
+    
+    LogPrintf("Wrote %lu trace events of %lu threads to %s", (unsigned long)written, (unsigned long)trace_rings.size(), trace_file.c_str());
+    if (dropped > 0)
+    {
+        LogPrintf(", the oldest %lu were written over", (unsigned long)dropped);
+    }
+    LogPrintf("\n");
+    return ok;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the time scopes are measured in
+--| Args:
+--|     none
+--| Return:
+--|     uint64_t - Nanoseconds from a fixed point
+--|-------------------------------------------------------------------------
+*/
+uint64_t TraceClock()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Puts one finished scope into the calling thread's ring
+--| Args:
+--|     name - What was done, a string literal
+--|     arg_name - Name of a number shown with it, a string literal or NULL
+--|     arg - The number
+--|     begin - TraceClock when it began
+--|     end - TraceClock when it ended
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TraceRecord(const char* name, const char* arg_name, double arg, uint64_t begin, uint64_t end)
+{
+    // Began before the trace was written out
+    if (!trace_enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+    TraceRing* ring = GetThreadRing();
+    TraceEvent &e = ring->events[ring->recorded % TRACE_RING_EVENTS];
+    e.name = name;
+    e.arg_name = arg_name;
+    e.arg = arg;
+    e.begin = begin;
+    e.end = end;
+    ring->recorded++;
+}
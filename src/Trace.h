@@ -0,0 +1,153 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+--|-------------------------------------------------------------------------
+--| Timeline of what every thread was doing, for Perfetto or chrome://tracing.
+--|
+--| Only built in with make TRACE=1, which defines SLICYL_TRACE. Otherwise
+--| TRACE_SCOPE and TRACE_SCOPE_ARG are empty and nothing is timed. Built in
+--| but not started, each scope costs one relaxed load.
+--|
+--| Once StartTrace is called each scope records when it began and ended
+--| into a ring buffer of its own thread, so recording takes no lock. The
+--| rings are written out as Chrome trace JSON when the program exits, and
+--| only then, once the worker threads are gone. A thread that records more
+--| than TRACE_RING_EVENTS scopes keeps the newest ones.
+--|-------------------------------------------------------------------------
+*/
+
+// Scopes kept per thread, the oldest are written over past this
+static const size_t TRACE_RING_EVENTS = 1 << 16;
+
+// Set while scopes are being recorded
+extern std::atomic<bool> trace_enabled;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Starts recording scopes on every thread and arranges for them to be
+--|     written to a file when the program exits
+--| Args:
+--|     file_name - Name of the Chrome trace JSON file
+--| Return:
+--|     bool - false if tracing was not built in
+--|-------------------------------------------------------------------------
+*/
+bool StartTrace(const char* file_name);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Stops recording and writes what was recorded. Called at exit, no
+--|     other thread may be recording by then.
+--| Args:
+--|     none
+--| Return:
+--|     bool - false if nothing was started or the file could not be written
+--|-------------------------------------------------------------------------
+*/
+bool WriteTrace();
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the time scopes are measured in
+--| Args:
+--|     none
+--| Return:
+--|     uint64_t - Nanoseconds from a fixed point
+--|-------------------------------------------------------------------------
+*/
+uint64_t TraceClock();
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Puts one finished scope into the calling thread's ring
+--| Args:
+--|     name - What was done, a string literal
+--|     arg_name - Name of a number shown with it, a string literal or NULL
+--|     arg - The number
+--|     begin - TraceClock when it began
+--|     end - TraceClock when it ended
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TraceRecord(const char* name, const char* arg_name, double arg, uint64_t begin, uint64_t end);
+
+#ifdef SLICYL_TRACE
+
+/*
+--|-------------------------------------------------------------------------
+--| Records the block it lives in, from construction to the end of scope
+--|-------------------------------------------------------------------------
+*/
+class TraceScope
+{
+public:
+    TraceScope(const char* name, const char* arg_name, double arg) : name(NULL), arg_name(arg_name), arg(arg), begin(0)
+    {
+        if (trace_enabled.load(std::memory_order_relaxed))
+        {
+            this->name = name;
+            begin = TraceClock();
+        }
+    }
+    
+    ~TraceScope()
+    {
+        if (name)
+        {
+            TraceRecord(name, arg_name, arg, begin, TraceClock());
+        }
+    }
+
+private:
+    const char* name;
+    const char* arg_name;
+    double arg;
+    uint64_t begin;
+};
+
+#define TRACE_JOIN2(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_JOIN(trace_scope_, __LINE__)(name, NULL, 0.0)
+#define TRACE_SCOPE_ARG(name, arg_name, arg) TraceScope TRACE_JOIN(trace_scope_, __LINE__)(name, arg_name, (double)(arg))
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_SCOPE_ARG(name, arg_name, arg)
+
+#endif //SLICYL_TRACE
+
+#endif //_TRACE_H_
@@ -49,6 +49,7 @@ Triangle::Triangle(point n, point p0, point p1, point p2) : normal(n)
     line[1] = LineSeg(p1, p2);
     line[2] = LineSeg(p2, p0);
     
+    UpdateSag();
 }
 
 /*
@@ -88,6 +89,7 @@ Triangle Triangle::MoveTriangle(const point& distance)
     line[1] = LineSeg(v[1], v[2]);
     line[2] = LineSeg(v[2], v[0]);
     
+    UpdateSag();
     return *this;
 }
 
@@ -105,6 +107,7 @@ Triangle Triangle::MoveTriangle(const point& distance)
 void Triangle::MorphVertex_X(int vertex, float new_value)
 { 
     v[vertex].x = new_value; 
+    UpdateSag();
 }
 
 /*
@@ -121,6 +124,7 @@ void Triangle::MorphVertex_X(int vertex, float new_value)
 void Triangle::MorphVertex_Y(int vertex, float new_value)
 { 
     v[vertex].y = new_value; 
+    UpdateSag();
 }
 
 /*
@@ -137,6 +141,7 @@ void Triangle::MorphVertex_Y(int vertex, float new_value)
 void Triangle::MorphVertex_Z(int vertex, float new_value)
 { 
     v[vertex].z = new_value; 
+    UpdateSag();
 }
 
 /*
@@ -172,47 +177,51 @@ const point& Triangle::GetNormal() const
 --|-------------------------------------------------------------------------
 --| Purpose:
 --|     Find the points of intersection between this Triangle and a Slicyl
---|     Indeed, this is where the magic happens
+--|     Indeed, this is where the magic happens. Everything is worked out
+--|     in Real, squares are plain products so float stays float.
 --| Args:
 --|     radius- Radius of the Slicyl
 --| Return:
 --|     A vector of all intersection points
 --|-------------------------------------------------------------------------
 */
-std::vector<point> Triangle::FindIntersects(float radius) const
+template <typename Real>
+std::vector<PointT<Real> > Triangle::FindIntersects(Real radius) const
 {
-    std::vector<point> points_of_intersection;
+    std::vector<PointT<Real> > points_of_intersection;
     
     // Initialize t values
     // t values are between 0 and 1 not inclusive, obtained by solving the quadratic equation of a line
     // They map the relative position of a point along a line segment 
-    float t1[3] = {0,0,0};
-    float t2[3] = {0,0,0};
+    Real t1[3] = {0,0,0};
+    Real t2[3] = {0,0,0};
     
-    float x0, y0, z0, x1, y1, z1;
+    Real x0, y0, z0, x1, y1, z1;
     
     // For each vertex of the triangle
     for (int vertex=0; vertex<3; vertex++)
     {
         // Distances between each point in a line segment
-        float u = line[vertex].pt1.x - line[vertex].pt0.x;
-        float v = line[vertex].pt1.y - line[vertex].pt0.y;
-        float w = line[vertex].pt1.z - line[vertex].pt0.z;
+        const PointT<Real> p0(line[vertex].pt0);
+        const PointT<Real> p1(line[vertex].pt1);
+        Real u = p1.x - p0.x;
+        Real v = p1.y - p0.y;
+        Real w = p1.z - p0.z;
         
         // Get the delta of the quadratic equation from equating the Equation of a Circle to the Equation of a line consisting of two points
         // This allows us to determine how many possible intersections there are
         
         //v^2 + w^2
-        float A = pow(v, 2) + pow(w, 2); 
+        Real A = v*v + w*w;
         
         //2*(y*v) + 2*(z*w)
-        float B = (2.0f*(line[vertex].pt0.y * v)) + (2.0f*(line[vertex].pt0.z * w)); 
+        Real B = (Real(2)*(p0.y * v)) + (Real(2)*(p0.z * w));
         
         //(y^2 + z^2) - r^2
-        float C = (pow(line[vertex].pt0.y, 2)) + (pow(line[vertex].pt0.z, 2)) - (pow(radius,2)); 
+        Real C = (p0.y * p0.y) + (p0.z * p0.z) - (radius * radius);
         
         //B^2 - 4*A*C
-        float delta = ((pow(B, 2))-(4.0f*A*C)); 
+        Real delta = (B * B)-(Real(4)*A*C);
 
         // No Intersections...how boring
         if (delta < 0) 
@@ -233,7 +242,7 @@ std::vector<point> Triangle::FindIntersects(float radius) const
             else
             {
                 //Define t values for finding the intersection point for one root
-                t1[vertex] = (-1.0f * B)/(2.0f * A); 
+                t1[vertex] = (Real(-1) * B)/(Real(2) * A); 
             }
             
             // We dont really care about the other t value right now...
@@ -245,12 +254,12 @@ std::vector<point> Triangle::FindIntersects(float radius) const
             {   
                 //Get the coordinate of the intersection point
                 // Obtained by adding the base position (point 0) to the length of the segment times how far up the segment to go
-                x0 = line[vertex].pt0.x + (u*t1[vertex]); 
-                y0 = line[vertex].pt0.y + (v*t1[vertex]);
-                z0 = line[vertex].pt0.z + (w*t1[vertex]);
+                x0 = p0.x + (u*t1[vertex]); 
+                y0 = p0.y + (v*t1[vertex]);
+                z0 = p0.z + (w*t1[vertex]);
                 
                 //Push that point onto the output vector
-                points_of_intersection.push_back(point(x0, y0, z0)); 
+                points_of_intersection.push_back(PointT<Real>(x0, y0, z0)); 
             }
         }
         
@@ -258,8 +267,8 @@ std::vector<point> Triangle::FindIntersects(float radius) const
         else if (delta > 0) 
         {
             // Define both t values as there are two roots now
-            t1[vertex] = (-1.0f * B + (sqrt(delta)))/(2.0f * A); 
-            t2[vertex] = (-1.0f * B - (sqrt(delta)))/(2.0f * A);
+            t1[vertex] = (Real(-1) * B + std::sqrt(delta))/(Real(2) * A); 
+            t2[vertex] = (Real(-1) * B - std::sqrt(delta))/(Real(2) * A);
 
             // Check to make sure the first t values are within range
             // If they are not within range, it means that the intersection is not within the line segment...so we don't want it
@@ -267,12 +276,12 @@ std::vector<point> Triangle::FindIntersects(float radius) const
             {
                 // Get the coordinate of the intersection point
                 // Obtained by adding the base position (point 0) to the length of the segment times how far up the segment to go
-                x0 = line[vertex].pt0.x + (u*t1[vertex]);
-                y0 = line[vertex].pt0.y + (v*t1[vertex]);
-                z0 = line[vertex].pt0.z + (w*t1[vertex]);   
+                x0 = p0.x + (u*t1[vertex]);
+                y0 = p0.y + (v*t1[vertex]);
+                z0 = p0.z + (w*t1[vertex]);   
 
                 //Push that point onto the output vector
-                points_of_intersection.push_back(point(x0, y0, z0)); 
+                points_of_intersection.push_back(PointT<Real>(x0, y0, z0)); 
             }
             
             // Check to make sure the second t values are within range
@@ -281,12 +290,12 @@ std::vector<point> Triangle::FindIntersects(float radius) const
             {               
                 //Get the coordinate of the intersection point
                 // Obtained by adding the base position (point 0) to the length of the segment times how far up the segment to go
-                x1 = line[vertex].pt0.x + (u*t2[vertex]); 
-                y1 = line[vertex].pt0.y + (v*t2[vertex]);
-                z1 = line[vertex].pt0.z + (w*t2[vertex]);               
+                x1 = p0.x + (u*t2[vertex]); 
+                y1 = p0.y + (v*t2[vertex]);
+                z1 = p0.z + (w*t2[vertex]);               
 
                 //Push that point onto the output vector
-                points_of_intersection.push_back( point(x1, y1, z1)); 
+                points_of_intersection.push_back(PointT<Real>(x1, y1, z1)); 
             }
         }
         // If we hit this there is a serious problem in the fabric of reality
@@ -297,3 +306,322 @@ std::vector<point> Triangle::FindIntersects(float radius) const
     }
     return points_of_intersection;
 }
+
+/*
+--|-------------------------------------------------------------------------
+--| Every way a Slicyl can cross a Triangle, indexed by a 6 bit case code:
+--|     bits 0-2 - vertex 0, 1, 2 is inside the Slicyl
+--|     bits 3-5 - edge 0, 1, 2 has both ends outside but dips inside
+--| Each edge has two crossing slots (2*edge and 2*edge+1) and an entry lists
+--| which slots pair up into segments.
+--|-------------------------------------------------------------------------
+*/
+struct SegmentCase
+{
+    int count;
+    int slots[3][2];
+};
+
+static SegmentCase segment_cases[64];
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Fills segment_cases. The Slicyl interior cut by the Triangle's plane
+--|     is convex, so walking the Triangle's boundary the crossings alternate
+--|     between entering and leaving, and each piece of Slicyl inside the
+--|     Triangle joins the end of one inside stretch of boundary to the start
+--|     of the next.
+--| Args:
+--|     none
+--| Return:
+--|     bool - Always true, so it can initialize a static
+--|-------------------------------------------------------------------------
+*/
+static bool BuildSegmentCases()
+{
+    for (int code = 0; code < 64; code++)
+    {
+        int crossings[6];
+        int n = 0;
+        
+        for (int edge = 0; edge < 3; edge++)
+        {
+            int in0 = (code >> edge) & 1;
+            int in1 = (code >> ((edge + 1) % 3)) & 1;
+            int dips = (code >> (3 + edge)) & 1;
+            
+            // Crossed once going in or out
+            if (in0 != in1)
+            {
+                crossings[n++] = 2*edge;
+            }
+            // Crossed twice, in then out
+            else if (dips && !in0)
+            {
+                crossings[n++] = 2*edge;
+                crossings[n++] = 2*edge + 1;
+            }
+        }
+        
+        // Vertex 0 inside means the stretch between the last and first crossing is inside
+        int first = (code & 1) ? 0 : 1;
+        segment_cases[code].count = n / 2;
+        for (int i = 0; i < n / 2; i++)
+        {
+            segment_cases[code].slots[i][0] = crossings[(first + 2*i) % n];
+            segment_cases[code].slots[i][1] = crossings[(first + 2*i + 1) % n];
+        }
+    }
+    return true;
+}
+
+static const bool segment_cases_built = BuildSegmentCases();
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Find the segments where a Slicyl cuts through this Triangle.
+--|     Handles every case: edges crossed once or twice, tangent edges
+--|     and vertices sitting exactly on the Slicyl (counted as outside).
+--|     Each segment runs from pt0 to pt1 in the direction of growing
+--|     theta = atan2(y, z), so rollout knows which way around it goes.
+--|     Real is the precision it is worked out in, float or double.
+--| Args:
+--|     radius- Radius of the Slicyl
+--|     segments- Room for the up to three segments found
+--| Return:
+--|     int - How many segments were written to segments
+--|-------------------------------------------------------------------------
+*/
+template <typename Real>
+int Triangle::FindSegments(Real radius, LineSegT<Real> segments[3]) const
+{
+    return CutSegments<CylinderSurface<Real>, FastPredicates>(CylinderSurface<Real>(radius), segments);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Find the segments where one layer of any surface cuts through this
+--|     Triangle, as FindSegments does for the Slicyl. The inside of the
+--|     surface cut by the Triangle's plane has to be convex, which holds
+--|     for cylinders, spheres and one nappe of a cone. Predicates is
+--|     FastPredicates or RobustPredicates.
+--| Args:
+--|     surface- The surface policy for the layer
+--|     segments- Room for the up to three segments found
+--| Return:
+--|     int - How many segments were written to segments
+--|-------------------------------------------------------------------------
+*/
+template <typename Surface, typename Predicates>
+int Triangle::CutSegments(const Surface &surface, LineSegT<typename Surface::Real> segments[3]) const
+{
+    typedef typename Surface::Real Real;
+    const Real zero = Real(0);
+    
+    // The corners in the precision being worked in
+    const PointT<Real> p[3] = {PointT<Real>(v[0]), PointT<Real>(v[1]), PointT<Real>(v[2])};
+    
+    // Which side of the surface each vertex is on, zero counts as outside
+    Real f[3];
+    int inside = 0;
+    for (int vertex = 0; vertex < 3; vertex++)
+    {
+        f[vertex] = surface.Level(p[vertex]);
+        inside |= (f[vertex] < zero) << vertex;
+    }
+    
+    // With no vertex near the surface a Triangle all on one side is done
+    const bool settled = Predicates::Settled(surface, p, f, sag, inside);
+    if (settled && (inside == 0 || inside == 7))
+    {
+        return 0;
+    }
+    
+    // Roots of Level(p0 + t*(p1 - p0)) = 0 along each edge. Where the level
+    // curves down (a cone's edge steeper than its side) the roots come out
+    // high then low, which is also the order the crossings need. The
+    // predicates may have an edge worked along backwards, from its end, and
+    // then its roots go in the other way round.
+    Real t[6];
+    PointT<Real> from[3];
+    PointT<Real> to[3];
+    int dips = 0;
+    for (int edge = 0; edge < 3; edge++)
+    {
+        int next = (edge + 1) % 3;
+        int back = Predicates::Reversed(p[edge], p[next]);
+        from[edge] = back ? p[next] : p[edge];
+        to[edge] = back ? p[edge] : p[next];
+        
+        Real A, B;
+        surface.EdgeTerms(from[edge], to[edge], A, B);
+        Real C = back ? f[next] : f[edge];
+        Real delta = B*B - Real(4)*A*C;
+        
+        // Both ends outside but the closest approach is inside
+        int dip = (A > zero) & (delta > zero) & (-B > zero) & (-B < Real(2)*A);
+        dips |= dip << edge;
+        
+        Real root = std::sqrt(delta > zero ? delta : zero);
+        Real first, second;
+        if (A != zero)
+        {
+            Real inv = Real(0.5) / A;
+            first = (-B - root) * inv;
+            second = (-B + root) * inv;
+        }
+        else
+        {
+            // Level is straight along the edge
+            first = second = B != zero ? -C / B : zero;
+        }
+        t[2*edge] = back ? second : first;
+        t[2*edge + 1] = back ? first : second;
+    }
+    if (settled)
+    {
+        dips = 0;
+    }
+    else
+    {
+        Predicates::Refine(surface, p, inside, dips);
+    }
+    dips &= ~(inside | (inside >> 1) | (inside << 2)) & 7;
+    
+    const SegmentCase &c = segment_cases[inside | (dips << 3)];
+    if (c.count == 0)
+    {
+        return 0;
+    }
+    
+    // An edge crossed once going out uses its high root in the low slot,
+    // high as the Triangle winds
+    for (int edge = 0; edge < 3; edge++)
+    {
+        t[2*edge] = ((inside >> edge) & 1) ? t[2*edge + 1] : t[2*edge];
+    }
+    
+    // Pieces of surface run from slot 0 to slot 1 with the inside of the cut
+    // on their left. Flip those that turn theta backwards so every segment
+    // runs the way theta grows.
+    for (int i = 0; i < c.count; i++)
+    {
+        PointT<Real> ends[2];
+        for (int k = 0; k < 2; k++)
+        {
+            int slot = c.slots[i][k];
+            const PointT<Real> &p0 = from[slot >> 1];
+            const PointT<Real> &p1 = to[slot >> 1];
+            Real s = t[slot];
+            s = s < zero ? zero : (s > Real(1) ? Real(1) : s);
+            ends[k] = PointT<Real>(p0.x + (p1.x - p0.x)*s,
+                                   p0.y + (p1.y - p0.y)*s,
+                                   p0.z + (p1.z - p0.z)*s);
+        }
+        int flip = surface.Backwards(p, ends[0], ends[1]);
+        segments[i] = LineSegT<Real>(ends[flip], ends[1 - flip]);
+    }
+    return c.count;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Find the smallest and largest Slicyl radii that touch this Triangle,
+--|     i.e. its closest and furthest distance from the x axis
+--| Args:
+--|     r_min- Gets the smallest radius
+--|     r_max- Gets the largest radius
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Triangle::GetRadialExtent(float &r_min, float &r_max) const
+{
+    // Distance from the axis is convex, so the furthest point is a vertex
+    float r[3];
+    for (int i = 0; i < 3; i++)
+    {
+        r[i] = sqrtf(v[i].y*v[i].y + v[i].z*v[i].z);
+    }
+    r_max = fmaxf(r[0], fmaxf(r[1], r[2]));
+    
+    // The closest is the distance to the origin of the yz shadow of the Triangle
+    float cross[3];
+    for (int i = 0; i < 3; i++)
+    {
+        const point &a = v[i];
+        const point &b = v[(i+1)%3];
+        cross[i] = a.y*b.z - a.z*b.y;
+    }
+    bool flat = cross[0] == 0.0f && cross[1] == 0.0f && cross[2] == 0.0f;
+    if (!flat && ((cross[0] >= 0.0f && cross[1] >= 0.0f && cross[2] >= 0.0f) ||
+                  (cross[0] <= 0.0f && cross[1] <= 0.0f && cross[2] <= 0.0f)))
+    {
+        r_min = 0.0f;
+        return;
+    }
+    r_min = r_max;
+    for (int i = 0; i < 3; i++)
+    {
+        const point &a = v[i];
+        const point &b = v[(i+1)%3];
+        float ey = b.y - a.y;
+        float ez = b.z - a.z;
+        float len2 = ey*ey + ez*ez;
+        float t = len2 > 0.0f ? -(a.y*ey + a.z*ez)/len2 : 0.0f;
+        t = fminf(1.0f, fmaxf(0.0f, t));
+        float py = a.y + t*ey;
+        float pz = a.z + t*ez;
+        r_min = fminf(r_min, sqrtf(py*py + pz*pz));
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Works sag out again after the vertices moved. The level along an
+--|     edge is quadratic with a t^2 term no bigger than the edge's length
+--|     squared for every surface, so a quarter of that is the most it sags.
+--|     Worked out in double and rounded up well past float's rounding.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void Triangle::UpdateSag()
+{
+    double longest = 0.0;
+    for (int i = 0; i < 3; i++)
+    {
+        const point &a = v[i];
+        const point &b = v[(i+1)%3];
+        double dx = (double)b.x - a.x;
+        double dy = (double)b.y - a.y;
+        double dz = (double)b.z - a.z;
+        longest = std::max(longest, dx*dx + dy*dy + dz*dz);
+    }
+    sag = (float)(0.25 * longest * (1.0 + 1e-5));
+}
+
+// The precisions and surfaces the slicer runs with
+template std::vector<PointT<float> > Triangle::FindIntersects<float>(float radius) const;
+template std::vector<PointT<double> > Triangle::FindIntersects<double>(double radius) const;
+template int Triangle::FindSegments<float>(float radius, LineSegT<float> segments[3]) const;
+template int Triangle::FindSegments<double>(double radius, LineSegT<double> segments[3]) const;
+template int Triangle::CutSegments<CylinderSurface<float>, FastPredicates>(const CylinderSurface<float> &surface, LineSegT<float> segments[3]) const;
+template int Triangle::CutSegments<CylinderSurface<double>, FastPredicates>(const CylinderSurface<double> &surface, LineSegT<double> segments[3]) const;
+template int Triangle::CutSegments<CylinderSurface<float>, RobustPredicates>(const CylinderSurface<float> &surface, LineSegT<float> segments[3]) const;
+template int Triangle::CutSegments<CylinderSurface<double>, RobustPredicates>(const CylinderSurface<double> &surface, LineSegT<double> segments[3]) const;
+template int Triangle::CutSegments<ConeSurface<float>, FastPredicates>(const ConeSurface<float> &surface, LineSegT<float> segments[3]) const;
+template int Triangle::CutSegments<ConeSurface<double>, FastPredicates>(const ConeSurface<double> &surface, LineSegT<double> segments[3]) const;
+template int Triangle::CutSegments<ConeSurface<float>, RobustPredicates>(const ConeSurface<float> &surface, LineSegT<float> segments[3]) const;
+template int Triangle::CutSegments<ConeSurface<double>, RobustPredicates>(const ConeSurface<double> &surface, LineSegT<double> segments[3]) const;
+template int Triangle::CutSegments<SphereSurface<float>, FastPredicates>(const SphereSurface<float> &surface, LineSegT<float> segments[3]) const;
+template int Triangle::CutSegments<SphereSurface<double>, FastPredicates>(const SphereSurface<double> &surface, LineSegT<double> segments[3]) const;
+template int Triangle::CutSegments<SphereSurface<float>, RobustPredicates>(const SphereSurface<float> &surface, LineSegT<float> segments[3]) const;
+template int Triangle::CutSegments<SphereSurface<double>, RobustPredicates>(const SphereSurface<double> &surface, LineSegT<double> segments[3]) const;
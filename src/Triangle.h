@@ -29,6 +29,8 @@ THE SOFTWARE.
 #include <stdio.h>
 
 #include "dimensional_space.h"
+#include "Surface.h"
+#include "Predicates.h"
 
 
 /*
@@ -144,14 +146,67 @@ public:
     /*
     --|-------------------------------------------------------------------------
     --| Purpose:
-    --|     Find the points of intersection between this Triangle and a Slicyl
+    --|     Find the points of intersection between this Triangle and a Slicyl,
+    --|     worked out in float or double
     --| Args:
     --|     radius- Radius of the Slicyl
     --| Return:
     --|     A vector of all intersection points
     --|-------------------------------------------------------------------------
     */
-    std::vector<point> FindIntersects(float radius) const;
+    template <typename Real>
+    std::vector<PointT<Real> > FindIntersects(Real radius) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Find the segments where a Slicyl cuts through this Triangle.
+    --|     Handles every case: edges crossed once or twice, tangent edges
+    --|     and vertices sitting exactly on the Slicyl (counted as outside).
+    --|     Each segment runs from pt0 to pt1 in the direction of growing
+    --|     theta = atan2(y, z), so rollout knows which way around it goes.
+    --|     Real is the precision it is worked out in, float or double.
+    --| Args:
+    --|     radius- Radius of the Slicyl
+    --|     segments- Room for the up to three segments found
+    --| Return:
+    --|     int - How many segments were written to segments
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Real>
+    int FindSegments(Real radius, LineSegT<Real> segments[3]) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Find the segments where one layer of any surface cuts through this
+    --|     Triangle, as FindSegments does for the Slicyl. The inside of the
+    --|     surface cut by the Triangle's plane has to be convex, which holds
+    --|     for cylinders, spheres and one nappe of a cone. Predicates is
+    --|     FastPredicates or RobustPredicates (see Predicates.h).
+    --| Args:
+    --|     surface- The surface policy for the layer (see Surface.h)
+    --|     segments- Room for the up to three segments found
+    --| Return:
+    --|     int - How many segments were written to segments
+    --|-------------------------------------------------------------------------
+    */
+    template <typename Surface, typename Predicates>
+    int CutSegments(const Surface &surface, LineSegT<typename Surface::Real> segments[3]) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Find the smallest and largest Slicyl radii that touch this Triangle,
+    --|     i.e. its closest and furthest distance from the x axis
+    --| Args:
+    --|     r_min- Gets the smallest radius
+    --|     r_max- Gets the largest radius
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void GetRadialExtent(float &r_min, float &r_max) const;
 
     
 private:
@@ -163,5 +218,22 @@ private:
     
     // The line segments of the triangle
     LineSeg line[3];
+    
+    // A quarter of the longest edge squared, a little rounded up. Along an
+    // edge no surface's level sags further than this below the straight line
+    // between its values at the ends.
+    float sag;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Works sag out again after the vertices moved
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void UpdateSag();
 };
 #endif // _TRIANGLE_H_
\ No newline at end of file
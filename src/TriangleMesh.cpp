@@ -24,6 +24,15 @@ THE SOFTWARE.
 
 #include "TriangleMesh.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <stdint.h>
+#include "Log.h"
+#include "Trace.h"
+
 
 /*
 --|-------------------------------------------------------------------------
@@ -79,42 +88,49 @@ size_t TriangleMesh::GetMeshSize() const
 --| Purpose:
 --|     Fills a Triangle Mesh with the data from a binary STL file
 --| Args:
---|     none
+--|     stl_file - Name of the STL file
 --| Returns:
---|     A const std::vector of Triangles
+--|     bool - false if the file could not be read
 --|-------------------------------------------------------------------------
 */  
-void TriangleMesh::LoadSTLToMeshBinary(const char* stl_file)
+bool TriangleMesh::LoadSTLToMeshBinary(const char* stl_file)
 {
     FILE *f = fopen(stl_file, "rb");
     if (!f)
     {
-        //return ;
+        LogPrintf("ERROR IN GENERATING MESH!\nMake sure you typed the file name correctly.\n");
+        return false;
     }
     char name[80];
-    unsigned int nFaces;
-    fread(name, 80, 1, f);
-    fread((void*)&nFaces, 4, 1, f);
-    float v[12];
-    unsigned short uint16;
-
-    for (size_t i=0; i<nFaces; ++i)
+    unsigned int nFaces = 0;
+    if (fread(name, 80, 1, f) != 1 || fread((void*)&nFaces, 4, 1, f) != 1)
+    {
+        LogPrintf("ERROR %s is too short for a binary STL file!\n", stl_file);
+        fclose(f);
+        return false;
+    }
+    
+    LogPrintf("Creating Triangles..\n");
+    
+    // A block of facets at a time
+    std::vector<unsigned char> records(50 * 4096);
+    size_t done = 0;
+    while (done < nFaces)
     {
-        for (size_t j=0; j<12; ++j)
+        size_t want = std::min((size_t)nFaces - done, (size_t)4096);
+        TRACE_SCOPE_ARG("load chunk", "facets", want);
+        size_t got = fread(&records[0], 50, want, f);
+        LoadSTLRecords(&records[0], got);
+        done += got;
+        if (got < want)
         {
-            fread((void*)&v[j], sizeof(float), 1, f);
+            LogPrintf("ERROR %s ends after %lu of %u facets!\n", stl_file, (unsigned long)done, nFaces);
+            fclose(f);
+            return false;
         }
-
-        fread((void*)&uint16, sizeof(unsigned short), 1, f);
-        
-        const Triangle tri(point(v[0], v[1], v[2]), point(v[3], v[4], v[5]), point(v[6], v[7], v[8]), point(v[9], v[10], v[11]));
-        
-        const Triangle& tri_ref = tri;
-        
-        this->AddTriangle(tri_ref);
     }
     fclose(f);
-    
+    return true;
 }
 
 /*
@@ -122,12 +138,12 @@ void TriangleMesh::LoadSTLToMeshBinary(const char* stl_file)
 --| Purpose:
 --|     Fills a Triangle Mesh with the data from an ASCII STL file
 --| Args:
---|     none
+--|     stl_file - Name of the STL file
 --| Returns:
---|     A const std::vector of Triangles
+--|     bool - false if the file could not be opened
 --|-------------------------------------------------------------------------
 */  
-void TriangleMesh::LoadSTLToMeshASCII(const char* stl_file)
+bool TriangleMesh::LoadSTLToMeshASCII(const char* stl_file)
 {
 // If the STL file is in ASCII format
 
@@ -135,67 +151,123 @@ void TriangleMesh::LoadSTLToMeshASCII(const char* stl_file)
     
     if (!in.good())
     {
-        printf("ERROR IN GENERATING MESH!\nMake sure you typed the file name correctly.\n");
-        //return 1;
+        LogPrintf("ERROR IN GENERATING MESH!\nMake sure you typed the file name correctly.\n");
+        return false;
     }
-
-    //Temp stuff
-    std::string s0,s1;  
-    float p0, p1, p2;
     
-    //Output Data
-    point normal, vertex_1, vertex_2, vertex_3;
-    
-    printf("Creating Triangles..\n");
+    LogPrintf("Creating Triangles..\n");
+    TRACE_SCOPE("load ascii");
+    LoadSTLFromStream(in);
+    in.close();
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Fills a Triangle Mesh with the data from an STL file, telling
+--|     binary from ASCII by whether the size matches the facet count
+--| Args:
+--|     stl_file - Name of the STL file
+--| Returns:
+--|     bool - false if the file could not be read
+--|-------------------------------------------------------------------------
+*/  
+bool TriangleMesh::LoadSTL(const char* stl_file)
+{
+    FILE *f = fopen(stl_file, "rb");
+    if (!f)
+    {
+        LogPrintf("ERROR IN GENERATING MESH!\nMake sure you typed the file name correctly.\n");
+        return false;
+    }
+    unsigned char header[84];
+    size_t got = fread(header, 1, sizeof(header), f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
     
-    // Read the STL file one triangle at a time
-    while (!in.eof())
+    uint32_t nFaces = 0;
+    if (got == sizeof(header))
     {
-        in >> s0;
-        // ASCII STL files begin with the word facet
-        if (s0=="facet")
-        {
-            // Read: "normal" x, y, z
-            in >> s0 >> p0 >> p1 >> p2;     
-            normal = point(p0, p1, p2);
-            
-            // "outer" "loop"
-            in >> s0 >> s1;         
-            
-            // "vertex" x y z
-            in >> s0 >> p0 >> p1 >> p2;
-            vertex_1 = point(p0, p1, p2);
-            
-            // "vertex" x y z
-            in >> s0 >> p0 >> p1 >> p2; 
-            vertex_2 = point(p0, p1, p2);
-
-            // "vertex" x y z
-            in >> s0 >> p0 >> p1 >> p2; 
-                vertex_3 = point(p0, p1, p2);
-            
-            // "endloop"
-            in >> s0;           
-            
-            // "endfacet"
-            in >> s0;           
-            
-            // Create a new Triangle with the data
-            Triangle tri(normal, vertex_1, vertex_2, vertex_3);
-            
-            // Add the new Triangle onto the mesh
-            this->AddTriangle(tri);
+        memcpy(&nFaces, header + 80, sizeof(nFaces));
+    }
+    if (got == sizeof(header) && size == 84 + 50 * (long)nFaces)
+    {
+        return LoadSTLToMeshBinary(stl_file);
+    }
+    return LoadSTLToMeshASCII(stl_file);
+}
 
-        }
-        // Keyword marking the end of the file
-        else if (s0=="endsolid")
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Fills a Triangle Mesh with the data of an STL file already in
+--|     memory, binary or ASCII like LoadSTL
+--| Args:
+--|     data - The bytes of the STL file
+--|     size - Number of bytes
+--| Returns:
+--|     bool - false if there is no STL data
+--|-------------------------------------------------------------------------
+*/  
+bool TriangleMesh::LoadSTLFromMemory(const char* data, size_t size)
+{
+    if (!data || size == 0)
+    {
+        LogPrintf("ERROR no STL data!\n");
+        return false;
+    }
+    LogPrintf("Creating Triangles..\n");
+    TRACE_SCOPE_ARG("load memory", "bytes", size);
+    uint32_t nFaces = 0;
+    if (size >= 84)
+    {
+        memcpy(&nFaces, data + 80, sizeof(nFaces));
+        if (size == 84 + 50 * (size_t)nFaces)
         {
-            break;
+            LoadSTLRecords((const unsigned char*)data + 84, nFaces);
+            return true;
         }
-        
     }
-    in.close();
+    std::istringstream in(std::string(data, size));
+    LoadSTLFromStream(in);
+    return true;
+}
 
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds Triangles given as bare corners, working out their normals
+--|     from the winding
+--| Args:
+--|     vertices - Nine floats per Triangle, x y z of each corner in turn
+--|     count - Number of Triangles
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TriangleMesh::AddTriangles(const float* vertices, size_t count)
+{
+    mesh.reserve(mesh.size() + count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* v = vertices + 9 * i;
+        point p0(v[0], v[1], v[2]);
+        point p1(v[3], v[4], v[5]);
+        point p2(v[6], v[7], v[8]);
+        
+        // Right hand rule around the corners
+        point e1 = p1 - p0;
+        point e2 = p2 - p0;
+        point n(e1.y*e2.z - e1.z*e2.y, e1.z*e2.x - e1.x*e2.z, e1.x*e2.y - e1.y*e2.x);
+        float length = sqrtf(n.x*n.x + n.y*n.y + n.z*n.z);
+        if (length > 0.0f)
+        {
+            n = n / length;
+        }
+        AddTriangle(Triangle(n, p0, p1, p2));
+    }
 }
 
 /*
@@ -269,6 +341,42 @@ point TriangleMesh::GetBBoxSize() const
     return point(x_size, y_size, z_size);
 }
 
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the corners of the TriangleMesh's Bounding Box
+--| Args:
+--|     lower - Gets the smallest x, y and z
+--|     upper - Gets the largest x, y and z
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TriangleMesh::GetBBox(point &lower, point &upper) const
+{
+    lower = BBox_One;
+    upper = BBox_Two;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets the TriangleMesh's Bounding Box, e.g. so a simplified copy
+--|     of a mesh keeps the box of the original. It should hold every
+--|     Triangle, Triangles added later still grow it.
+--| Args:
+--|     lower - Smallest x, y and z
+--|     upper - Largest x, y and z
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TriangleMesh::SetBBox(const point &lower, const point &upper)
+{
+    BBox_One = lower;
+    BBox_Two = upper;
+}
+
 /*
 --|-------------------------------------------------------------------------
 --| Purpose:
@@ -289,13 +397,13 @@ void TriangleMesh::BBoxAdjust()
     //point vectorbutt((BBox_Two.x-BBox_One.x)/2.0f, (BBox_Two.y-BBox_One.y)/2.0f, BBox_One.z);
     //point vectorhead((BBox_Two.x-BBox_One.x)/2.0f, (BBox_Two.y-BBox_One.y)/2.0f, BBox_Two.z);
 
-    printf("butt: %0.3f %0.3f %0.3f head: %0.3f %0.3f %0.3f\n",vectorbutt.x,vectorbutt.y,vectorbutt.z,vectorhead.x,vectorhead.y,vectorhead.z);
+    LogPrintf("butt: %0.3f %0.3f %0.3f head: %0.3f %0.3f %0.3f\n",vectorbutt.x,vectorbutt.y,vectorbutt.z,vectorhead.x,vectorhead.y,vectorhead.z);
     
     point distance = vectorbutt;
     point tmp;
     vectorbutt -= distance;
     vectorhead -= distance;
-    printf("\ntranslation: %0.3f %0.3f %0.3f\n",vectorhead.x,vectorhead.y,vectorhead.z);
+    LogPrintf("\ntranslation: %0.3f %0.3f %0.3f\n",vectorhead.x,vectorhead.y,vectorhead.z);
     for (size_t i=0; i<mesh.size(); i++) //translation
     {
         Triangle &tri = mesh[i];
@@ -340,7 +448,7 @@ void TriangleMesh::BBoxAdjust()
     tmp.y = vectorhead.y*cos(phi)+vectorhead.x*sin(phi);
     vectorhead.x = tmp.x;
     vectorhead.y = tmp.y;
-    printf("\nrotation 1: %0.3f %0.3f %0.3f\n",vectorhead.x,vectorhead.y,vectorhead.z);
+    LogPrintf("\nrotation 1: %0.3f %0.3f %0.3f\n",vectorhead.x,vectorhead.y,vectorhead.z);
     //move the rest of the model
     for (size_t k=0; k<mesh.size(); k++)
     {
@@ -388,7 +496,7 @@ void TriangleMesh::BBoxAdjust()
     tmp.z = vectorhead.z*cos(theta)-vectorhead.x*sin(theta);
     vectorhead.x = tmp.x;
     vectorhead.z = tmp.z;
-    printf("\nrotation 2: %0.3f %0.3f %0.3f\n",vectorhead.x,vectorhead.y,vectorhead.z);
+    LogPrintf("\nrotation 2: %0.3f %0.3f %0.3f\n",vectorhead.x,vectorhead.y,vectorhead.z);
 
     //move the rest
     for (size_t l=0; l<mesh.size(); l++)
@@ -416,26 +524,44 @@ void TriangleMesh::BBoxAdjust()
 --| Args:
 --|     center - Point of which to center the model around
 --| Return:
---|     none
+--|     point - The distance every Triangle was moved by, as MoveMesh takes it
 --|-------------------------------------------------------------------------
 */
-void TriangleMesh::BBoxMoveCOG(point center)
+point TriangleMesh::BBoxMoveCOG(point center)
 {
     point half = ((BBox_Two - BBox_One)/2.0f)+BBox_One;
     point distance = half - center; //negative value for positive movement
     point dist = distance *-1.0f;
 
+    MoveMesh(distance);
+    LogPrintf("\nBounding Box Lower Bound: %f, %f, %f \nBounding Box Upper Bound: %f, %f, %f \n",BBox_One.x,BBox_One.y,BBox_One.z,BBox_Two.x,BBox_Two.y,BBox_Two.z);
+    LogPrintf("\nCenter of Bounding Box: %f, %f, %f \n",half.x,half.y,half.z);
+    LogPrintf("\nDistance to move center point: %f, %f, %f \n\n",dist.x,dist.y,dist.z);
+    LogPrintf("\nAligned around point %f, %f, %f!\n\n",center.x,center.y,center.z);
+    return distance;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Moves every Triangle and the Bounding Box by the same amount, so
+--|     a mesh loaded again can be put where an earlier one was centred
+--| Args:
+--|     distance - Amount to move by, subtracted like MoveTriangle does
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TriangleMesh::MoveMesh(const point &distance)
+{
     for (size_t i=0; i<mesh.size(); i++) //For all triangles in the mesh
     {
         Triangle &tri = mesh[i]; //Get a handle on one of the triangles
         tri.MoveTriangle(distance); //Move that triangle
-        BBoxRecalibrate(tri);
     }
-    printf("\nBounding Box Lower Bound: %f, %f, %f \nBounding Box Upper Bound: %f, %f, %f \n",BBox_One.x,BBox_One.y,BBox_One.z,BBox_Two.x,BBox_Two.y,BBox_Two.z);
-    printf("\nCenter of Bounding Box: %f, %f, %f \n",half.x,half.y,half.z);
-    printf("\nDistance to move center point: %f, %f, %f \n\n",dist.x,dist.y,dist.z);
-    printf("\nAligned around point %f, %f, %f!\n\n",center.x,center.y,center.z);
-
+    // The box moves with the mesh, growing it again would keep the old corners
+    BBox_One -= distance;
+    BBox_Two -= distance;
 }
 
 /*
@@ -491,3 +617,90 @@ void TriangleMesh::BBoxRecalibrate(const Triangle& tri)
             }
     }
 }
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reads ASCII STL facets until endsolid or the end of the stream
+--| Args:
+--|     in - Stream positioned at the start of the STL text
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TriangleMesh::LoadSTLFromStream(std::istream &in)
+{
+    //Temp stuff
+    std::string s0,s1;  
+    float p0, p1, p2;
+    
+    //Output Data
+    point normal, vertex_1, vertex_2, vertex_3;
+    
+    // Read the STL file one triangle at a time, stopping at the end or at text that makes no sense
+    while (in >> s0)
+    {
+        // ASCII STL files begin with the word facet
+        if (s0=="facet")
+        {
+            // Read: "normal" x, y, z
+            in >> s0 >> p0 >> p1 >> p2;     
+            normal = point(p0, p1, p2);
+            
+            // "outer" "loop"
+            in >> s0 >> s1;         
+            
+            // "vertex" x y z
+            in >> s0 >> p0 >> p1 >> p2;
+            vertex_1 = point(p0, p1, p2);
+            
+            // "vertex" x y z
+            in >> s0 >> p0 >> p1 >> p2; 
+            vertex_2 = point(p0, p1, p2);
+
+            // "vertex" x y z
+            in >> s0 >> p0 >> p1 >> p2; 
+            vertex_3 = point(p0, p1, p2);
+            
+            // "endloop"
+            in >> s0;           
+            
+            // "endfacet"
+            in >> s0;           
+            
+            // Create a new Triangle with the data
+            Triangle tri(normal, vertex_1, vertex_2, vertex_3);
+            
+            // Add the new Triangle onto the mesh
+            this->AddTriangle(tri);
+
+        }
+        // Keyword marking the end of the file
+        else if (s0=="endsolid")
+        {
+            break;
+        }
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds the facets of a binary STL record, header and count skipped
+--| Args:
+--|     records - 50 bytes per facet: normal, three corners, attribute
+--|     count - Number of facets
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void TriangleMesh::LoadSTLRecords(const unsigned char* records, size_t count)
+{
+    float v[12];
+    for (size_t i=0; i<count; ++i)
+    {
+        memcpy(v, records + 50*i, sizeof(v));
+        const Triangle tri(point(v[0], v[1], v[2]), point(v[3], v[4], v[5]), point(v[6], v[7], v[8]), point(v[9], v[10], v[11]));
+        this->AddTriangle(tri);
+    }
+}
@@ -93,24 +93,66 @@ public:
     --| Purpose:
     --|     Fills a Triangle Mesh with the data from a binary STL file
     --| Args:
-    --|     none
+    --|     stl_file - Name of the STL file
     --| Returns:
-    --|     A const std::vector of Triangles
+    --|     bool - false if the file could not be read
     --|-------------------------------------------------------------------------
     */  
-    void LoadSTLToMeshBinary(const char* stl_file);
+    bool LoadSTLToMeshBinary(const char* stl_file);
     
-        /*
+    /*
     --|-------------------------------------------------------------------------
     --| Purpose:
     --|     Fills a Triangle Mesh with the data from an ASCII STL file
     --| Args:
-    --|     none
+    --|     stl_file - Name of the STL file
     --| Returns:
-    --|     A const std::vector of Triangles
+    --|     bool - false if the file could not be opened
+    --|-------------------------------------------------------------------------
+    */  
+    bool LoadSTLToMeshASCII(const char* stl_file);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Fills a Triangle Mesh with the data from an STL file, telling
+    --|     binary from ASCII by whether the size matches the facet count
+    --| Args:
+    --|     stl_file - Name of the STL file
+    --| Returns:
+    --|     bool - false if the file could not be read
+    --|-------------------------------------------------------------------------
+    */  
+    bool LoadSTL(const char* stl_file);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Fills a Triangle Mesh with the data of an STL file already in
+    --|     memory, binary or ASCII like LoadSTL
+    --| Args:
+    --|     data - The bytes of the STL file
+    --|     size - Number of bytes
+    --| Returns:
+    --|     bool - false if there is no STL data
     --|-------------------------------------------------------------------------
     */  
-    void LoadSTLToMeshASCII(const char* stl_file);
+    bool LoadSTLFromMemory(const char* data, size_t size);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Adds Triangles given as bare corners, working out their normals
+    --|     from the winding
+    --| Args:
+    --|     vertices - Nine floats per Triangle, x y z of each corner in turn
+    --|     count - Number of Triangles
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void AddTriangles(const float* vertices, size_t count);
+    
     /*
     --|-------------------------------------------------------------------------
     --| Purpose:
@@ -147,6 +189,34 @@ public:
     --|-------------------------------------------------------------------------
     */
     point GetBBoxSize() const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the corners of the TriangleMesh's Bounding Box
+    --| Args:
+    --|     lower - Gets the smallest x, y and z
+    --|     upper - Gets the largest x, y and z
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void GetBBox(point &lower, point &upper) const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Sets the TriangleMesh's Bounding Box, e.g. so a simplified copy
+    --|     of a mesh keeps the box of the original. It should hold every
+    --|     Triangle, Triangles added later still grow it.
+    --| Args:
+    --|     lower - Smallest x, y and z
+    --|     upper - Largest x, y and z
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void SetBBox(const point &lower, const point &upper);
 
     /*
     --|-------------------------------------------------------------------------
@@ -167,10 +237,23 @@ public:
     --| Args:
     --|     center - Point of which to center the model around
     --| Return:
+    --|     point - The distance every Triangle was moved by, as MoveMesh takes it
+    --|-------------------------------------------------------------------------
+    */
+    point BBoxMoveCOG(point center);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Moves every Triangle and the Bounding Box by the same amount, so
+    --|     a mesh loaded again can be put where an earlier one was centred
+    --| Args:
+    --|     distance - Amount to move by, subtracted like MoveTriangle does
+    --| Return:
     --|     none
     --|-------------------------------------------------------------------------
     */
-    void BBoxMoveCOG(point center);
+    void MoveMesh(const point &distance);
 
 private:
     /*
@@ -186,6 +269,31 @@ private:
     */
     void BBoxRecalibrate(const Triangle& tri);
     
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Reads ASCII STL facets until endsolid or the end of the stream
+    --| Args:
+    --|     in - Stream positioned at the start of the STL text
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void LoadSTLFromStream(std::istream &in);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Adds the facets of a binary STL record, header and count skipped
+    --| Args:
+    --|     records - 50 bytes per facet: normal, three corners, attribute
+    --|     count - Number of facets
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void LoadSTLRecords(const unsigned char* records, size_t count);
+    
     // The TriangleMesh is actually just a vector of Triangles...you know
     std::vector<Triangle> mesh;
     
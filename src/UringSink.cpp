@@ -0,0 +1,475 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "UringSink.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+
+// Buffers in flight per thread, each SINK_BUFFER_SIZE bytes
+static const int URING_SLOTS = 4;
+
+/*
+--|-------------------------------------------------------------------------
+--| One thread's io_uring and the buffers registered with it. Slots are
+--| claimed by GetBuffer, submitted, and freed again when their completion
+--| is reaped, which also tells the sink that wrote them how it went.
+--|-------------------------------------------------------------------------
+*/
+struct UringRing
+{
+    // Whether the ring could be set up
+    bool ok;
+    // Whether the buffers are registered, so writes can use them fixed
+    bool registered;
+    int ring_fd;
+    unsigned char* buffers;
+    bool busy[URING_SLOTS];
+    UringSink* owner[URING_SLOTS];
+    // What each slot was submitted with, to finish a short write
+    int slot_fd[URING_SLOTS];
+    size_t slot_size[URING_SLOTS];
+    uint64_t slot_offset[URING_SLOTS];
+#ifdef HAVE_IO_URING
+    // The mapped submission and completion rings
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    io_uring_sqe* sqes;
+    size_t sqes_size;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    io_uring_cqe* cqes;
+#endif
+    
+    UringRing();
+    ~UringRing();
+    
+    // Gets a free slot, reaping until one is, -1 if the ring broke
+    int Claim();
+    
+    // Queues a write of a claimed slot and hands it to the kernel
+    bool Push(int slot, int fd, size_t size, uint64_t offset, UringSink* sink);
+    
+    // Reaps finished writes, waiting for at least one if asked
+    bool Reap(bool wait);
+};
+
+#ifdef HAVE_IO_URING
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets up the ring and its buffers, leaving ok false if the kernel
+--|     says no
+--| Args:
+--|     none
+--| Return:
+--|     A UringRing Object
+--|-------------------------------------------------------------------------
+*/
+UringRing::UringRing() : ok(false), registered(false), ring_fd(-1), buffers(NULL), sq_ring(MAP_FAILED), cq_ring(MAP_FAILED), sqes((io_uring_sqe*)MAP_FAILED)
+{
+    for (int i = 0; i < URING_SLOTS; i++)
+    {
+        busy[i] = false;
+        owner[i] = NULL;
+    }
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = (int)syscall(__NR_io_uring_setup, URING_SLOTS * 2, &params);
+    if (ring_fd < 0)
+    {
+        return;
+    }
+    
+    // Older kernels map the two rings apart, newer ones share one mapping
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single)
+    {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+    sq_ring = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED)
+    {
+        return;
+    }
+    cq_ring = single ? sq_ring : mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = (io_uring_sqe*)mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+    {
+        return;
+    }
+    unsigned char* sq = (unsigned char*)sq_ring;
+    unsigned char* cq = (unsigned char*)cq_ring;
+    sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    sq_array = (unsigned*)(sq + params.sq_off.array);
+    cq_head = (unsigned*)(cq + params.cq_off.head);
+    cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+    
+    if (posix_memalign((void**)&buffers, SINK_ALIGN, URING_SLOTS * SINK_BUFFER_SIZE) != 0)
+    {
+        buffers = NULL;
+        return;
+    }
+    
+    // Registered buffers are pinned once instead of on every write, where locked memory allows
+    iovec vecs[URING_SLOTS];
+    for (int i = 0; i < URING_SLOTS; i++)
+    {
+        vecs[i].iov_base = buffers + i * SINK_BUFFER_SIZE;
+        vecs[i].iov_len = SINK_BUFFER_SIZE;
+    }
+    registered = syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, vecs, URING_SLOTS) == 0;
+    ok = true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Tears the ring down when its thread ends
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+UringRing::~UringRing()
+{
+    if (sqes != MAP_FAILED)
+    {
+        munmap(sqes, sqes_size);
+    }
+    if (cq_ring != MAP_FAILED && cq_ring != sq_ring)
+    {
+        munmap(cq_ring, cq_ring_size);
+    }
+    if (sq_ring != MAP_FAILED)
+    {
+        munmap(sq_ring, sq_ring_size);
+    }
+    if (ring_fd >= 0)
+    {
+        close(ring_fd);
+    }
+    free(buffers);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Queues a write of a claimed slot and hands it to the kernel
+--| Args:
+--|     slot - The claimed slot, its buffer filled
+--|     fd - File to write
+--|     size - Bytes to write
+--|     offset - Where in the file they go
+--|     sink - Sink told how the write went
+--| Return:
+--|     bool - false if the kernel did not take the write
+--|-------------------------------------------------------------------------
+*/
+bool UringRing::Push(int slot, int fd, size_t size, uint64_t offset, UringSink* sink)
+{
+    owner[slot] = sink;
+    slot_fd[slot] = fd;
+    slot_size[slot] = size;
+    slot_offset[slot] = offset;
+    
+    // This thread is the only one filling the ring, the kernel only reads it
+    const unsigned tail = *sq_tail;
+    const unsigned index = tail & *sq_mask;
+    io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = registered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)(buffers + slot * SINK_BUFFER_SIZE);
+    sqe->len = (uint32_t)size;
+    sqe->off = offset;
+    sqe->buf_index = registered ? (uint16_t)slot : 0;
+    sqe->user_data = (uint64_t)slot;
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    
+    long submitted;
+    do
+    {
+        submitted = syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, NULL, 0);
+    } while (submitted < 0 && errno == EINTR);
+    return submitted == 1;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Reaps finished writes and frees their slots. A short write is
+--|     finished with pwrite, a failed one marks its sink.
+--| Args:
+--|     wait - Block until at least one write finishes
+--| Return:
+--|     bool - false if waiting failed
+--|-------------------------------------------------------------------------
+*/
+bool UringRing::Reap(bool wait)
+{
+    for (;;)
+    {
+        const unsigned head = *cq_head;
+        if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+        {
+            if (!wait)
+            {
+                return true;
+            }
+            if (syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 && errno != EINTR)
+            {
+                return false;
+            }
+            continue;
+        }
+        const io_uring_cqe &cqe = cqes[head & *cq_mask];
+        const int slot = (int)cqe.user_data;
+        bool written = cqe.res >= 0;
+        size_t done = written ? (size_t)cqe.res : 0;
+        while (written && done < slot_size[slot])
+        {
+            ssize_t n = pwrite(slot_fd[slot], buffers + slot * SINK_BUFFER_SIZE + done, slot_size[slot] - done, (off_t)(slot_offset[slot] + done));
+            written = n > 0;
+            done += written ? (size_t)n : 0;
+        }
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        
+        UringSink* sink = owner[slot];
+        if (sink)
+        {
+            sink->in_flight--;
+            sink->write_failed = sink->write_failed || !written;
+        }
+        owner[slot] = NULL;
+        busy[slot] = false;
+        wait = false;
+    }
+}
+
+#else
+
+UringRing::UringRing() : ok(false), registered(false), ring_fd(-1), buffers(NULL)
+{
+}
+
+UringRing::~UringRing()
+{
+}
+
+bool UringRing::Push(int, int, size_t, uint64_t, UringSink*)
+{
+    return false;
+}
+
+bool UringRing::Reap(bool)
+{
+    return false;
+}
+
+#endif
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets a free slot, reaping until one is
+--| Args:
+--|     none
+--| Return:
+--|     int - The slot, now claimed, -1 if waiting for one failed
+--|-------------------------------------------------------------------------
+*/
+int UringRing::Claim()
+{
+    for (;;)
+    {
+        for (int i = 0; i < URING_SLOTS; i++)
+        {
+            if (!busy[i])
+            {
+                busy[i] = true;
+                return i;
+            }
+        }
+        if (!Reap(true))
+        {
+            return -1;
+        }
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the ring of the calling thread, set up on first use and torn
+--|     down when the thread ends
+--| Args:
+--|     none
+--| Return:
+--|     UringRing& - The ring
+--|-------------------------------------------------------------------------
+*/
+static UringRing& ThreadRing()
+{
+    static thread_local UringRing ring;
+    return ring;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor.
+--| Args:
+--|     fd - The open file
+--|     file_name - Name of the file, for messages
+--|     direct - Whether fd was opened with O_DIRECT
+--| Return:
+--|     A UringSink Object
+--|-------------------------------------------------------------------------
+*/
+UringSink::UringSink(int fd, const char* file_name, bool direct) : OutputSink(fd, file_name, direct), ring(&ThreadRing()), in_flight(0), write_failed(false)
+{
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor. Closes the file if Close was not called.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+UringSink::~UringSink()
+{
+    Close();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Checks that this thread can have an io_uring, setting its ring up
+--|     the first time
+--| Args:
+--|     none
+--| Return:
+--|     bool - false where the kernel is too old or io_uring is blocked
+--|-------------------------------------------------------------------------
+*/
+bool UringSink::Available()
+{
+    return ThreadRing().ok;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets a free buffer of the ring, waiting for a write to finish if
+--|     every one is in flight
+--| Args:
+--|     none
+--| Return:
+--|     unsigned char* - The buffer, NULL if the ring broke
+--|-------------------------------------------------------------------------
+*/
+unsigned char* UringSink::GetBuffer()
+{
+    const int slot = ring->Claim();
+    return slot < 0 ? NULL : ring->buffers + slot * SINK_BUFFER_SIZE;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Queues a filled buffer and returns without waiting for it
+--| Args:
+--|     buffer - A buffer from GetBuffer
+--|     size - Bytes to write
+--|     offset - Where in the file they go
+--| Return:
+--|     bool - false if the kernel did not take the write
+--|-------------------------------------------------------------------------
+*/
+bool UringSink::Submit(unsigned char* buffer, size_t size, uint64_t offset)
+{
+    const int slot = (int)((buffer - ring->buffers) / SINK_BUFFER_SIZE);
+    in_flight++;
+    if (!ring->Push(slot, fd, size, offset, this))
+    {
+        // The write may still be sitting in the ring, so its slot stays taken
+        in_flight--;
+        ring->owner[slot] = NULL;
+        return false;
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Waits for every submitted write of this file
+--| Args:
+--|     none
+--| Return:
+--|     bool - true if all of them wrote everything
+--|-------------------------------------------------------------------------
+*/
+bool UringSink::Finish()
+{
+    while (in_flight > 0)
+    {
+        if (!ring->Reap(true))
+        {
+            return false;
+        }
+    }
+    return !write_failed;
+}
@@ -0,0 +1,103 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef _URING_SINK_H_
+#define _URING_SINK_H_
+
+#include "OutputSink.h"
+
+struct UringRing;
+
+/*
+--|-------------------------------------------------------------------------
+--| Backend that queues every buffer on a Linux io_uring and goes straight
+--| back to filling the next one.
+--|
+--| Each thread has one ring with URING_SLOTS buffers registered with the
+--| kernel, shared by the sinks that thread opens. A buffer is out of use
+--| from its submit until its completion is reaped, so a thread only waits
+--| on the disk when every buffer is in flight, or on Close. The ring is
+--| set up with the raw system calls, no liburing is needed.
+--|-------------------------------------------------------------------------
+*/
+class UringSink : public OutputSink
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor.
+    --| Args:
+    --|     fd - The open file
+    --|     file_name - Name of the file, for messages
+    --|     direct - Whether fd was opened with O_DIRECT
+    --| Return:
+    --|     A UringSink Object
+    --|-------------------------------------------------------------------------
+    */
+    UringSink(int fd, const char* file_name, bool direct);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor. Closes the file if Close was not called.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    ~UringSink();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Checks that this thread can have an io_uring, setting its ring up
+    --|     the first time
+    --| Args:
+    --|     none
+    --| Return:
+    --|     bool - false where the kernel is too old or io_uring is blocked
+    --|-------------------------------------------------------------------------
+    */
+    static bool Available();
+
+protected:
+    // The backend half of OutputSink, see there
+    unsigned char* GetBuffer();
+    bool Submit(unsigned char* buffer, size_t size, uint64_t offset);
+    bool Finish();
+
+private:
+    friend struct UringRing;
+    
+    // The ring of the thread that opened the file
+    UringRing* ring;
+    // Writes submitted and not reaped yet
+    size_t in_flight;
+    // Whether a reaped write failed
+    bool write_failed;
+};
+
+#endif //_URING_SINK_H_
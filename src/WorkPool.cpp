@@ -0,0 +1,319 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "WorkPool.h"
+
+#include <algorithm>
+#include <memory>
+#include "NumaPlacement.h"
+
+// Pool and deque of the calling thread, if it is a worker
+static thread_local WorkPool* current_pool = NULL;
+static thread_local size_t current_worker = 0;
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class constructor, starts the worker threads
+--| Args:
+--|     threads - Number of worker threads, at least one
+--| Return:
+--|     A WorkPool Object
+--|-------------------------------------------------------------------------
+*/
+WorkPool::WorkPool(size_t threads) : queued(0), pending(0), next_queue(0), stopping(false)
+{
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+    for (size_t t = 0; t < threads; t++)
+    {
+        queues.push_back(new WorkQueue);
+    }
+    for (size_t t = 0; t < threads; t++)
+    {
+        workers.push_back(std::thread(&WorkPool::WorkerLoop, this, t));
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Class destructor, lets the workers finish what is queued and
+--|     joins them
+--| Args:
+--|     None
+--| Return:
+--|     None
+--|-------------------------------------------------------------------------
+*/
+WorkPool::~WorkPool(void)
+{
+    Wait();
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (size_t t = 0; t < workers.size(); t++)
+    {
+        workers[t].join();
+    }
+    for (size_t t = 0; t < queues.size(); t++)
+    {
+        delete queues[t];
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Queues a task to run on one of the workers
+--| Args:
+--|     task - Callable taking no arguments
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void WorkPool::Submit(const std::function<void()> &task)
+{
+    size_t q = (current_pool == this) ? current_worker : next_queue++ % queues.size();
+    pending++;
+    
+    // Counted before it can be taken, so TakeTask never counts below zero.
+    // Taking the lock makes sure a worker about to sleep sees the task
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(queues[q]->lock);
+        queues[q]->tasks.push_back(task);
+    }
+    wake.notify_one();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Blocks until every submitted task, and every task those
+--|     submitted, has finished. Must not be called from a worker.
+--| Args:
+--|     none
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void WorkPool::Wait()
+{
+    std::unique_lock<std::mutex> guard(sleep_lock);
+    idle.wait(guard, [&]() { return pending == 0; });
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Calls fn(i) for every i in [0, count), the calling worker and any
+--|     idle workers taking indices one at a time. While the last indices
+--|     finish elsewhere the calling worker runs queued tasks, or sleeps.
+--| Args:
+--|     count - Number of work items
+--|     fn - Called once per index
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void WorkPool::ForEach(size_t count, const std::function<void(size_t)> &fn)
+{
+    // Helpers may only get to run after the loop is over, so they hold on
+    // to the counters themselves and never touch fn once it has run out
+    struct Progress
+    {
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::mutex lock;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<Progress> progress(new Progress);
+    progress->next = 0;
+    progress->done = 0;
+    const std::function<void(size_t)>* work = &fn;
+    std::function<void()> drain = [progress, work, count]()
+    {
+        for (size_t i = progress->next++; i < count; i = progress->next++)
+        {
+            (*work)(i);
+            if (++progress->done == count)
+            {
+                std::lock_guard<std::mutex> guard(progress->lock);
+                progress->finished.notify_all();
+            }
+        }
+    };
+    
+    size_t helpers = std::min(count, queues.size());
+    for (size_t h = 1; h < helpers; h++)
+    {
+        Submit(drain);
+    }
+    drain();
+    
+    // Others may still be on their last index. Meanwhile run what is queued,
+    // leftover helpers of this loop included, and sleep once nothing is
+    std::function<void()> task;
+    while (progress->done < count)
+    {
+        if (current_pool == this && TakeTask(current_worker, task))
+        {
+            RunTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(progress->lock);
+        progress->finished.wait(guard, [&]() { return progress->done == count; });
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the number of worker threads
+--| Args:
+--|     none
+--| Return:
+--|     size_t - Number of workers
+--|-------------------------------------------------------------------------
+*/
+size_t WorkPool::GetSize() const
+{
+    return workers.size();
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the pool the calling thread works for
+--| Args:
+--|     none
+--| Return:
+--|     WorkPool* - The pool, NULL if the caller is not a worker
+--|-------------------------------------------------------------------------
+*/
+WorkPool* WorkPool::GetCurrent()
+{
+    return current_pool;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Runs tasks until the pool is torn down, sleeping when there are none
+--| Args:
+--|     worker - Index of this worker's deque
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void WorkPool::WorkerLoop(size_t worker)
+{
+    current_pool = this;
+    current_worker = worker;
+    NumaPlacement::PinWorker(worker);
+    std::function<void()> task;
+    while (true)
+    {
+        if (TakeTask(worker, task))
+        {
+            RunTask(task);
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> guard(sleep_lock);
+        wake.wait(guard, [&]() { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+        {
+            return;
+        }
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Runs a task taken off a deque and counts it finished
+--| Args:
+--|     task - The task, cleared once it has run
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void WorkPool::RunTask(std::function<void()> &task)
+{
+    task();
+    task = NULL;
+    if (--pending == 0)
+    {
+        std::lock_guard<std::mutex> guard(sleep_lock);
+        idle.notify_all();
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Takes the newest task of this worker, or steals the oldest task of
+--|     another one
+--| Args:
+--|     worker - Index of this worker's deque
+--|     task - Gets the task
+--| Return:
+--|     bool - false if every deque is empty
+--|-------------------------------------------------------------------------
+*/
+bool WorkPool::TakeTask(size_t worker, std::function<void()> &task)
+{
+    const size_t n = queues.size();
+    for (size_t k = 0; k < n; k++)
+    {
+        WorkQueue* q = queues[(worker + k) % n];
+        std::lock_guard<std::mutex> guard(q->lock);
+        if (q->tasks.empty())
+        {
+            continue;
+        }
+        if (k == 0)
+        {
+            task = q->tasks.back();
+            q->tasks.pop_back();
+        }
+        else
+        {
+            task = q->tasks.front();
+            q->tasks.pop_front();
+        }
+        queued--;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,167 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _WORK_POOL_H_
+#define _WORK_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+--|-------------------------------------------------------------------------
+--| Fixed set of worker threads shared by many jobs.
+--|
+--| Every worker owns a deque of tasks. A worker takes the newest task off
+--| its own deque and, when that is empty, steals the oldest task off
+--| another worker's deque. Tasks submitted from a worker go onto that
+--| worker's deque, tasks submitted from outside are dealt out in turn.
+--|
+--| ParallelFor called on a worker does not start threads of its own but
+--| pushes helper tasks into the pool, so idle workers pitch in on the
+--| layers of whatever job is still running instead of oversubscribing.
+--|-------------------------------------------------------------------------
+*/
+class WorkPool
+{
+public:
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class constructor, starts the worker threads
+    --| Args:
+    --|     threads - Number of worker threads, at least one
+    --| Return:
+    --|     A WorkPool Object
+    --|-------------------------------------------------------------------------
+    */
+    WorkPool(size_t threads);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Class destructor, lets the workers finish what is queued and
+    --|     joins them
+    --| Args:
+    --|     None
+    --| Return:
+    --|     None
+    --|-------------------------------------------------------------------------
+    */
+    ~WorkPool(void);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Queues a task to run on one of the workers
+    --| Args:
+    --|     task - Callable taking no arguments
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Submit(const std::function<void()> &task);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Blocks until every submitted task, and every task those
+    --|     submitted, has finished. Must not be called from a worker.
+    --| Args:
+    --|     none
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void Wait();
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Calls fn(i) for every i in [0, count), the calling worker and any
+    --|     idle workers taking indices one at a time. While the last indices
+    --|     finish elsewhere the calling worker runs queued tasks, or sleeps.
+    --| Args:
+    --|     count - Number of work items
+    --|     fn - Called once per index
+    --| Return:
+    --|     none
+    --|-------------------------------------------------------------------------
+    */
+    void ForEach(size_t count, const std::function<void(size_t)> &fn);
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the number of worker threads
+    --| Args:
+    --|     none
+    --| Return:
+    --|     size_t - Number of workers
+    --|-------------------------------------------------------------------------
+    */
+    size_t GetSize() const;
+    
+    /*
+    --|-------------------------------------------------------------------------
+    --| Purpose:
+    --|     Gets the pool the calling thread works for
+    --| Args:
+    --|     none
+    --| Return:
+    --|     WorkPool* - The pool, NULL if the caller is not a worker
+    --|-------------------------------------------------------------------------
+    */
+    static WorkPool* GetCurrent();
+
+private:
+    // Tasks of one worker, newest at the back
+    struct WorkQueue
+    {
+        std::mutex lock;
+        std::deque<std::function<void()> > tasks;
+    };
+    
+    void WorkerLoop(size_t worker);
+    bool TakeTask(size_t worker, std::function<void()> &task);
+    void RunTask(std::function<void()> &task);
+    
+    std::vector<std::thread> workers;
+    std::vector<WorkQueue*> queues;
+    // Tasks sitting in the queues
+    std::atomic<size_t> queued;
+    // Tasks submitted and not yet finished
+    std::atomic<size_t> pending;
+    // Where the next task from outside the pool goes
+    std::atomic<size_t> next_queue;
+    bool stopping;
+    std::mutex sleep_lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+};
+
+#endif //_WORK_POOL_H_
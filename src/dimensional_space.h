@@ -24,25 +24,35 @@ THE SOFTWARE.
 #ifndef _DIMENSIONAL_SPACE_H_
 #define _DIMENSIONAL_SPACE_H_
 
-// A representation of a point in 3D space.
+// A representation of a point in 3D space, with float or double coordinates.
 // Has operators for Translation, Subtraction, Addition, Division and Multiplication
-typedef struct point 
+template <typename Real>
+struct PointT
 {
-    float x;
-    float y;
-    float z;
+    Real x;
+    Real y;
+    Real z;
     
     // Construct a point by giving it an x y and z coordinate
     // After all, it couldnt be a point any other way right?
-    point(float input_x=0, float input_y=0, float input_z=0)
+    PointT(Real input_x=0, Real input_y=0, Real input_z=0)
     {
         x = input_x;
         y = input_y;
         z = input_z;
     }
+    
+    // Conversion from a point of the other precision
+    template <typename Other>
+    explicit PointT(const PointT<Other> &pt)
+    {
+        x = (Real)pt.x;
+        y = (Real)pt.y;
+        z = (Real)pt.z;
+    }
 
     // Translation
-    point& operator-=(const point &pt) 
+    PointT& operator-=(const PointT &pt) 
     { 
         x-=pt.x;
         y-=pt.y;
@@ -52,44 +62,50 @@ typedef struct point
     }
     
     // Subtraction
-    point operator-(const point &pt) 
+    PointT operator-(const PointT &pt) 
     { 
-        return point(x-pt.x, y-pt.y, z-pt.z); 
+        return PointT(x-pt.x, y-pt.y, z-pt.z); 
     }
     
     // Addition
-    point operator+(const point &pt)
+    PointT operator+(const PointT &pt)
     { 
-        return point(x+pt.x, y+pt.y, z+pt.z); 
+        return PointT(x+pt.x, y+pt.y, z+pt.z); 
     }
     
     // Division
-    point operator/(float a) 
+    PointT operator/(Real a) 
     { 
-        return point(x/a, y/a, z/a); 
+        return PointT(x/a, y/a, z/a); 
     }
     
     // Multiplication
-    point operator*(float a)    
+    PointT operator*(Real a)    
     { 
-        return point(x*a, y*a, z*a); 
+        return PointT(x*a, y*a, z*a); 
     }
 
-}point; 
+};
+
+// Meshes and sliced layers are stored in float, double is only used while slicing
+typedef PointT<float> point;
 
 // Struct for a line segment consisting of two points. 
-typedef struct LineSeg
+template <typename Real>
+struct LineSegT
 {
-    point pt0;
-    point pt1;
+    PointT<Real> pt0;
+    PointT<Real> pt1;
     
-    LineSeg(point p0 = point(), point p1 = point()) 
+    LineSegT(PointT<Real> p0 = PointT<Real>(), PointT<Real> p1 = PointT<Real>()) 
     { 
         pt0 = p0; 
         pt1 = p1; 
     }
 
-}LineSeg;
+};
+
+typedef LineSegT<float> LineSeg;
 
 // Struct for a slicepiece used for toolpath generation. 
 // It's just two points and the distance between them.
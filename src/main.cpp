@@ -34,24 +34,598 @@ Version: 0.71
 #include <cstring>
 #include <vector>
 #include <cmath>
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 #include <stdlib.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <chrono>
+#include <thread>
 
 #include "TriangleMesh.h"
 #include "Triangle.h"
 #include "dimensional_space.h"
 #include "Slicer.h"
 #include "SlicedLayers.h"
+#include "LayerCodec.h"
+#include "LayerToolpaths.h"
+#include "Infill.h"
+#include "PathOrder.h"
+#include "RasterExporter.h"
+#include "TilePyramid.h"
+#include "RadiusSchedule.h"
+#include "MeshDecimator.h"
+#include "OutOfCoreSlicer.h"
+#include "BatchSlicer.h"
+#include "CostEstimator.h"
+#include "IncrementalSlicer.h"
+#include "SliceJournal.h"
+#include "OutputSink.h"
+#include "NumaPlacement.h"
+#include "Trace.h"
+#include "Log.h"
+#include "Parallel.h"
+
+// Set by Ctrl-C during a progressive or journalled slice or while watching
+static volatile sig_atomic_t stop_requested = 0;
+
+// How often --watch looks at the STL file
+static const int WATCH_POLL_MS = 250;
+
+// Where a progressive slice publishes each pass
+struct ProgressiveOutput
+{
+    const char* binary_file;
+    float grid;
+};
+
+// What --watch writes, and what it keeps to only write the layers that changed
+struct WatchOutput
+{
+    const char* giv_file;
+    const char* binary_file;
+    float grid;
+    float infill_spacing;
+    float infill_angle;
+    bool order;
+    double order_ms;
+    const char* raster_prefix;
+    float dpi;
+    RasterExporter::Format raster_format;
+    const char* tiles_prefix;
+    float tile_dpi;
+    size_t tile_size;
+    // Encoded layers of the last binary file
+    std::vector<std::vector<unsigned char> > payloads;
+    // x range the last masks were drawn over
+    float raster_x_min;
+    float raster_x_max;
+};
+
+// Which layers shard i of n slices, the same in every process and in merge
+static void ShardBounds(size_t count, unsigned int shard, unsigned int shards, size_t &first, size_t &last)
+{
+    first = count * (shard - 1) / shards;
+    last = count * shard / shards;
+}
+
+// Works out which layers shard i of n slices and says so
+static void GetShardRange(size_t count, unsigned int shard, unsigned int shards, size_t &first, size_t &last)
+{
+    ShardBounds(count, shard, shards, first, last);
+    printf("Shard %u/%u: %lu of the %lu layers, starting at layer %lu\n", shard, shards, (unsigned long)(last - first), (unsigned long)count, (unsigned long)first);
+}
+
+// Where the rolled out layers start and end across the sheet
+static void GetSheetRange(const SlicedLayers* layers, float &x_min, float &x_max)
+{
+    x_min = x_max = 0.0f;
+    bool first = true;
+    for (size_t j = 0; j < layers->GetSize(); j++)
+    {
+        const std::vector<slicepiece> &layer = layers->GetLayer(j);
+        for (size_t k = 0; k < layer.size(); k++)
+        {
+            if (first)
+            {
+                x_min = x_max = layer[k].a.x;
+                first = false;
+            }
+            x_min = std::min(x_min, std::min(layer[k].a.x, layer[k].b.x));
+            x_max = std::max(x_max, std::max(layer[k].a.x, layer[k].b.x));
+        }
+    }
+}
+
+// How far the rolled out layers reach across the sheet
+static float GetSheetWidth(const SlicedLayers* layers)
+{
+    float x_min, x_max;
+    GetSheetRange(layers, x_min, x_max);
+    return x_max - x_min;
+}
+
+// The library keeps quiet unless told where to talk
+static void PrintLog(const char* message, void*)
+{
+    fputs(message, stdout);
+}
+
+static void RequestStop(int)
+{
+    stop_requested = 1;
+}
+
+// Rewrites the binary file after every pass, through a rename so readers never see half a file
+static bool PublishPass(const SlicedLayers* layers, int pass, int passes, void* user)
+{
+    const ProgressiveOutput* out = (const ProgressiveOutput*)user;
+    if (out->binary_file)
+    {
+        char temp_file[1024];
+        snprintf(temp_file, sizeof(temp_file), "%s.part", out->binary_file);
+        LayerCodec codec(out->grid);
+        if (!codec.ExportBinary(layers, temp_file))
+        {
+            printf("ERROR could not write %s, %s is left as it was!\n", temp_file, out->binary_file);
+            remove(temp_file);
+        }
+        else if (rename(temp_file, out->binary_file) != 0)
+        {
+            printf("ERROR could not replace %s!\n", out->binary_file);
+            remove(temp_file);
+        }
+    }
+    return !stop_requested;
+}
+
+// slicyl merge out.slc part1.slc part2.slc ..., puts the layers of --shard runs back together
+static int MergeShards(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        printf("ERROR in merging shards!\nMake sure the input format is ./slicyl merge out.slc part1.slc part2.slc ...\n");
+        return 1;
+    }
+    
+    // Every record already knows its place in the whole job
+    const unsigned int shards = (unsigned int)(argc - 1);
+    SlicedLayers merged;
+    std::vector<int> owner;
+    std::vector<size_t> part_first(argc, 0), part_last(argc, 0);
+    std::vector<char> declared(argc, 0);
+    std::vector<int> share_taken(shards + 1, 0);
+    size_t job_layers = 0;
+    float grid = 0.0f;
+    for (int i = 1; i < argc; i++)
+    {
+        SlicedLayers part;
+        LayerCodec codec;
+        if (!codec.ImportBinary(argv[i], &part))
+        {
+            return 1;
+        }
+        if (i > 1 && codec.GetGrid() != grid)
+        {
+            printf("ERROR %s was written with grid %g instead of %g!\n", argv[i], codec.GetGrid(), grid);
+            return 1;
+        }
+        grid = codec.GetGrid();
+        
+        // Shards that say which they are must hold just that share
+        unsigned int share, share_count;
+        size_t share_layers;
+        declared[i] = codec.GetShard(share, share_count, share_layers);
+        if (declared[i])
+        {
+            if (share_count != shards)
+            {
+                printf("ERROR %s is shard %u/%u but %u files were given, merge takes every shard of a job at once!\n", argv[i], share, share_count, shards);
+                return 1;
+            }
+            if (job_layers != 0 && share_layers != job_layers)
+            {
+                printf("ERROR %s is a shard of %lu layers, not %lu like the others!\n", argv[i], (unsigned long)share_layers, (unsigned long)job_layers);
+                return 1;
+            }
+            if (share_taken[share])
+            {
+                printf("ERROR %s and %s are both shard %u/%u!\n", argv[share_taken[share]], argv[i], share, shards);
+                return 1;
+            }
+            share_taken[share] = i;
+            job_layers = share_layers;
+        }
+        
+        // A shard is one unbroken run of layers
+        size_t first = part.GetSize(), last = 0, held = 0;
+        for (size_t j = 0; j < part.GetSize(); j++)
+        {
+            if (part.HasLayer(j))
+            {
+                first = std::min(first, j);
+                last = j + 1;
+                held++;
+            }
+        }
+        if (held == 0)
+        {
+            first = last = 0;
+        }
+        if (held != last - first)
+        {
+            printf("ERROR %s has gaps between layers %lu and %lu, it is not one shard!\n", argv[i], (unsigned long)first, (unsigned long)(last - 1));
+            return 1;
+        }
+        if (declared[i])
+        {
+            size_t share_first, share_last;
+            ShardBounds(share_layers, share, shards, share_first, share_last);
+            if (held != 0 ? first != share_first || last != share_last : share_first != share_last)
+            {
+                printf("ERROR %s is shard %u/%u, layers %lu to %lu, but holds %lu layers starting at layer %lu!\n", argv[i], share, shards, (unsigned long)share_first, (unsigned long)share_last - 1, (unsigned long)held, (unsigned long)first);
+                return 1;
+            }
+        }
+        
+        // Nothing goes into the merge until the whole shard is known to fit
+        for (size_t j = first; j < last && j < owner.size(); j++)
+        {
+            if (owner[j] != 0)
+            {
+                printf("ERROR %s and %s both hold layer %lu, they overlap!\n", argv[owner[j]], argv[i], (unsigned long)j);
+                return 1;
+            }
+        }
+        if (owner.size() < last)
+        {
+            owner.resize(last, 0);
+        }
+        for (size_t j = first; j < last; j++)
+        {
+            merged.SetLayer(j, part.GetLayer(j), part.GetLayerRadius(j));
+            owner[j] = i;
+        }
+        part_first[i] = first;
+        part_last[i] = last;
+    }
+    
+    // Files from before shards said which they are have to be exactly the share of one left over
+    const size_t count = std::max(merged.GetSize(), job_layers);
+    merged.Resize(count);
+    for (int i = 1; i < argc; i++)
+    {
+        if (declared[i])
+        {
+            continue;
+        }
+        unsigned int share = 0;
+        for (unsigned int k = 1; k <= shards && share == 0; k++)
+        {
+            size_t first, last;
+            ShardBounds(count, k, shards, first, last);
+            bool empty = first == last && part_first[i] == part_last[i];
+            if (!share_taken[k] && (empty || (first == part_first[i] && last == part_last[i])))
+            {
+                share = k;
+            }
+        }
+        if (share == 0)
+        {
+            printf("ERROR %s holds %lu layers starting at layer %lu, which is no shard i/%u of %lu layers. Was a shard left out, or one of another job given?\n", argv[i], (unsigned long)(part_last[i] - part_first[i]), (unsigned long)part_first[i], shards, (unsigned long)count);
+            return 1;
+        }
+        share_taken[share] = i;
+    }
+    for (size_t j = 0; j < merged.GetSize(); j++)
+    {
+        if (!merged.HasLayer(j))
+        {
+            printf("ERROR layer %lu is missing, was a shard left out?\n", (unsigned long)j);
+            return 1;
+        }
+    }
+    
+    LayerCodec codec(grid);
+    if (!codec.ExportBinary(&merged, argv[0]))
+    {
+        return 1;
+    }
+    
+    // No mesh to size the preview by, so go by how far the layers reach along x
+    Slicer slice;
+    slice.exportGIV(&merged, point(GetSheetWidth(&merged), 0, 0), NULL);
+    printf("%lu layers merged from %d shards into %s !!\n", (unsigned long)merged.GetSize(), argc - 1, argv[0]);
+    return 0;
+}
+
+// slicyl batch manifest.txt [--memory MB] [--status file], slices every job listed in the manifest
+static int RunBatch(int argc, char *argv[])
+{
+    if (argc < 1)
+    {
+        printf("ERROR in batch slicing!\nMake sure the input format is ./slicyl batch manifest.txt [--memory MB] [--status file] [--numa] [--trace file.json]\n");
+        return 1;
+    }
+    size_t memory_mb = 0;
+    const char* status_file = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        // Keep the estimated memory of the running jobs under this many megabytes
+        if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc)
+        {
+            memory_mb = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        // Also append the status line of every job to this file
+        else if (strcmp(argv[i], "--status") == 0 && i + 1 < argc)
+        {
+            status_file = argv[++i];
+        }
+        // Pin the workers to cores and give each NUMA node its own copy of the mesh
+        else if (strcmp(argv[i], "--numa") == 0)
+        {
+            NumaPlacement::Enable();
+        }
+        // Write a timeline of every thread to this file at exit
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            if (!StartTrace(argv[++i]))
+            {
+                return 1;
+            }
+        }
+        else
+        {
+            printf("ERROR unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    BatchSlicer batch(memory_mb * 1024 * 1024, GetThreadCount());
+    if (!batch.LoadManifest(argv[0]))
+    {
+        return 1;
+    }
+    FILE* status = NULL;
+    if (status_file)
+    {
+        status = fopen(status_file, "a");
+        if (!status)
+        {
+            printf("ERROR opening %s for writing!\n", status_file);
+            return 1;
+        }
+    }
+    bool ok = batch.Run(status);
+    if (status)
+    {
+        fclose(status);
+    }
+    return ok ? 0 : 1;
+}
+
+// Where a journalled slice puts each finished layer
+struct JournalledSlice
+{
+    SliceJournal* journal;
+    SlicedLayers* layers;
+    // Layer number of each radius being sliced
+    const std::vector<size_t>* todo;
+    bool failed;
+};
+
+// Journals a finished layer and keeps it, stopping on Ctrl-C once it is journalled
+static bool JournalLayer(size_t index, float radius, const std::vector<slicepiece> &layer, void* user)
+{
+    JournalledSlice* out = (JournalledSlice*)user;
+    const size_t i = (*out->todo)[index];
+    if (!out->journal->Append(i, radius, layer))
+    {
+        out->failed = true;
+        return false;
+    }
+    std::vector<slicepiece> kept(layer);
+    out->layers->SetLayer((int)i, kept, radius);
+    return !stop_requested;
+}
+
+// Slices the layers the journal does not hold yet, journalling each one as it finishes
+static bool SliceJournalled(const Slicer &slice, const TriangleMesh* mesh, SlicedLayers* layers, const std::vector<float> &radii, const char* journal_file, double sync_seconds, bool resume)
+{
+    SliceJournal journal(sync_seconds);
+    const uint64_t mesh_hash = SliceJournal::HashMesh(mesh);
+    const uint64_t settings_hash = slice.HashSettings(radii);
+    bool opened = resume ? journal.Resume(journal_file, mesh_hash, settings_hash, radii.size(), layers) : journal.Create(journal_file, mesh_hash, settings_hash, radii.size());
+    if (!opened)
+    {
+        return false;
+    }
+    layers->Resize(radii.size());
+    std::vector<size_t> todo;
+    std::vector<float> todo_radii;
+    for (size_t i = 0; i < radii.size(); i++)
+    {
+        if (!layers->HasLayer(i))
+        {
+            todo.push_back(i);
+            todo_radii.push_back(radii[i]);
+        }
+    }
+    
+    // Ctrl-C or a pre-empting kill stops once the layers under way are journalled
+    JournalledSlice out = {&journal, layers, &todo, false};
+    signal(SIGINT, RequestStop);
+    signal(SIGTERM, RequestStop);
+    size_t sliced = todo.empty() ? 0 : slice.SliceStream(mesh, todo_radii, JournalLayer, &out);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    if (!journal.Close() || out.failed)
+    {
+        return false;
+    }
+    if (sliced < todo.size())
+    {
+        printf("Stopped with %lu layers left to slice, --resume carries on from %s\n", (unsigned long)(todo.size() - sliced), journal_file);
+        return false;
+    }
+    return true;
+}
+
+// Whether a file looks untouched since it was last looked at
+static bool SameFileState(const struct stat &a, const struct stat &b)
+{
+    return a.st_ino == b.st_ino && a.st_size == b.st_size && a.st_mtim.tv_sec == b.st_mtim.tv_sec && a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+// Brings the --watch outputs up to date, redoing only the changed layers where an output is per layer
+static void WriteWatchOutputs(Slicer &slice, const TriangleMesh* mesh, SlicedLayers* layers, LayerToolpaths* toolpaths, WatchOutput &out, const std::vector<size_t>* changed)
+{
+    const size_t count = changed ? changed->size() : layers->GetSize();
+    if (out.infill_spacing > 0.0f)
+    {
+        Infill infill(out.infill_spacing, out.infill_angle);
+        if (!changed)
+        {
+            toolpaths->Resize(layers->GetSize());
+        }
+        ParallelFor(count, [&](size_t k)
+        {
+            const size_t i = changed ? (*changed)[k] : k;
+            toolpaths->GetInfill(i).clear();
+            infill.FillLayer(layers->GetLayer(i), layers->GetLayerRadius(i), toolpaths->GetInfill(i));
+        });
+    }
+    if (out.order)
+    {
+        PathOrder path_order(out.order_ms);
+        ParallelFor(count, [&](size_t k)
+        {
+            const size_t i = changed ? (*changed)[k] : k;
+            double before;
+            path_order.OrderLayer(layers->GetLayer(i), &before);
+            if (out.infill_spacing > 0.0f)
+            {
+                path_order.OrderLayer(toolpaths->GetInfill(i), &before);
+            }
+        });
+    }
+    const LayerToolpaths* infill = out.infill_spacing > 0.0f ? toolpaths : NULL;
+    
+    // The preview is drawn over the whole sheet, so it is written whole
+    if (out.tiles_prefix)
+    {
+        TilePyramid tiles(out.tile_dpi, out.tile_size);
+        tiles.ExportTiles(layers, mesh->GetBBoxSize(), infill, out.tiles_prefix);
+    }
+    else
+    {
+        slice.exportGIV(layers, mesh->GetBBoxSize(), infill, out.giv_file);
+    }
+    
+    // Only changed layers are encoded again, through a rename so readers never see half a file
+    if (out.binary_file)
+    {
+        char temp_file[1024];
+        snprintf(temp_file, sizeof(temp_file), "%s.part", out.binary_file);
+        LayerCodec codec(out.grid);
+        if (!codec.ExportBinary(layers, temp_file, out.payloads, changed))
+        {
+            printf("ERROR could not write %s, %s is left as it was!\n", temp_file, out.binary_file);
+            remove(temp_file);
+        }
+        else if (rename(temp_file, out.binary_file) != 0)
+        {
+            printf("ERROR could not replace %s!\n", out.binary_file);
+            remove(temp_file);
+        }
+    }
+    
+    // Masks span the whole model, they all change when its x range does
+    if (out.raster_prefix)
+    {
+        float x_min, x_max;
+        GetSheetRange(layers, x_min, x_max);
+        bool same_range = changed && x_min == out.raster_x_min && x_max == out.raster_x_max;
+        out.raster_x_min = x_min;
+        out.raster_x_max = x_max;
+        RasterExporter raster(out.dpi, out.raster_format);
+        raster.ExportLayers(layers, out.raster_prefix, same_range ? changed : NULL);
+    }
+}
+
+// Slices an STL file, then again every time it is saved, until Ctrl-C
+static int WatchFile(const char* stl_file, Slicer &slice, const std::vector<float> &radii, WatchOutput &out)
+{
+    IncrementalSlicer incremental(slice, radii);
+    SlicedLayers layers;
+    LayerToolpaths toolpaths;
+    std::vector<size_t> changed;
+    
+    // Looked at before loading, so a save during the first slice is not missed
+    struct stat seen;
+    if (stat(stl_file, &seen) != 0 || !incremental.SliceFile(stl_file, &layers, changed))
+    {
+        printf("ERROR could not read %s\n", stl_file);
+        return 1;
+    }
+    WriteWatchOutputs(slice, incremental.GetMesh(), &layers, &toolpaths, out, NULL);
+    printf("Watching %s for changes, Ctrl-C to stop\n", stl_file);
+    
+    signal(SIGINT, RequestStop);
+    while (!stop_requested)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_POLL_MS));
+        struct stat now;
+        if (stat(stl_file, &now) != 0 || SameFileState(now, seen))
+        {
+            continue;
+        }
+        
+        // Give whatever is saving the file until it stops changing
+        do
+        {
+            seen = now;
+            std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_POLL_MS));
+        } while (!stop_requested && stat(stl_file, &now) == 0 && !SameFileState(now, seen));
+        if (stop_requested)
+        {
+            break;
+        }
+        
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (!incremental.SliceFile(stl_file, &layers, changed))
+        {
+            printf("ERROR could not read %s, keeping the last layers\n", stl_file);
+            continue;
+        }
+        if (!changed.empty())
+        {
+            WriteWatchOutputs(slice, incremental.GetMesh(), &layers, &toolpaths, out, &changed);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%lu of %lu layers sliced again from %s in %0.3f s\n", (unsigned long)changed.size(), (unsigned long)radii.size(), stl_file, seconds);
+    }
+    signal(SIGINT, SIG_DFL);
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
     // Initialize things
-    char FileName[1024];
+    SetLogHandler(PrintLog, NULL);
     Slicer slice;
     TriangleMesh* mesh = new TriangleMesh;
     SlicedLayers* layers = new SlicedLayers;
     
+    if (argc >= 2 && strcmp(argv[1], "merge") == 0)
+    {
+        return MergeShards(argc - 2, argv + 2);
+    }
+    if (argc >= 2 && strcmp(argv[1], "batch") == 0)
+    {
+        return RunBatch(argc - 2, argv + 2);
+    }
     if (argc < 5)
     {
         printf("ERROR in launching mesh generator!\nMake sure the input format is ./generate_mesh filename.stl startradius thickness endradius\n\n Try -h for help!\n");
@@ -59,14 +633,377 @@ int main(int argc, char *argv[])
     }
 
     // Get the command line arguments
-    strcpy(FileName, argv[1]);
+    const char* FileName = argv[1];
     float start_radius = strtof(argv[2], NULL);
     float thickness = strtof(argv[3], NULL);
     float radius = strtof(argv[4], NULL);
     
+    // Optional arguments
+    const char* binary_file = NULL;
+    float grid = 0.001f;
+    float infill_spacing = 0.0f;
+    float infill_angle = 0.0f;
+    bool order = false;
+    double order_ms = 0.0;
+    const char* raster_prefix = NULL;
+    float dpi = 300.0f;
+    RasterExporter::Format raster_format = RasterExporter::RASTER_PNG;
+    const char* tiles_prefix = NULL;
+    float tile_dpi = 100.0f;
+    size_t tile_size = 256;
+    float adaptive_max = 0.0f;
+    size_t preview_facets = 0;
+    bool progressive = false;
+    SliceRegion region;
+    SurfaceShape surface;
+    size_t out_of_core_mb = 0;
+    unsigned int shard = 0, shards = 0;
+    bool estimate = false;
+    size_t estimate_samples = 0;
+    bool watch = false;
+    const char* journal_file = NULL;
+    double journal_seconds = 30.0;
+    bool resume = false;
+    OutputSink::Backend sink = OutputSink::SINK_AUTO;
+    bool direct_io = false;
+    const char* giv_file = "slicyl_out.marks";
+    for (int i = 5; i < argc; i++)
+    {
+        // Also write the compressed binary layers
+        if (strcmp(argv[i], "--binary") == 0 && i + 1 < argc)
+        {
+            binary_file = argv[++i];
+        }
+        // Quantization step of the binary layers
+        else if (strcmp(argv[i], "--grid") == 0 && i + 1 < argc)
+        {
+            grid = strtof(argv[++i], NULL);
+        }
+        // Raster infill every so often
+        else if (strcmp(argv[i], "--infill") == 0 && i + 1 < argc)
+        {
+            infill_spacing = strtof(argv[++i], NULL);
+        }
+        // Direction of the raster infill, in degrees from the x axis
+        else if (strcmp(argv[i], "--infill-angle") == 0 && i + 1 < argc)
+        {
+            infill_angle = strtof(argv[++i], NULL) * (float)PI / 180.0f;
+        }
+        // Reorder the moves of each layer to cut down on travel
+        else if (strcmp(argv[i], "--order") == 0)
+        {
+            order = true;
+        }
+        // Milliseconds per layer to polish the order with 2-opt
+        else if (strcmp(argv[i], "--order-time") == 0 && i + 1 < argc)
+        {
+            order = true;
+            order_ms = strtod(argv[++i], NULL);
+        }
+        // Also write a bitmap of every rolled out layer
+        else if (strcmp(argv[i], "--raster") == 0 && i + 1 < argc)
+        {
+            raster_prefix = argv[++i];
+        }
+        // Resolution of the bitmaps
+        else if (strcmp(argv[i], "--dpi") == 0 && i + 1 < argc)
+        {
+            dpi = strtof(argv[++i], NULL);
+        }
+        // File format of the bitmaps, png or pbm
+        else if (strcmp(argv[i], "--raster-format") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "pbm") == 0)
+            {
+                raster_format = RasterExporter::RASTER_PBM;
+            }
+            else if (strcmp(argv[i], "png") == 0)
+            {
+                raster_format = RasterExporter::RASTER_PNG;
+            }
+            else
+            {
+                printf("ERROR unknown raster format %s\n", argv[i]);
+                return 1;
+            }
+        }
+        // Write the preview as a tiled image pyramid instead of one GIV file
+        else if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc)
+        {
+            tiles_prefix = argv[++i];
+        }
+        // Resolution of the finest tiles
+        else if (strcmp(argv[i], "--tile-dpi") == 0 && i + 1 < argc)
+        {
+            tile_dpi = strtof(argv[++i], NULL);
+        }
+        // Width and height of the tiles in pixels
+        else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc)
+        {
+            tile_size = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        // Space the layers to follow the mesh, thickness is then the thinnest layer
+        else if (strcmp(argv[i], "--adaptive") == 0 && i + 1 < argc)
+        {
+            adaptive_max = strtof(argv[++i], NULL);
+        }
+        // Slice a coarse copy of the mesh with at most this many Triangles
+        else if (strcmp(argv[i], "--preview") == 0 && i + 1 < argc)
+        {
+            preview_facets = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        // Slice every 2^k-th layer first and fill in between, rewriting --binary after each pass
+        else if (strcmp(argv[i], "--progressive") == 0)
+        {
+            progressive = true;
+        }
+        // Only slice between these two x values
+        else if (strcmp(argv[i], "--region") == 0 && i + 2 < argc)
+        {
+            region.x_min = strtof(argv[++i], NULL);
+            region.x_max = strtof(argv[++i], NULL);
+        }
+        // Only slice this many degrees around the axis, starting at the first angle
+        else if (strcmp(argv[i], "--sector") == 0 && i + 2 < argc)
+        {
+            region.angle_start = strtof(argv[++i], NULL) * (float)PI / 180.0f;
+            region.angle_span = strtof(argv[++i], NULL) * (float)PI / 180.0f;
+        }
+        // Never hold more than this many megabytes of Triangles, streaming the layers into --binary
+        else if (strcmp(argv[i], "--out-of-core") == 0 && i + 1 < argc)
+        {
+            out_of_core_mb = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        // Only slice the i-th of n equal runs of layers, for slicyl merge to put back together
+        else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (sscanf(argv[i], "%u/%u", &shard, &shards) != 2 || shard < 1 || shard > shards)
+            {
+                printf("ERROR --shard wants i/n with i from 1 to n, not %s\n", argv[i]);
+                return 1;
+            }
+        }
+        // Name of the GIV preview
+        else if (strcmp(argv[i], "--giv") == 0 && i + 1 < argc)
+        {
+            giv_file = argv[++i];
+        }
+        // Only predict what slicing would take, then stop
+        else if (strcmp(argv[i], "--estimate") == 0)
+        {
+            estimate = true;
+        }
+        // Same, calibrated by cutting this many of the layers for real
+        else if (strcmp(argv[i], "--estimate-samples") == 0 && i + 1 < argc)
+        {
+            estimate = true;
+            estimate_samples = (size_t)strtoul(argv[++i], NULL, 10);
+        }
+        // Keep slicing the STL file again whenever it is saved, redoing only the layers the edit reached
+        else if (strcmp(argv[i], "--watch") == 0)
+        {
+            watch = true;
+        }
+        // Journal finished layers to this file so a killed run can be resumed
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+        {
+            journal_file = argv[++i];
+        }
+        // Seconds between flushes of the journal to disk
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+        {
+            journal_seconds = strtod(argv[++i], NULL);
+        }
+        // Take the layers the --checkpoint journal already holds and only slice the rest
+        else if (strcmp(argv[i], "--resume") == 0)
+        {
+            resume = true;
+        }
+        // How the output files are written, io_uring or plain pwrite
+        else if (strcmp(argv[i], "--sink") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "uring") == 0)
+            {
+                sink = OutputSink::SINK_URING;
+            }
+            else if (strcmp(argv[i], "pwrite") == 0)
+            {
+                sink = OutputSink::SINK_PWRITE;
+            }
+            else
+            {
+                printf("ERROR --sink must be uring or pwrite\n");
+                return 1;
+            }
+        }
+        // Write the output files past the page cache
+        else if (strcmp(argv[i], "--direct-io") == 0)
+        {
+            direct_io = true;
+        }
+        // Pin the workers to cores and give each NUMA node its own copy of the mesh
+        else if (strcmp(argv[i], "--numa") == 0)
+        {
+            NumaPlacement::Enable();
+        }
+        // Write a timeline of every thread to this file at exit
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+        {
+            if (!StartTrace(argv[++i]))
+            {
+                return 1;
+            }
+        }
+        // Where the Slicyls are cut open, in degrees around the x axis from +z
+        else if (strcmp(argv[i], "--seam") == 0 && i + 1 < argc)
+        {
+            slice.SetSeamAngle(strtof(argv[++i], NULL) * (float)PI / 180.0f);
+        }
+        // What the Slicyls are worked out in
+        else if (strcmp(argv[i], "--precision") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "float") == 0)
+            {
+                slice.SetPrecision(Slicer::PRECISION_FLOAT);
+            }
+            else if (strcmp(argv[i], "double") == 0)
+            {
+                slice.SetPrecision(Slicer::PRECISION_DOUBLE);
+            }
+            else
+            {
+                printf("ERROR --precision must be float or double\n");
+                return 1;
+            }
+        }
+        // Work out which side of each layer the vertices are on exactly
+        else if (strcmp(argv[i], "--robust") == 0)
+        {
+            slice.SetRobust(true);
+        }
+        // Cut cones of this half angle in degrees instead of Slicyls
+        else if (strcmp(argv[i], "--cone") == 0 && i + 1 < argc)
+        {
+            surface.kind = SurfaceShape::SURFACE_CONE;
+            surface.half_angle = strtof(argv[++i], NULL) * (float)PI / 180.0f;
+            if (!(fabsf(surface.half_angle) < 0.5f * (float)PI))
+            {
+                printf("ERROR --cone needs a half angle between -90 and 90 degrees\n");
+                return 1;
+            }
+        }
+        // Cut spheres about this centre instead of Slicyls
+        else if (strcmp(argv[i], "--sphere") == 0 && i + 3 < argc)
+        {
+            surface.kind = SurfaceShape::SURFACE_SPHERE;
+            surface.centre.x = strtof(argv[++i], NULL);
+            surface.centre.y = strtof(argv[++i], NULL);
+            surface.centre.z = strtof(argv[++i], NULL);
+        }
+        else
+        {
+            printf("ERROR unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    
+    OutputSink::SetDefaults(sink, direct_io);
+    
+    // Only the Slicyl has radial extents and a sheet measured in model x
+    if (surface.kind != SurfaceShape::SURFACE_CYLINDER && (region.IsLimited() || out_of_core_mb > 0 || adaptive_max > 0.0f || estimate))
+    {
+        printf("ERROR --cone and --sphere cannot be used with --region, --sector, --out-of-core, --adaptive or --estimate\n");
+        return 1;
+    }
+    slice.SetSurface(surface);
+    
+    // Filling needs whole layers to tell inside from outside
+    if (region.IsLimited() && (infill_spacing > 0.0f || raster_prefix))
+    {
+        printf("ERROR --infill and --raster need whole layers and cannot be used with --region or --sector\n");
+        return 1;
+    }
+    slice.SetRegion(region);
+    
+    // A shard is only a part of the layers, it is only good for merging
+    if (shards > 0 && (!binary_file || infill_spacing > 0.0f || raster_prefix || tiles_prefix || progressive))
+    {
+        printf("ERROR --shard needs --binary and cannot be used with --infill, --raster, --tiles or --progressive\n");
+        return 1;
+    }
+    
+    if (estimate && (region.IsLimited() || out_of_core_mb > 0))
+    {
+        printf("ERROR --estimate is for whole meshes sliced in memory and cannot be used with --region, --sector or --out-of-core\n");
+        return 1;
+    }
+    
+    // The journal follows a whole in-memory slice
+    if (resume && !journal_file)
+    {
+        printf("ERROR --resume needs the --checkpoint journal to resume from\n");
+        return 1;
+    }
+    if (journal_file && (out_of_core_mb > 0 || shards > 0 || progressive || estimate || watch))
+    {
+        printf("ERROR --checkpoint cannot be used with --out-of-core, --shard, --progressive, --estimate or --watch\n");
+        return 1;
+    }
+    
+    // Editing keeps the first placement and radii, so neither may follow the mesh
+    if (watch)
+    {
+        if (surface.kind != SurfaceShape::SURFACE_CYLINDER || out_of_core_mb > 0 || shards > 0 || progressive || estimate || adaptive_max > 0.0f || preview_facets > 0)
+        {
+            printf("ERROR --watch cannot be used with --cone, --sphere, --out-of-core, --shard, --progressive, --estimate, --adaptive or --preview\n");
+            return 1;
+        }
+        std::vector<float> radii;
+        RadiusSchedule::Uniform(start_radius, thickness, radius, radii);
+        WatchOutput out = {giv_file, binary_file, grid, infill_spacing, infill_angle, order, order_ms, raster_prefix, dpi, raster_format, tiles_prefix, tile_dpi, tile_size, std::vector<std::vector<unsigned char> >(), 0.0f, 0.0f};
+        return WatchFile(FileName, slice, radii, out);
+    }
+    
+    // Too big to load, slice it band by band straight into the binary file
+    if (out_of_core_mb > 0)
+    {
+        if (!binary_file || infill_spacing > 0.0f || raster_prefix || tiles_prefix || order || progressive || adaptive_max > 0.0f || preview_facets > 0)
+        {
+            printf("ERROR --out-of-core needs --binary and cannot be used with --infill, --order, --raster, --tiles, --progressive, --adaptive or --preview\n");
+            return 1;
+        }
+        std::vector<float> radii;
+        RadiusSchedule::Uniform(start_radius, thickness, radius, radii);
+        size_t first = 0, last = radii.size();
+        if (shards > 0)
+        {
+            GetShardRange(radii.size(), shard, shards, first, last);
+        }
+        std::vector<float> shard_radii(radii.begin() + first, radii.begin() + last);
+        OutOfCoreSlicer out_of_core(out_of_core_mb * 1024 * 1024);
+        LayerCodec codec(grid);
+        codec.SetShard(shard, shards, radii.size());
+        return out_of_core.SliceFile(FileName, shard_radii, slice, codec, binary_file, first) ? 0 : 1;
+    }
+    
     // Load the file
-    mesh->LoadSTLToMeshASCII(FileName);
-    //mesh->LoadSTLToMeshBinary(FileName);
+    if (!mesh->LoadSTL(FileName))
+    {
+        return 1;
+    }
+    // Trade detail for speed
+    if (preview_facets > 0)
+    {
+        TriangleMesh* preview = new TriangleMesh;
+        MeshDecimator decimator(preview_facets);
+        decimator.Decimate(mesh, preview);
+        delete mesh;
+        mesh = preview;
+    }
     
     // Move the mesh
     //mesh->BBoxAdjust();
@@ -75,11 +1012,118 @@ int main(int argc, char *argv[])
     //slice.exportSTL(mesh,"asdf.stl");
     
     // Slice it up
-    slice.SliceMesh(mesh, layers, thickness, radius, start_radius);
+    std::vector<float> radii;
+    if (adaptive_max > 0.0f)
+    {
+        RadiusSchedule schedule(thickness, adaptive_max);
+        schedule.Adaptive(mesh, start_radius, radius, radii);
+    }
+    else
+    {
+        RadiusSchedule::Uniform(start_radius, thickness, radius, radii);
+    }
+    if (estimate)
+    {
+        SliceEstimate cost;
+        CostEstimator estimator(4096, estimate_samples, grid);
+        estimator.Estimate(mesh, radii, cost);
+        CostEstimator::PrintEstimate(cost);
+        return 0;
+    }
+    // Copies of the mesh on every node under --numa, made once now the mesh is final
+    NumaPlacement* placement = new NumaPlacement(mesh);
+    slice.SetPlacement(placement);
+    if (progressive)
+    {
+        // Ctrl-C finishes the pass under way and keeps what is done
+        ProgressiveOutput published = {binary_file, grid};
+        signal(SIGINT, RequestStop);
+        slice.SliceProgressive(mesh, layers, radii, PublishPass, &published);
+        signal(SIGINT, SIG_DFL);
+    }
+    else if (shards > 0)
+    {
+        // Slice our run of layers and put them at their place in the whole job
+        size_t first, last;
+        GetShardRange(radii.size(), shard, shards, first, last);
+        std::vector<float> shard_radii(radii.begin() + first, radii.begin() + last);
+        SlicedLayers shard_layers;
+        slice.SliceMesh(mesh, &shard_layers, shard_radii);
+        layers->Resize(radii.size());
+        for (size_t i = 0; i < shard_layers.GetSize(); i++)
+        {
+            layers->SetLayer(first + i, shard_layers.GetLayer(i), shard_layers.GetLayerRadius(i));
+        }
+    }
+    else if (journal_file)
+    {
+        if (!SliceJournalled(slice, mesh, layers, radii, journal_file, journal_seconds, resume))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        slice.SliceMesh(mesh, layers, radii);
+    }
+    slice.SetPlacement(NULL);
+    delete placement;
+    
+    // Fill them in
+    LayerToolpaths* toolpaths = NULL;
+    if (infill_spacing > 0.0f)
+    {
+        toolpaths = new LayerToolpaths;
+        Infill infill(infill_spacing, infill_angle);
+        infill.GenerateInfill(layers, toolpaths);
+    }
+    
+    // Less running around
+    if (order)
+    {
+        PathOrder path_order(order_ms);
+        path_order.OrderLayers(layers, toolpaths);
+    }
+    
+    // Make a pretty picture, cones and spheres unroll wider than the model
+    point sheet_size = mesh->GetBBoxSize();
+    if (surface.kind != SurfaceShape::SURFACE_CYLINDER)
+    {
+        sheet_size.x = GetSheetWidth(layers);
+    }
+    if (tiles_prefix)
+    {
+        TilePyramid tiles(tile_dpi, tile_size);
+        if (!tiles.ExportTiles(layers, sheet_size, toolpaths, tiles_prefix))
+        {
+            return 1;
+        }
+    }
+    else if (shards == 0)
+    {
+        slice.exportGIV(layers, sheet_size, toolpaths, giv_file);
+    }
     
-    // Make a pretty picture
-    slice.exportGIV(layers, mesh->GetBBoxSize());
+    // And a compact one
+    if (binary_file)
+    {
+        LayerCodec codec(grid);
+        codec.SetShard(shard, shards, radii.size());
+        if (!codec.ExportBinary(layers, binary_file))
+        {
+            return 1;
+        }
+    }
     
+    // And one bitmap per layer
+    if (raster_prefix)
+    {
+        RasterExporter raster(dpi, raster_format);
+        if (!raster.ExportLayers(layers, raster_prefix))
+        {
+            return 1;
+        }
+    }
     printf("%d Triangles created and sliced from radius %0.2f to %0.2f with thickness %0.2f from STL file %s !!\n\n=======================================================================================================\n",(int)mesh->GetMeshSize(),start_radius, radius, thickness, FileName);
     return 0;
 }
@@ -0,0 +1,517 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef _SLICYL_H_
+#define _SLICYL_H_
+
+/*
+--|-------------------------------------------------------------------------
+--| C interface of libslicyl.
+--|
+--| Load a mesh, set up a job, then run the job and get every finished
+--| layer through a callback. Nothing is printed unless a log callback is
+--| set. Meshes and jobs are separate objects, so different threads may
+--| load and slice at the same time as long as no object is changed by one
+--| thread while another uses it. A mesh may be sliced by several jobs at
+--| once. Angles are in radians.
+--|-------------------------------------------------------------------------
+*/
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define SLICYL_API __attribute__((visibility("default")))
+#else
+#define SLICYL_API
+#endif
+
+// Version of this interface, bumped whenever it changes incompatibly
+#define SLICYL_ABI_VERSION 1
+
+// Returned by slicyl_job_run and slicyl_job_slice for a job whose options
+// do not go together, such as a cone with a region
+#define SLICYL_ERROR_COMBINATION (-2)
+
+typedef struct slicyl_mesh slicyl_mesh;
+typedef struct slicyl_job slicyl_job;
+typedef struct slicyl_layers slicyl_layers;
+
+/*
+--|-------------------------------------------------------------------------
+--| One rolled out piece of a layer: its two ends as (x, arc, radius) and
+--| its length. Laid out exactly like the library's own slicepiece.
+--|-------------------------------------------------------------------------
+*/
+typedef struct slicyl_piece
+{
+    float a[3];
+    float b[3];
+    float distance;
+} slicyl_piece;
+
+/*
+--|-------------------------------------------------------------------------
+--| Gets each layer in order of radius. The pieces point into the library's
+--| own buffer and are only good until the callback returns. Return 0 to go
+--| on, anything else to stop slicing.
+--|-------------------------------------------------------------------------
+*/
+typedef int (*slicyl_layer_callback)(size_t index, float radius, const slicyl_piece* pieces, size_t count, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Gets each progress or error message, which may be part of a line
+--|-------------------------------------------------------------------------
+*/
+typedef void (*slicyl_log_callback)(const char* message, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the version of the library
+--| Args:
+--|     none
+--| Return:
+--|     const char* - The version as text
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API const char* slicyl_version(void);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the version of this interface the library was built with,
+--|     to compare with SLICYL_ABI_VERSION
+--| Args:
+--|     none
+--| Return:
+--|     int - The interface version
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_abi_version(void);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sends the messages of every mesh and job to a callback. Set it
+--|     before anything else runs.
+--| Args:
+--|     callback - Gets each progress or error message, NULL to drop them
+--|     user - Handed to the callback
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_set_log(slicyl_log_callback callback, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes an empty mesh
+--| Args:
+--|     none
+--| Return:
+--|     slicyl_mesh* - The mesh, NULL if out of memory
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API slicyl_mesh* slicyl_mesh_new(void);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Frees a mesh
+--| Args:
+--|     mesh - The mesh, may be NULL
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_mesh_free(slicyl_mesh* mesh);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds the facets of a binary or ASCII STL file
+--| Args:
+--|     mesh - The mesh
+--|     stl_file - Name of the STL file
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_mesh_load_file(slicyl_mesh* mesh, const char* stl_file);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds the facets of a binary or ASCII STL file held in memory
+--| Args:
+--|     mesh - The mesh
+--|     data - The bytes of the STL file
+--|     size - Number of bytes
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_mesh_load_memory(slicyl_mesh* mesh, const void* data, size_t size);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds triangles given as bare corners
+--| Args:
+--|     mesh - The mesh
+--|     vertices - Nine floats per triangle, x y z of each corner in turn
+--|     count - Number of triangles
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_mesh_add_triangles(slicyl_mesh* mesh, const float* vertices, size_t count);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the number of triangles in a mesh
+--| Args:
+--|     mesh - The mesh
+--| Return:
+--|     size_t - Number of triangles
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API size_t slicyl_mesh_size(const slicyl_mesh* mesh);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the corners of a mesh's bounding box
+--| Args:
+--|     mesh - The mesh
+--|     lower - Gets the smallest x, y and z
+--|     upper - Gets the largest x, y and z
+--| Return:
+--|     none, does nothing if mesh, lower or upper is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_mesh_bbox(const slicyl_mesh* mesh, float lower[3], float upper[3]);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Moves a mesh so its bounding box is centred on the origin, like
+--|     the slicyl program does before slicing
+--| Args:
+--|     mesh - The mesh
+--| Return:
+--|     none, does nothing if mesh is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_mesh_center(slicyl_mesh* mesh);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes a job slicing the whole mesh, with no radii set yet
+--| Args:
+--|     none
+--| Return:
+--|     slicyl_job* - The job, NULL if out of memory
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API slicyl_job* slicyl_job_new(void);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Frees a job
+--| Args:
+--|     job - The job, may be NULL
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_free(slicyl_job* job);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices evenly spaced layers
+--| Args:
+--|     job - The job
+--|     start_radius - Smallest radius
+--|     thickness - Distance between layers
+--|     end_radius - Largest radius
+--| Return:
+--|     int - 0 on success, -1 if thickness is not positive
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_job_set_uniform(slicyl_job* job, float start_radius, float thickness, float end_radius);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Spaces the layers to follow the mesh.
+--|     Cannot be combined with cones or spheres, slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     start_radius - Smallest radius
+--|     min_thickness - Thinnest layer
+--|     max_thickness - Thickest layer
+--|     end_radius - Largest radius
+--| Return:
+--|     int - 0 on success, -1 if the thicknesses make no sense
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_job_set_adaptive(slicyl_job* job, float start_radius, float min_thickness, float max_thickness, float end_radius);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices at exactly the given radii
+--| Args:
+--|     job - The job
+--|     radii - Slicyl radii, smallest first
+--|     count - Number of radii
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_job_set_radii(slicyl_job* job, const float* radii, size_t count);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets where the layers are cut open
+--| Args:
+--|     job - The job
+--|     angle - Angle around the x axis from +z towards +y
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_set_seam(slicyl_job* job, float angle);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses what the Slicyls are worked out in, float by default.
+--|     Double is slower but keeps large radii accurate; the pieces handed
+--|     out are float either way.
+--| Args:
+--|     job - The job
+--|     use_double - Nonzero for double, 0 for float
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_set_precision(slicyl_job* job, int use_double);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses robust predicates, off by default. Vertices on or next to a
+--|     layer are placed exactly, so neighbouring triangles always agree and
+--|     layers have no gaps or doubled pieces, for a little speed.
+--| Args:
+--|     job - The job
+--|     robust - Nonzero for robust predicates
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_set_robust(slicyl_job* job, int robust);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Cuts cones about the x axis instead of Slicyls. The radii are where
+--|     each cone crosses x = 0.
+--|     Cannot be combined with a region, a sector or adaptive radii,
+--|     slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     half_angle - Half angle of the cones in radians, the radius grows
+--|                  with x when positive
+--| Return:
+--|     int - 0 on success, -1 if the angle is not inside (-pi/2, pi/2)
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API int slicyl_job_set_cone(slicyl_job* job, float half_angle);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Cuts spheres about a centre instead of Slicyls.
+--|     Cannot be combined with a region, a sector or adaptive radii,
+--|     slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     centre - x, y and z of the centre
+--| Return:
+--|     none, does nothing if job or centre is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_set_sphere(slicyl_job* job, const float centre[3]);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Only slices between two x values.
+--|     Cannot be combined with cones or spheres, slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     x_min - Smallest x
+--|     x_max - Largest x
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_set_region(slicyl_job* job, float x_min, float x_max);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Only slices part of the way around the axis, the layers then
+--|     start at the sector.
+--|     Cannot be combined with cones or spheres, slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     start - Angle the sector starts at, measured like the seam
+--|     span - How far around the sector goes
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_job_set_sector(slicyl_job* job, float start, float span);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the radii a job would slice a mesh at
+--| Args:
+--|     job - The job
+--|     mesh - The mesh, adaptive radii depend on it
+--|     radii - Gets up to capacity radii, may be NULL
+--|     capacity - Room in radii
+--| Return:
+--|     size_t - How many radii there are, 0 for a job whose options do
+--|              not go together
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API size_t slicyl_job_get_radii(const slicyl_job* job, const slicyl_mesh* mesh, float* radii, size_t capacity);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a mesh, handing every layer to a callback as it is done
+--| Args:
+--|     job - The job
+--|     mesh - The mesh
+--|     callback - Gets each layer in order of radius
+--|     user - Handed to the callback
+--| Return:
+--|     long - How many layers were handed over, -1 on failure,
+--|            SLICYL_ERROR_COMBINATION for a job whose options do not
+--|            go together
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API long slicyl_job_run(const slicyl_job* job, const slicyl_mesh* mesh, slicyl_layer_callback callback, void* user);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a mesh in parallel and keeps every layer in a layer set,
+--|     replacing what it held before
+--| Args:
+--|     job - The job
+--|     mesh - The mesh
+--|     layers - Gets one layer per radius
+--| Return:
+--|     long - How many layers there are, -1 on failure,
+--|            SLICYL_ERROR_COMBINATION for a job whose options do not
+--|            go together
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API long slicyl_job_slice(const slicyl_job* job, const slicyl_mesh* mesh, slicyl_layers* layers);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes an empty layer set
+--| Args:
+--|     none
+--| Return:
+--|     slicyl_layers* - The layer set, NULL if out of memory
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API slicyl_layers* slicyl_layers_new(void);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Frees a layer set, along with the pieces handed out from it
+--| Args:
+--|     layers - The layer set, may be NULL
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API void slicyl_layers_free(slicyl_layers* layers);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the number of layers in a layer set
+--| Args:
+--|     layers - The layer set
+--| Return:
+--|     size_t - Number of layers
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API size_t slicyl_layers_count(const slicyl_layers* layers);
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets one layer of a layer set, as a pointer straight into the set.
+--|     It stays valid until the set is freed or sliced into again.
+--| Args:
+--|     layers - The layer set
+--|     index - Number of the layer
+--|     count - Gets the number of pieces, may be NULL
+--|     radius - Gets the radius of the layer, may be NULL
+--| Return:
+--|     const slicyl_piece* - The pieces, NULL if there are none
+--|-------------------------------------------------------------------------
+*/
+SLICYL_API const slicyl_piece* slicyl_layers_get(const slicyl_layers* layers, size_t index, size_t* count, float* radius);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //_SLICYL_H_
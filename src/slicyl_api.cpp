@@ -0,0 +1,883 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "slicyl.h"
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "TriangleMesh.h"
+#include "Slicer.h"
+#include "SlicedLayers.h"
+#include "RadiusSchedule.h"
+#include "RegionIndex.h"
+#include "Log.h"
+
+#define SLICYL_VERSION_TEXT "0.71"
+
+// Layers are handed out as they are, so the two layouts have to agree
+static_assert(sizeof(slicyl_piece) == sizeof(slicepiece), "slicyl_piece does not match slicepiece");
+static_assert(offsetof(slicyl_piece, b) == offsetof(slicepiece, b), "slicyl_piece does not match slicepiece");
+static_assert(offsetof(slicyl_piece, distance) == offsetof(slicepiece, distance), "slicyl_piece does not match slicepiece");
+
+struct slicyl_mesh
+{
+    TriangleMesh triangles;
+};
+
+struct slicyl_job
+{
+    enum Schedule
+    {
+        SCHEDULE_NONE,
+        SCHEDULE_UNIFORM,
+        SCHEDULE_ADAPTIVE,
+        SCHEDULE_LIST
+    };
+    Schedule schedule;
+    float start_radius;
+    float thickness;
+    float max_thickness;
+    float end_radius;
+    std::vector<float> radii;
+    SliceRegion region;
+    SurfaceShape::Kind surface;
+    Slicer slicer;
+    
+    slicyl_job() : schedule(SCHEDULE_NONE), start_radius(0.0f), thickness(0.0f), max_thickness(0.0f), end_radius(0.0f), surface(SurfaceShape::SURFACE_CYLINDER) {}
+};
+
+struct slicyl_layers
+{
+    SlicedLayers layers;
+};
+
+// Where a running job sends its layers
+struct LayerForward
+{
+    slicyl_layer_callback callback;
+    void* user;
+};
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Hands a finished layer on to the caller's callback, without copying
+--| Args:
+--|     index - Number of the layer
+--|     radius - Radius of the layer
+--|     layer - The slicepieces of the layer
+--|     user - The LayerForward
+--| Return:
+--|     bool - false if the caller wants to stop
+--|-------------------------------------------------------------------------
+*/
+static bool ForwardLayer(size_t index, float radius, const std::vector<slicepiece> &layer, void* user)
+{
+    const LayerForward* forward = (const LayerForward*)user;
+    const slicyl_piece* pieces = layer.empty() ? NULL : (const slicyl_piece*)&layer[0];
+    return forward->callback(index, radius, pieces, layer.size(), forward->user) == 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Checks a job only asks for what can be sliced together, the same
+--|     rule the slicyl program applies. Region clipping works in model x
+--|     and angle, and adaptive radii follow cylindrical extents, so
+--|     neither means anything on a cone or sphere.
+--| Args:
+--|     job - The job
+--| Return:
+--|     bool - false, with the reason logged, if the options clash
+--|-------------------------------------------------------------------------
+*/
+static bool CheckJob(const slicyl_job* job)
+{
+    if (job->surface != SurfaceShape::SURFACE_CYLINDER && (job->region.IsLimited() || job->schedule == slicyl_job::SCHEDULE_ADAPTIVE))
+    {
+        LogPrintf("ERROR cones and spheres cannot be used with a region, a sector or adaptive radii\n");
+        return false;
+    }
+    return true;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Works out the radii a job slices a mesh at
+--| Args:
+--|     job - The job
+--|     mesh - The mesh
+--|     radii - Gets the radii, smallest first
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+static void GetJobRadii(const slicyl_job* job, const slicyl_mesh* mesh, std::vector<float> &radii)
+{
+    radii.clear();
+    switch (job->schedule)
+    {
+    case slicyl_job::SCHEDULE_UNIFORM:
+        RadiusSchedule::Uniform(job->start_radius, job->thickness, job->end_radius, radii);
+        break;
+    case slicyl_job::SCHEDULE_ADAPTIVE:
+        RadiusSchedule(job->thickness, job->max_thickness).Adaptive(&mesh->triangles, job->start_radius, job->end_radius, radii);
+        break;
+    case slicyl_job::SCHEDULE_LIST:
+        radii = job->radii;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the version of the library
+--| Args:
+--|     none
+--| Return:
+--|     const char* - The version as text
+--|-------------------------------------------------------------------------
+*/
+const char* slicyl_version(void)
+{
+    return SLICYL_VERSION_TEXT;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the version of this interface the library was built with,
+--|     to compare with SLICYL_ABI_VERSION
+--| Args:
+--|     none
+--| Return:
+--|     int - The interface version
+--|-------------------------------------------------------------------------
+*/
+int slicyl_abi_version(void)
+{
+    return SLICYL_ABI_VERSION;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sends the messages of every mesh and job to a callback. Set it
+--|     before anything else runs.
+--| Args:
+--|     callback - Gets each progress or error message, NULL to drop them
+--|     user - Handed to the callback
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void slicyl_set_log(slicyl_log_callback callback, void* user)
+{
+    SetLogHandler((LogHandler)callback, user);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes an empty mesh
+--| Args:
+--|     none
+--| Return:
+--|     slicyl_mesh* - The mesh, NULL if out of memory
+--|-------------------------------------------------------------------------
+*/
+slicyl_mesh* slicyl_mesh_new(void)
+{
+    try
+    {
+        return new slicyl_mesh;
+    }
+    catch (...)
+    {
+        return NULL;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Frees a mesh
+--| Args:
+--|     mesh - The mesh, may be NULL
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void slicyl_mesh_free(slicyl_mesh* mesh)
+{
+    delete mesh;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds the facets of a binary or ASCII STL file
+--| Args:
+--|     mesh - The mesh
+--|     stl_file - Name of the STL file
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+int slicyl_mesh_load_file(slicyl_mesh* mesh, const char* stl_file)
+{
+    if (!mesh || !stl_file)
+    {
+        return -1;
+    }
+    try
+    {
+        return mesh->triangles.LoadSTL(stl_file) ? 0 : -1;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds the facets of a binary or ASCII STL file held in memory
+--| Args:
+--|     mesh - The mesh
+--|     data - The bytes of the STL file
+--|     size - Number of bytes
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+int slicyl_mesh_load_memory(slicyl_mesh* mesh, const void* data, size_t size)
+{
+    if (!mesh)
+    {
+        return -1;
+    }
+    try
+    {
+        return mesh->triangles.LoadSTLFromMemory((const char*)data, size) ? 0 : -1;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Adds triangles given as bare corners
+--| Args:
+--|     mesh - The mesh
+--|     vertices - Nine floats per triangle, x y z of each corner in turn
+--|     count - Number of triangles
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+int slicyl_mesh_add_triangles(slicyl_mesh* mesh, const float* vertices, size_t count)
+{
+    if (!mesh || (!vertices && count > 0))
+    {
+        return -1;
+    }
+    try
+    {
+        mesh->triangles.AddTriangles(vertices, count);
+        return 0;
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the number of triangles in a mesh
+--| Args:
+--|     mesh - The mesh
+--| Return:
+--|     size_t - Number of triangles
+--|-------------------------------------------------------------------------
+*/
+size_t slicyl_mesh_size(const slicyl_mesh* mesh)
+{
+    return mesh ? mesh->triangles.GetMeshSize() : 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the corners of a mesh's bounding box
+--| Args:
+--|     mesh - The mesh
+--|     lower - Gets the smallest x, y and z
+--|     upper - Gets the largest x, y and z
+--| Return:
+--|     none, does nothing if mesh, lower or upper is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_mesh_bbox(const slicyl_mesh* mesh, float lower[3], float upper[3])
+{
+    if (!mesh || !lower || !upper)
+    {
+        return;
+    }
+    point lo, hi;
+    mesh->triangles.GetBBox(lo, hi);
+    lower[0] = lo.x;
+    lower[1] = lo.y;
+    lower[2] = lo.z;
+    upper[0] = hi.x;
+    upper[1] = hi.y;
+    upper[2] = hi.z;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Moves a mesh so its bounding box is centred on the origin, like
+--|     the slicyl program does before slicing
+--| Args:
+--|     mesh - The mesh
+--| Return:
+--|     none, does nothing if mesh is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_mesh_center(slicyl_mesh* mesh)
+{
+    if (!mesh)
+    {
+        return;
+    }
+    mesh->triangles.BBoxMoveCOG(point(0,0,0));
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes a job slicing the whole mesh, with no radii set yet
+--| Args:
+--|     none
+--| Return:
+--|     slicyl_job* - The job, NULL if out of memory
+--|-------------------------------------------------------------------------
+*/
+slicyl_job* slicyl_job_new(void)
+{
+    try
+    {
+        return new slicyl_job;
+    }
+    catch (...)
+    {
+        return NULL;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Frees a job
+--| Args:
+--|     job - The job, may be NULL
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_free(slicyl_job* job)
+{
+    delete job;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices evenly spaced layers
+--| Args:
+--|     job - The job
+--|     start_radius - Smallest radius
+--|     thickness - Distance between layers
+--|     end_radius - Largest radius
+--| Return:
+--|     int - 0 on success, -1 if thickness is not positive
+--|-------------------------------------------------------------------------
+*/
+int slicyl_job_set_uniform(slicyl_job* job, float start_radius, float thickness, float end_radius)
+{
+    if (!job || !(thickness > 0.0f))
+    {
+        return -1;
+    }
+    job->schedule = slicyl_job::SCHEDULE_UNIFORM;
+    job->start_radius = start_radius;
+    job->thickness = thickness;
+    job->end_radius = end_radius;
+    return 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Spaces the layers to follow the mesh.
+--|     Cannot be combined with cones or spheres, slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     start_radius - Smallest radius
+--|     min_thickness - Thinnest layer
+--|     max_thickness - Thickest layer
+--|     end_radius - Largest radius
+--| Return:
+--|     int - 0 on success, -1 if the thicknesses make no sense
+--|-------------------------------------------------------------------------
+*/
+int slicyl_job_set_adaptive(slicyl_job* job, float start_radius, float min_thickness, float max_thickness, float end_radius)
+{
+    if (!job || !(min_thickness > 0.0f) || max_thickness < min_thickness)
+    {
+        return -1;
+    }
+    job->schedule = slicyl_job::SCHEDULE_ADAPTIVE;
+    job->start_radius = start_radius;
+    job->thickness = min_thickness;
+    job->max_thickness = max_thickness;
+    job->end_radius = end_radius;
+    return 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices at exactly the given radii
+--| Args:
+--|     job - The job
+--|     radii - Slicyl radii, smallest first
+--|     count - Number of radii
+--| Return:
+--|     int - 0 on success, -1 on failure
+--|-------------------------------------------------------------------------
+*/
+int slicyl_job_set_radii(slicyl_job* job, const float* radii, size_t count)
+{
+    if (!job || (!radii && count > 0))
+    {
+        return -1;
+    }
+    try
+    {
+        job->radii.assign(radii, radii + count);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+    job->schedule = slicyl_job::SCHEDULE_LIST;
+    return 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Sets where the layers are cut open
+--| Args:
+--|     job - The job
+--|     angle - Angle around the x axis from +z towards +y
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_set_seam(slicyl_job* job, float angle)
+{
+    if (!job)
+    {
+        return;
+    }
+    job->slicer.SetSeamAngle(angle);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses what the Slicyls are worked out in, float by default.
+--|     Double is slower but keeps large radii accurate; the pieces handed
+--|     out are float either way.
+--| Args:
+--|     job - The job
+--|     use_double - Nonzero for double, 0 for float
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_set_precision(slicyl_job* job, int use_double)
+{
+    if (!job)
+    {
+        return;
+    }
+    job->slicer.SetPrecision(use_double ? Slicer::PRECISION_DOUBLE : Slicer::PRECISION_FLOAT);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Chooses robust predicates, off by default. Vertices on or next to a
+--|     layer are placed exactly, so neighbouring triangles always agree and
+--|     layers have no gaps or doubled pieces, for a little speed.
+--| Args:
+--|     job - The job
+--|     robust - Nonzero for robust predicates
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_set_robust(slicyl_job* job, int robust)
+{
+    if (!job)
+    {
+        return;
+    }
+    job->slicer.SetRobust(robust != 0);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Cuts cones about the x axis instead of Slicyls. The radii are where
+--|     each cone crosses x = 0.
+--|     Cannot be combined with a region, a sector or adaptive radii,
+--|     slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     half_angle - Half angle of the cones in radians, the radius grows
+--|                  with x when positive
+--| Return:
+--|     int - 0 on success, -1 if the angle is not inside (-pi/2, pi/2)
+--|-------------------------------------------------------------------------
+*/
+int slicyl_job_set_cone(slicyl_job* job, float half_angle)
+{
+    if (!job || !(fabsf(half_angle) < 1.57079632679489661923f))
+    {
+        return -1;
+    }
+    SurfaceShape shape;
+    shape.kind = SurfaceShape::SURFACE_CONE;
+    shape.half_angle = half_angle;
+    job->slicer.SetSurface(shape);
+    job->surface = shape.kind;
+    return 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Cuts spheres about a centre instead of Slicyls.
+--|     Cannot be combined with a region, a sector or adaptive radii,
+--|     slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     centre - x, y and z of the centre
+--| Return:
+--|     none, does nothing if job or centre is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_set_sphere(slicyl_job* job, const float centre[3])
+{
+    if (!job || !centre)
+    {
+        return;
+    }
+    SurfaceShape shape;
+    shape.kind = SurfaceShape::SURFACE_SPHERE;
+    shape.centre = point(centre[0], centre[1], centre[2]);
+    job->slicer.SetSurface(shape);
+    job->surface = shape.kind;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Only slices between two x values.
+--|     Cannot be combined with cones or spheres, slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     x_min - Smallest x
+--|     x_max - Largest x
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_set_region(slicyl_job* job, float x_min, float x_max)
+{
+    if (!job)
+    {
+        return;
+    }
+    job->region.x_min = x_min;
+    job->region.x_max = x_max;
+    job->slicer.SetRegion(job->region);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Only slices part of the way around the axis, the layers then
+--|     start at the sector.
+--|     Cannot be combined with cones or spheres, slicing such a job fails.
+--| Args:
+--|     job - The job
+--|     start - Angle the sector starts at, measured like the seam
+--|     span - How far around the sector goes
+--| Return:
+--|     none, does nothing if job is NULL
+--|-------------------------------------------------------------------------
+*/
+void slicyl_job_set_sector(slicyl_job* job, float start, float span)
+{
+    if (!job)
+    {
+        return;
+    }
+    job->region.angle_start = start;
+    job->region.angle_span = span;
+    job->slicer.SetRegion(job->region);
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the radii a job would slice a mesh at
+--| Args:
+--|     job - The job
+--|     mesh - The mesh, adaptive radii depend on it
+--|     radii - Gets up to capacity radii, may be NULL
+--|     capacity - Room in radii
+--| Return:
+--|     size_t - How many radii there are, 0 for a job whose options do
+--|              not go together
+--|-------------------------------------------------------------------------
+*/
+size_t slicyl_job_get_radii(const slicyl_job* job, const slicyl_mesh* mesh, float* radii, size_t capacity)
+{
+    if (!job || !mesh || !CheckJob(job))
+    {
+        return 0;
+    }
+    try
+    {
+        std::vector<float> all;
+        GetJobRadii(job, mesh, all);
+        for (size_t i = 0; i < all.size() && i < capacity && radii; i++)
+        {
+            radii[i] = all[i];
+        }
+        return all.size();
+    }
+    catch (...)
+    {
+        return 0;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a mesh, handing every layer to a callback as it is done
+--| Args:
+--|     job - The job
+--|     mesh - The mesh
+--|     callback - Gets each layer in order of radius
+--|     user - Handed to the callback
+--| Return:
+--|     long - How many layers were handed over, -1 on failure,
+--|            SLICYL_ERROR_COMBINATION for a job whose options do not
+--|            go together
+--|-------------------------------------------------------------------------
+*/
+long slicyl_job_run(const slicyl_job* job, const slicyl_mesh* mesh, slicyl_layer_callback callback, void* user)
+{
+    if (!job || !mesh || !callback)
+    {
+        return -1;
+    }
+    if (!CheckJob(job))
+    {
+        return SLICYL_ERROR_COMBINATION;
+    }
+    try
+    {
+        std::vector<float> radii;
+        GetJobRadii(job, mesh, radii);
+        LayerForward forward = {callback, user};
+        return (long)job->slicer.SliceStream(&mesh->triangles, radii, ForwardLayer, &forward);
+    }
+    catch (...)
+    {
+        return -1;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Slices a mesh in parallel and keeps every layer in a layer set,
+--|     replacing what it held before
+--| Args:
+--|     job - The job
+--|     mesh - The mesh
+--|     layers - Gets one layer per radius
+--| Return:
+--|     long - How many layers there are, -1 on failure,
+--|            SLICYL_ERROR_COMBINATION for a job whose options do not
+--|            go together
+--|-------------------------------------------------------------------------
+*/
+long slicyl_job_slice(const slicyl_job* job, const slicyl_mesh* mesh, slicyl_layers* layers)
+{
+    if (!job || !mesh || !layers)
+    {
+        return -1;
+    }
+    if (!CheckJob(job))
+    {
+        return SLICYL_ERROR_COMBINATION;
+    }
+    try
+    {
+        std::vector<float> radii;
+        GetJobRadii(job, mesh, radii);
+        layers->layers = SlicedLayers();
+        job->slicer.SliceProgressive(&mesh->triangles, &layers->layers, radii, NULL, NULL);
+        return (long)layers->layers.GetSize();
+    }
+    catch (...)
+    {
+        layers->layers = SlicedLayers();
+        return -1;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Makes an empty layer set
+--| Args:
+--|     none
+--| Return:
+--|     slicyl_layers* - The layer set, NULL if out of memory
+--|-------------------------------------------------------------------------
+*/
+slicyl_layers* slicyl_layers_new(void)
+{
+    try
+    {
+        return new slicyl_layers;
+    }
+    catch (...)
+    {
+        return NULL;
+    }
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Frees a layer set, along with the pieces handed out from it
+--| Args:
+--|     layers - The layer set, may be NULL
+--| Return:
+--|     none
+--|-------------------------------------------------------------------------
+*/
+void slicyl_layers_free(slicyl_layers* layers)
+{
+    delete layers;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets the number of layers in a layer set
+--| Args:
+--|     layers - The layer set
+--| Return:
+--|     size_t - Number of layers
+--|-------------------------------------------------------------------------
+*/
+size_t slicyl_layers_count(const slicyl_layers* layers)
+{
+    return layers ? layers->layers.GetSize() : 0;
+}
+
+/*
+--|-------------------------------------------------------------------------
+--| Purpose:
+--|     Gets one layer of a layer set, as a pointer straight into the set.
+--|     It stays valid until the set is freed or sliced into again.
+--| Args:
+--|     layers - The layer set
+--|     index - Number of the layer
+--|     count - Gets the number of pieces, may be NULL
+--|     radius - Gets the radius of the layer, may be NULL
+--| Return:
+--|     const slicyl_piece* - The pieces, NULL if there are none
+--|-------------------------------------------------------------------------
+*/
+const slicyl_piece* slicyl_layers_get(const slicyl_layers* layers, size_t index, size_t* count, float* radius)
+{
+    if (count)
+    {
+        *count = 0;
+    }
+    if (radius)
+    {
+        *radius = 0.0f;
+    }
+    if (!layers || index >= layers->layers.GetSize() || !layers->layers.HasLayer((int)index))
+    {
+        return NULL;
+    }
+    const std::vector<slicepiece> &layer = layers->layers.GetLayer((int)index);
+    if (count)
+    {
+        *count = layer.size();
+    }
+    if (radius)
+    {
+        *radius = layers->layers.GetLayerRadius((int)index);
+    }
+    return layer.empty() ? NULL : (const slicyl_piece*)&layer[0];
+}
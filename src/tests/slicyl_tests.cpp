@@ -0,0 +1,465 @@
+/***************************************************************************
+The MIT License
+
+Copyright (c) 2017 Kyle Ruan
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+// make test runs this as: cd tests && ./slicyl_tests ../slicyl ../../stl/block100.stl
+// Every check that fails is printed, the exit status is 1 if any did.
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "LayerCodec.h"
+#include "SlicedLayers.h"
+#include "WorkPool.h"
+#include "Log.h"
+#include "slicyl.h"
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) Check((cond), #cond, __FILE__, __LINE__)
+
+static void Check(bool ok, const char* what, const char* file, int line)
+{
+    checks++;
+    if (!ok)
+    {
+        failures++;
+        printf("FAILED %s:%d: %s\n", file, line, what);
+    }
+}
+
+// Scratch directory the files of every test go into
+static std::string scratch;
+
+static std::string Scratch(const char* name)
+{
+    return scratch + "/" + name;
+}
+
+// The library's messages, so rejections can be told apart
+static std::string logged;
+
+static void KeepLog(const char* message, void* user)
+{
+    logged += message;
+}
+
+static std::vector<unsigned char> ReadFile(const std::string &name)
+{
+    std::vector<unsigned char> data;
+    FILE* f = fopen(name.c_str(), "rb");
+    if (f == NULL)
+    {
+        return data;
+    }
+    unsigned char chunk[4096];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + got);
+    }
+    fclose(f);
+    return data;
+}
+
+static void WriteFile(const std::string &name, const std::vector<unsigned char> &data)
+{
+    FILE* f = fopen(name.c_str(), "wb");
+    if (f != NULL)
+    {
+        fwrite(data.data(), 1, data.size(), f);
+        fclose(f);
+    }
+}
+
+static void PutWord(std::vector<unsigned char> &data, size_t at, uint32_t value)
+{
+    memcpy(&data[at], &value, sizeof(value));
+}
+
+static uint32_t GetWord(const std::vector<unsigned char> &data, size_t at)
+{
+    uint32_t value;
+    memcpy(&value, &data[at], sizeof(value));
+    return value;
+}
+
+// A few layers of contours and loose pieces, one of them empty
+static void MakeLayers(SlicedLayers &layers)
+{
+    srand(7);
+    for (int l = 0; l < 6; l++)
+    {
+        std::vector<slicepiece> layer;
+        float radius = 1.5f + l;
+        size_t pieces = (l == 3) ? 0 : 50 + 40 * l;
+        point a(0, 0, radius);
+        for (size_t i = 0; i < pieces; i++)
+        {
+            // Mostly chained like a contour, sometimes starting elsewhere
+            if (rand() % 5 == 0)
+            {
+                a = point(rand() / (float)RAND_MAX * 100 - 50, rand() / (float)RAND_MAX * 100 - 50, radius);
+            }
+            point b(a.x + rand() / (float)RAND_MAX * 2 - 1, a.y + rand() / (float)RAND_MAX * 2 - 1, radius);
+            layer.push_back(slicepiece(a, b, 0));
+            a = b;
+        }
+        layers.AddLayer(layer, radius);
+    }
+}
+
+static void TestCodecRoundTrip()
+{
+    const float grid = 0.001f;
+    SlicedLayers layers;
+    MakeLayers(layers);
+    LayerCodec codec(grid);
+    std::string name = Scratch("round.slc");
+    CHECK(codec.ExportBinary(&layers, name.c_str()));
+
+    SlicedLayers back;
+    LayerCodec reader;
+    CHECK(reader.ImportBinary(name.c_str(), &back));
+    CHECK(reader.GetGrid() == grid);
+    CHECK(back.GetSize() == layers.GetSize());
+    if (back.GetSize() != layers.GetSize())
+    {
+        return;
+    }
+
+    // Every end lands on the nearest grid point, off by half a step at most
+    // plus what float keeps of coordinates up to 51
+    const float tolerance = grid / 2 + 1e-5f;
+    float worst = 0;
+    bool same_counts = true;
+    bool same_radii = true;
+    for (size_t l = 0; l < layers.GetSize(); l++)
+    {
+        const std::vector<slicepiece> &in = layers.GetLayer(l);
+        const std::vector<slicepiece> &out = back.GetLayer(l);
+        same_radii = same_radii && back.GetLayerRadius(l) == layers.GetLayerRadius(l);
+        if (in.size() != out.size())
+        {
+            same_counts = false;
+            continue;
+        }
+        for (size_t i = 0; i < in.size(); i++)
+        {
+            worst = std::max(worst, std::fabs(in[i].a.x - out[i].a.x));
+            worst = std::max(worst, std::fabs(in[i].a.y - out[i].a.y));
+            worst = std::max(worst, std::fabs(in[i].b.x - out[i].b.x));
+            worst = std::max(worst, std::fabs(in[i].b.y - out[i].b.y));
+            same_radii = same_radii && out[i].a.z == in[i].a.z && out[i].b.z == in[i].b.z;
+        }
+    }
+    CHECK(same_counts);
+    CHECK(same_radii);
+    CHECK(worst <= tolerance);
+
+    // Shards say which share of the job they hold
+    codec.SetShard(2, 3, 17);
+    CHECK(codec.ExportBinary(&layers, name.c_str()));
+    unsigned int shard, shards;
+    size_t job_layers;
+    CHECK(reader.ImportBinary(name.c_str(), &back));
+    CHECK(reader.GetShard(shard, shards, job_layers));
+    CHECK(shard == 2 && shards == 3 && job_layers == 17);
+}
+
+// Imports a changed copy of a good file, expecting it to be turned down
+// with an error naming the problem
+static bool Rejected(const std::vector<unsigned char> &data, const char* reason)
+{
+    std::string name = Scratch("bad.slc");
+    WriteFile(name, data);
+    SlicedLayers layers;
+    LayerCodec codec;
+    logged.clear();
+    bool rejected = !codec.ImportBinary(name.c_str(), &layers) && logged.find(reason) != std::string::npos;
+    if (!rejected)
+    {
+        printf("Expected \"%s\", the library said: %s\n", reason, logged.c_str());
+    }
+    return rejected;
+}
+
+static void TestCorruptRecords()
+{
+    SlicedLayers layers;
+    MakeLayers(layers);
+    LayerCodec codec;
+    std::string name = Scratch("good.slc");
+    CHECK(codec.ExportBinary(&layers, name.c_str()));
+    const std::vector<unsigned char> good = ReadFile(name);
+    CHECK(good.size() > 28);
+    if (good.size() <= 28)
+    {
+        return;
+    }
+
+    // Whole jobs are "SLCY", version, grid, then index, radius, pieces, bytes
+    const size_t first = 12;
+    const size_t second = first + 16 + GetWord(good, first + 12);
+    std::vector<unsigned char> bad;
+
+    bad = good;
+    PutWord(bad, first, 0xFFFFFFFFu);
+    CHECK(Rejected(bad, "past the"));
+
+    bad = good;
+    PutWord(bad, first, 0x7FFFFFF0u);
+    CHECK(Rejected(bad, "past the"));
+
+    bad = good;
+    PutWord(bad, second, GetWord(good, first));
+    CHECK(Rejected(bad, "more than once"));
+
+    bad = good;
+    PutWord(bad, first + 8, 0x7FFFFFFFu);
+    CHECK(Rejected(bad, "pieces in"));
+
+    bad = good;
+    bad.resize(second + 10);
+    CHECK(Rejected(bad, "truncated"));
+
+    // And the untouched file still reads
+    SlicedLayers back;
+    CHECK(codec.ImportBinary(name.c_str(), &back));
+}
+
+// Runs the slicyl program in the scratch directory
+static int Run(const std::string &slicyl, const std::string &args)
+{
+    std::string command = "cd " + scratch + " && " + slicyl + " " + args + " > slicyl.log 2>&1";
+    int status = system(command.c_str());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void TestMergeShards(const std::string &slicyl, const std::string &stl)
+{
+    const std::string job = stl + " 0 2 80";
+    CHECK(Run(slicyl, job + " --binary whole.slc") == 0);
+    CHECK(Run(slicyl, job + " --shard 1/2 --binary part1.slc") == 0);
+    CHECK(Run(slicyl, job + " --shard 2/2 --binary part2.slc") == 0);
+
+    // In either order, the merge is the whole job's file byte for byte
+    CHECK(Run(slicyl, "merge merged.slc part2.slc part1.slc") == 0);
+    std::vector<unsigned char> whole = ReadFile(Scratch("whole.slc"));
+    CHECK(!whole.empty());
+    CHECK(ReadFile(Scratch("merged.slc")) == whole);
+
+    // A missing shard or one given twice is an error
+    CHECK(Run(slicyl, "merge broken.slc part1.slc") != 0);
+    CHECK(Run(slicyl, "merge broken.slc part1.slc part1.slc") != 0);
+    CHECK(access(Scratch("broken.slc").c_str(), F_OK) != 0);
+}
+
+// Counts every index of nested loops run on and off the workers
+static void TestWorkPool()
+{
+    WorkPool pool(4);
+    std::atomic<long> sum(0);
+    for (int round = 0; round < 100; round++)
+    {
+        for (int job = 0; job < 8; job++)
+        {
+            pool.Submit([&]()
+            {
+                WorkPool::GetCurrent()->ForEach(40, [&](size_t i)
+                {
+                    WorkPool::GetCurrent()->ForEach(i % 9, [&](size_t k) { sum++; });
+                });
+            });
+        }
+        pool.Wait();
+    }
+    long expected = 0;
+    for (size_t i = 0; i < 40; i++)
+    {
+        expected += i % 9;
+    }
+    CHECK(sum == 100 * 8 * expected);
+
+    sum = 0;
+    pool.ForEach(1000, [&](size_t i) { sum += i; });
+    pool.ForEach(0, [&](size_t i) { sum = -1; });
+    CHECK(sum == 999 * 1000 / 2);
+}
+
+// Octahedron with two corners at radius 10, turned about the x axis so
+// those corners land on or right next to the layer through them in float.
+// Each face of a corner meets the layer there, or is tangent to it.
+static slicyl_mesh* MakeOctahedron(double angle, float &radius)
+{
+    const double corners[6][3] = { { 2, 0, 10 }, { -2, 0, 10 }, { 0, 2, 10 }, { 0, -2, 10 }, { 0, 0, 8 }, { 0, 0, 12 } };
+    const int faces[8][3] = { { 0, 2, 4 }, { 2, 1, 4 }, { 1, 3, 4 }, { 3, 0, 4 }, { 2, 0, 5 }, { 1, 2, 5 }, { 3, 1, 5 }, { 0, 3, 5 } };
+    float c[6][3];
+    for (int v = 0; v < 6; v++)
+    {
+        c[v][0] = (float)corners[v][0];
+        c[v][1] = (float)(corners[v][1] * cos(angle) - corners[v][2] * sin(angle));
+        c[v][2] = (float)(corners[v][1] * sin(angle) + corners[v][2] * cos(angle));
+    }
+    radius = (float)sqrt((double)c[0][1] * c[0][1] + (double)c[0][2] * c[0][2]);
+
+    float vertices[8 * 9];
+    for (int f = 0; f < 8; f++)
+    {
+        for (int v = 0; v < 3; v++)
+        {
+            memcpy(&vertices[f * 9 + v * 3], c[faces[f][v]], 3 * sizeof(float));
+        }
+    }
+    slicyl_mesh* mesh = slicyl_mesh_new();
+    slicyl_mesh_add_triangles(mesh, vertices, 8);
+    return mesh;
+}
+
+// Whether the pieces leave no gap: leaving out pieces of no length, every
+// end meets an odd number of other ends, so the pieces can be walked in
+// closed loops. A face tangent to the layer may add a loop of its own.
+static bool NoGaps(const slicyl_piece* pieces, size_t count)
+{
+    std::vector<const float*> ends;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (pieces[i].a[0] != pieces[i].b[0] || pieces[i].a[1] != pieces[i].b[1])
+        {
+            ends.push_back(pieces[i].a);
+            ends.push_back(pieces[i].b);
+        }
+    }
+    if (ends.size() < 6)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < ends.size(); i++)
+    {
+        int meets = 0;
+        for (size_t j = 0; j < ends.size(); j++)
+        {
+            if (j / 2 != i / 2 && ends[i][0] == ends[j][0] && ends[i][1] == ends[j][1])
+            {
+                meets++;
+            }
+        }
+        if (meets % 2 == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestVerticesOnLayer()
+{
+    // Turned between a quarter and three quarters of the way round, keeping
+    // the octahedron clear of the seam
+    int gaps[2] = { 0, 0 };
+    for (int turn = 0; turn < 200; turn++)
+    {
+        float radius;
+        slicyl_mesh* mesh = MakeOctahedron(M_PI * (0.5 + turn / 200.0), radius);
+        for (int use_double = 0; use_double < 2; use_double++)
+        {
+            slicyl_job* job = slicyl_job_new();
+            slicyl_job_set_radii(job, &radius, 1);
+            slicyl_job_set_robust(job, 1);
+            slicyl_job_set_precision(job, use_double);
+            slicyl_layers* layers = slicyl_layers_new();
+            size_t count = 0;
+            const slicyl_piece* pieces = NULL;
+            if (slicyl_job_slice(job, mesh, layers) == 1)
+            {
+                pieces = slicyl_layers_get(layers, 0, &count, NULL);
+            }
+            if (!NoGaps(pieces, count))
+            {
+                gaps[use_double]++;
+            }
+            slicyl_layers_free(layers);
+            slicyl_job_free(job);
+        }
+        slicyl_mesh_free(mesh);
+    }
+    CHECK(gaps[0] == 0);
+    CHECK(gaps[1] == 0);
+
+    // Cones and spheres do not go with a region
+    float radius;
+    slicyl_mesh* mesh = MakeOctahedron(M_PI, radius);
+    slicyl_job* job = slicyl_job_new();
+    const float centre[3] = { 0, 0, 0 };
+    slicyl_job_set_uniform(job, 9, 1, 11);
+    slicyl_job_set_sphere(job, centre);
+    slicyl_job_set_region(job, -1, 1);
+    slicyl_layers* layers = slicyl_layers_new();
+    CHECK(slicyl_job_slice(job, mesh, layers) == SLICYL_ERROR_COMBINATION);
+    slicyl_layers_free(layers);
+    slicyl_job_free(job);
+    slicyl_mesh_free(mesh);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        printf("Usage: ./slicyl_tests path/to/slicyl path/to/block100.stl\n");
+        return 1;
+    }
+    char* cwd = getcwd(NULL, 0);
+    std::string slicyl = argv[1][0] == '/' ? argv[1] : std::string(cwd) + "/" + argv[1];
+    std::string stl = argv[2][0] == '/' ? argv[2] : std::string(cwd) + "/" + argv[2];
+    free(cwd);
+
+    char dir[] = "/tmp/slicyl_tests.XXXXXX";
+    if (mkdtemp(dir) == NULL)
+    {
+        printf("ERROR could not make a scratch directory!\n");
+        return 1;
+    }
+    scratch = dir;
+    SetLogHandler(KeepLog, NULL);
+
+    TestCodecRoundTrip();
+    TestCorruptRecords();
+    TestMergeShards(slicyl, stl);
+    TestWorkPool();
+    TestVerticesOnLayer();
+
+    std::string cleanup = "rm -rf " + scratch;
+    if (system(cleanup.c_str()) != 0)
+    {
+        printf("Could not remove %s\n", scratch.c_str());
+    }
+    printf("%d of %d checks passed\n", checks - failures, checks);
+    return failures == 0 ? 0 : 1;
+}